@@ -21,15 +21,164 @@
  * lib_sxs.
  */
 
+/* accept4() is only declared by glibc for GNU sources, and
+ * sendfile64() for large file sources. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+#if defined(__linux__) && !defined(_LARGEFILE64_SOURCE)
+    #define _LARGEFILE64_SOURCE
+#endif
+
 #include "sxs.h"
+#include "sxs_poll.h"
+#include "sxs_timer.h"
+#include "sxs_internal.h"
 #include "sxs_config.h"
 
+#if defined(__linux__)
+    #include <sys/sendfile.h>
+#elif defined(WIN32)
+    #include <io.h>
+#endif
+
+/* The number of submission queue entries of the rings created by the
+ * io_uring engine when sxs_init_ex() is not given a number. */
+#define SXS_URING_DEFAULT_ENTRIES 64
+
+static int sxs_active_engine = SXS_ENGINE_DEFAULT;
+
+/* accept4() can only be handed the socket type flags when they are the
+ * system's own. */
+#if defined(HAVE_ACCEPT4) && !defined(SXS_SOCK_FLAGS_EMULATED)
+    #define SXS_ACCEPT4 1
+#endif
+
+/* The batched datagram functions fall back to a datagram per system
+ * call where sendmmsg() and recvmmsg() are not available. */
+#if defined(HAVE_SENDMMSG) && defined(HAVE_RECVMMSG) && \
+    defined(MSG_WAITFORONE)
+    #define SXS_MMSG 1
+#endif
+
+/* The number of datagrams handed to a single sendmmsg or recvmmsg. */
+#define SXS_MMSG_BATCH 64
+
+/* The size of the chunks sxs_sendfile() reads and sends on systems
+ * without a sendfile() system call. */
+#define SXS_SENDFILE_CHUNK 16384
+
+/* Whether the file offset 'off', converted from the sxs_uint64_t
+ * 'offset', holds it unchanged, as it does not when the file offset type
+ * of the system is narrower or 'offset' is past its largest value. */
+#define SXS_OFF_FITS(off, offset) \
+    (((off) >= 0) && ((sxs_uint64_t)(off) == (offset)))
+
+/* sxs_recv_to_file() moves data through a pipe with splice() where
+ * available, asking for a pipe of SXS_RECV_TO_FILE_PIPE_SIZE bytes, and
+ * otherwise receives and writes it in SXS_RECV_TO_FILE_CHUNK chunks. */
+#if defined(__linux__) && defined(SPLICE_F_MOVE)
+    #define SXS_SPLICE 1
+#endif
+#define SXS_RECV_TO_FILE_PIPE_SIZE 262144
+#define SXS_RECV_TO_FILE_CHUNK 16384
+
+#if defined(SXS_SOCK_FLAGS_EMULATED) || !defined(SXS_ACCEPT4)
+/* Apply SXS_SOCK_NONBLOCK and SXS_SOCK_CLOEXEC to a socket after the
+ * fact, for systems where socket() or accept() can not do it. */
+static sxs_error_t sxs_sock_flags_apply(sxs_socket_t sd, int flags) {
+#ifdef WIN32
+    u_long mode;
+
+    if (flags & SXS_SOCK_NONBLOCK) {
+        mode = 1;
+        if (ioctlsocket(sd, FIONBIO, &mode) == SXS_SOCKET_ERROR) {
+            return sxs_map_errno(WSAGetLastError());
+        }
+    }
+#else
+    int fl;
+
+    if (flags & SXS_SOCK_CLOEXEC) {
+        if (fcntl(sd, F_SETFD, FD_CLOEXEC) == -1) {
+            return sxs_map_errno(errno);
+        }
+    }
+
+    if (flags & SXS_SOCK_NONBLOCK) {
+        fl = fcntl(sd, F_GETFL, 0);
+        if ((fl == -1) || (fcntl(sd, F_SETFL, (fl | O_NONBLOCK)) == -1)) {
+            return sxs_map_errno(errno);
+        }
+    }
+#endif
+
+    return SXS_SUCCESS;
+}
+#endif
+
+/* Fill in the time left until the given monotonic deadline, which is
+ * zero once it has passed so that a last wait does not block. */
+static void sxs_deadline_timeout(sxs_uint64_t deadline_ms,
+    struct timeval *p_timeout) {
+
+    sxs_uint64_t now_ms;
+    sxs_uint64_t left_ms;
+
+    now_ms = sxs_monotonic_ms();
+    left_ms = (deadline_ms > now_ms) ? (deadline_ms - now_ms) : 0;
+    p_timeout->tv_sec = (long)(left_ms / 1000);
+    p_timeout->tv_usec = (long)((left_ms % 1000) * 1000);
+}
+
+/* Move the position given by the index of a buffer of a scatter/gather
+ * array and the offset into it forward by 'n' bytes, skipping buffers
+ * that are empty so that the position never rests at the end of one. */
+static void sxs_iov_advance(const sxs_iovec_t *p_iov, int iovcnt,
+    int *p_idx, sxs_size_t *p_off, sxs_size_t n) {
+
+    sxs_size_t left;
+
+    while ((*p_idx) < iovcnt) {
+        left = (sxs_size_t)SXS_IOV_LEN(p_iov[*p_idx]) - (*p_off);
+        if (n < left) {
+            (*p_off) = (*p_off) + n;
+            return;
+        }
+        n = n - left;
+        (*p_idx) = (*p_idx) + 1;
+        (*p_off) = 0;
+    }
+}
+
 sxs_error_t sxs_init(void) {
+    return sxs_init_ex(NULL);
+}
+
+sxs_error_t sxs_init_ex(const sxs_init_opts_t *p_opts) {
+    unsigned int entries;
+    sxs_error_t reterr;
 #ifdef WIN32
     WORD wVersionRequested;
     WSADATA wsaData;
     sxs_errno_t errsv;
+#endif
+
+    if ((p_opts != NULL) && (p_opts->engine != SXS_ENGINE_DEFAULT) &&
+        (p_opts->engine != SXS_ENGINE_URING)) {
+        return SXS_EINVAL;
+    }
+
+    if (p_opts != NULL) {
+        reterr = sxs_mem_policy(p_opts->mem_flags, p_opts->mem_node);
+    } else {
+        reterr = sxs_mem_policy(0, 0);
+    }
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
 
+#ifdef WIN32
     wVersionRequested = MAKEWORD(2,0);
     errsv = WSAStartup(wVersionRequested, &wsaData);
     if (errsv != 0) {
@@ -49,13 +198,37 @@ sxs_error_t sxs_init(void) {
     }
 #endif
 
+    sxs_active_engine = SXS_ENGINE_DEFAULT;
+    if ((p_opts != NULL) && (p_opts->engine == SXS_ENGINE_URING)) {
+        entries = p_opts->uring_entries;
+        if (entries == 0) {
+            entries = SXS_URING_DEFAULT_ENTRIES;
+        }
+        /* Fall back to the default engine if io_uring is unusable. */
+        if (sxs_uring_engine_init(entries) == SXS_SUCCESS) {
+            sxs_active_engine = SXS_ENGINE_URING;
+        }
+    }
+
     return SXS_SUCCESS;
 }
 
+int sxs_engine(void) {
+    return sxs_active_engine;
+}
+
 sxs_error_t sxs_uninit(void) {
 #ifdef WIN32
     sxs_errno_t errsv;
+#endif
+
+    if (sxs_active_engine == SXS_ENGINE_URING) {
+        sxs_uring_engine_uninit();
+        sxs_active_engine = SXS_ENGINE_DEFAULT;
+    }
+    sxs_mem_policy(0, 0);
 
+#ifdef WIN32
     if (WSACleanup() == SXS_SOCKET_ERROR) {
         errsv = WSAGetLastError();
         if (errsv == WSANOTINITIALISED) {
@@ -78,6 +251,13 @@ sxs_error_t sxs_socket(int domain, int type, int protocol,
 
     sxs_socket_t sd;
     sxs_errno_t errsv;
+#ifdef SXS_SOCK_FLAGS_EMULATED
+    sxs_error_t reterr;
+    int flags;
+
+    flags = type & (SXS_SOCK_NONBLOCK | SXS_SOCK_CLOEXEC);
+    type = type & (~flags);
+#endif
 
     sd = socket(domain, type, protocol);
     if (sd == SXS_INVALID_SOCKET) {
@@ -130,6 +310,14 @@ sxs_error_t sxs_socket(int domain, int type, int protocol,
 #endif
     }
 
+#ifdef SXS_SOCK_FLAGS_EMULATED
+    reterr = sxs_sock_flags_apply(sd, flags);
+    if (reterr != SXS_SUCCESS) {
+        sxs_close(sd);
+        return reterr;
+    }
+#endif
+
     (*p_sd) = sd;
     return SXS_SUCCESS;
 }
@@ -266,10 +454,27 @@ sxs_error_t sxs_listen(sxs_socket_t sd, int backlog) {
 sxs_error_t sxs_accept(sxs_socket_t sd, sxs_sockaddr_t *addr,
     sxs_socklen_t *addrlen, sxs_socket_t *p_sd) {
 
+    return sxs_accept4(sd, addr, addrlen, 0, p_sd);
+}
+
+sxs_error_t sxs_accept4(sxs_socket_t sd, sxs_sockaddr_t *addr,
+    sxs_socklen_t *addrlen, int flags, sxs_socket_t *p_sd) {
+
     sxs_socket_t connsd;
     sxs_errno_t errsv;
+#ifndef SXS_ACCEPT4
+    sxs_error_t reterr;
+#endif
+
+    if ((flags & (~(SXS_SOCK_NONBLOCK | SXS_SOCK_CLOEXEC))) != 0) {
+        return SXS_EINVAL;
+    }
 
+#ifdef SXS_ACCEPT4
+    connsd = accept4(sd, addr, addrlen, flags);
+#else
     connsd = accept(sd, addr, addrlen);
+#endif
     if (connsd == SXS_INVALID_SOCKET) {
 #ifdef WIN32
         errsv = WSAGetLastError();
@@ -340,6 +545,16 @@ sxs_error_t sxs_accept(sxs_socket_t sd, sxs_sockaddr_t *addr,
 #endif
     }
 
+#ifndef SXS_ACCEPT4
+    if (flags != 0) {
+        reterr = sxs_sock_flags_apply(connsd, flags);
+        if (reterr != SXS_SUCCESS) {
+            sxs_close(connsd);
+            return reterr;
+        }
+    }
+#endif
+
     (*p_sd) = connsd;
 
     return SXS_SUCCESS;
@@ -454,14 +669,12 @@ sxs_error_t sxs_connect_nb(sxs_socket_t sd, const sxs_sockaddr_t *serv_addr,
     sxs_socklen_t addrlen, const struct timeval *p_timeout) {
 
     sxs_error_t reterr;
-    struct timeval timeout;
-    fd_set sendfds;
-    int num_ready;
+    int revents;
     int connected_flag;
     sxs_socklen_t connected_flag_size;
     sxs_errno_t errsv;
 
-    num_ready = 0;
+    revents = 0;
     connected_flag_size = sizeof(connected_flag);
 
     /* Set the socket to non-blocknig I/O mode */
@@ -475,16 +688,10 @@ sxs_error_t sxs_connect_nb(sxs_socket_t sd, const sxs_sockaddr_t *serv_addr,
     reterr = sxs_connect(sd, serv_addr, addrlen);
     if (reterr != SXS_SUCCESS) {
         if (reterr == SXS_EINPROGRESS) {    /* not connected yet */
-            timeout.tv_sec = p_timeout->tv_sec;
-            timeout.tv_usec = p_timeout->tv_usec;
-            FD_ZERO(&sendfds);
-            FD_SET(sd, &sendfds);
-
             /* Wait for connection process to succeed or fail */
-            reterr = sxs_select((sd + 1), NULL, &sendfds, NULL, &timeout,
-                &num_ready);
+            reterr = sxs_poll_one(sd, SXS_POLLOUT, p_timeout, &revents);
             if (reterr != SXS_SUCCESS) {
-                sxs_perror("sxs_connect_nb: sxs_select:", reterr);
+                sxs_perror("sxs_connect_nb: sxs_poll_one:", reterr);
                 reterr = sxs_set_nonblock(sd, 0);
                 if (reterr != SXS_SUCCESS) {
                     sxs_perror("sxs_connect_nb: sxs_set_nonblock:", reterr);
@@ -501,7 +708,7 @@ sxs_error_t sxs_connect_nb(sxs_socket_t sd, const sxs_sockaddr_t *serv_addr,
             }
 
             /* Check if the connection process timedout out or completed */
-            if (num_ready == 0) { /* timeout reached before conn finished */
+            if (revents == 0) { /* timeout reached before conn finished */
                 reterr = sxs_set_nonblock(sd, 0);
                 if (reterr != SXS_SUCCESS) {
                     sxs_perror("sxs_connect_nb: sxs_set_nonblock:", reterr);
@@ -666,6 +873,10 @@ sxs_error_t sxs_send(sxs_socket_t sd, const sxs_buf_t buf, sxs_size_t len,
     
     sxs_ssize_t r;
     sxs_errno_t errsv;
+
+    if (sxs_uring_engine_enabled()) {
+        return sxs_uring_engine_send(sd, buf, len, flags, NULL, 0, p_sent);
+    }
     
     r = send(sd, buf, len, flags);
     if (r == SXS_SOCKET_ERROR) {
@@ -757,9 +968,7 @@ sxs_error_t sxs_send_nb(sxs_socket_t sd, const sxs_buf_t buf,
     sxs_ssize_t *p_sent) {
 
     sxs_error_t reterr;
-    fd_set sendfds;
-    struct timeval timeout;
-    int num_ready;
+    int revents;
 
     reterr = sxs_set_nonblock(sd, 1);
     if (reterr != SXS_SUCCESS) {
@@ -767,13 +976,9 @@ sxs_error_t sxs_send_nb(sxs_socket_t sd, const sxs_buf_t buf,
         return SXS_ERRSETNONBLOCK;
     }
 
-    FD_ZERO(&sendfds);
-    FD_SET(sd, &sendfds);
-    timeout.tv_sec = p_timeout->tv_sec;
-    timeout.tv_usec = p_timeout->tv_usec;
-    reterr = sxs_select((sd + 1), NULL, &sendfds, NULL, &timeout, &num_ready);
+    reterr = sxs_poll_one(sd, SXS_POLLOUT, p_timeout, &revents);
     if (reterr != SXS_SUCCESS) {
-            sxs_perror("sxs_send_nb: sxs_select:", reterr);
+            sxs_perror("sxs_send_nb: sxs_poll_one:", reterr);
             reterr = sxs_set_nonblock(sd, 0);
             if (reterr != SXS_SUCCESS) {
                 sxs_perror("sxs_send_nb: sxs_set_nonblock:", reterr);
@@ -782,7 +987,7 @@ sxs_error_t sxs_send_nb(sxs_socket_t sd, const sxs_buf_t buf,
             return SXS_ERRSELECTFAIL;
     }
 
-    if (num_ready == 0) {   /* reached the timeout */
+    if (revents == 0) {   /* reached the timeout */
         reterr = sxs_set_nonblock(sd, 0);
         if (reterr != SXS_SUCCESS) {
             sxs_perror("sxs_send_nb: sxs_set_nonblock:", reterr);
@@ -834,123 +1039,475 @@ sxs_error_t sxs_send_nbytes(sxs_socket_t sd, const sxs_buf_t buf,
     return SXS_SUCCESS;
 }
 
-sxs_error_t sxs_send_nbytes_nb(sxs_socket_t sd, const sxs_buf_t buf,
-    sxs_size_t len, const struct timeval *p_timeout) {
+sxs_error_t sxs_send_nbytes_wait(sxs_socket_t sd, const sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    const sxs_uint64_t *p_deadline_ms) {
 
+    struct timeval timeout;
     sxs_ssize_t tot_bytes_sent;
     sxs_ssize_t bytes_sent;
     sxs_error_t reterr;
-    fd_set sendfds;
-    struct timeval timeout;
-    int num_ready;
+    int revents;
 
     tot_bytes_sent = 0;
 
+    /* The send is attempted first and the socket only waited on once it
+     * is full, which saves a poll per chunk when it has room. */
+    while (tot_bytes_sent < len) {
+        reterr = sxs_send(sd, (buf + tot_bytes_sent),
+            (len - tot_bytes_sent), flags, &bytes_sent);
+        if (reterr == SXS_SUCCESS) {
+            tot_bytes_sent = tot_bytes_sent + bytes_sent;
+            continue;
+        } else if (reterr != SXS_EWOULDBLOCK) {
+            sxs_perror("sxs_send_nbytes_wait: sxs_send:", reterr);
+            return SXS_ERRSENDFAIL;
+        }
+
+        if (p_deadline_ms != NULL) {
+            sxs_deadline_timeout(*p_deadline_ms, &timeout);
+            p_timeout = &timeout;
+        }
+
+        reterr = sxs_poll_one(sd, SXS_POLLOUT, p_timeout, &revents);
+        if (reterr != SXS_SUCCESS) {
+            sxs_perror("sxs_send_nbytes_wait: sxs_poll_one:", reterr);
+            return SXS_ERRSELECTFAIL;
+        }
+
+        if (revents == 0) {   /* reach the specified timeout */
+            return SXS_ERRSENDTIMEDOUT;
+        }
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_send_nbytes_nb(sxs_socket_t sd, const sxs_buf_t buf,
+    sxs_size_t len, const struct timeval *p_timeout) {
+
+    sxs_error_t reterr;
+    sxs_error_t seterr;
+
     reterr = sxs_set_nonblock(sd, 1);
     if (reterr != SXS_SUCCESS) {
         sxs_perror("sxs_send_nbytes_nb: sxs_set_nonblock:", reterr);
         return SXS_ERRSETNONBLOCK;
     }
 
-    while (tot_bytes_sent < len) {
-        FD_ZERO(&sendfds);
-        FD_SET(sd, &sendfds);
-        timeout.tv_sec = p_timeout->tv_sec;
-        timeout.tv_usec = p_timeout->tv_usec;
-        reterr = sxs_select((sd + 1), NULL, &sendfds, NULL, &timeout,
-            &num_ready);
+    reterr = sxs_send_nbytes_wait(sd, buf, len, 0, p_timeout, NULL);
+
+    seterr = sxs_set_nonblock(sd, 0);
+    if (seterr != SXS_SUCCESS) {
+        sxs_perror("sxs_send_nbytes_nb: sxs_set_nonblock:", seterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return reterr;
+}
+
+sxs_error_t sxs_send_nbytes_dl(sxs_socket_t sd, const sxs_buf_t buf,
+    sxs_size_t len, sxs_uint64_t deadline_ms) {
+
+    sxs_error_t reterr;
+    sxs_error_t seterr;
+
+    reterr = sxs_set_nonblock(sd, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_send_nbytes_dl: sxs_set_nonblock:", reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    reterr = sxs_send_nbytes_wait(sd, buf, len, 0, NULL, &deadline_ms);
+
+    seterr = sxs_set_nonblock(sd, 0);
+    if (seterr != SXS_SUCCESS) {
+        sxs_perror("sxs_send_nbytes_dl: sxs_set_nonblock:", seterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return reterr;
+}
+
+/* Send once on a socket which does not block, either because of its
+ * I/O mode or 'flags', waiting up to 'p_timeout' for it to have room. */
+static sxs_error_t sxs_send_once_wait(sxs_socket_t sd, const sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    sxs_ssize_t *p_sent) {
+
+    sxs_error_t reterr;
+    int revents;
+
+    while (1) {
+        reterr = sxs_send(sd, buf, len, flags, p_sent);
+        if (reterr == SXS_SUCCESS) {
+            return SXS_SUCCESS;
+        } else if (reterr != SXS_EWOULDBLOCK) {
+            sxs_perror("sxs_send_dontwait: sxs_send:", reterr);
+            return SXS_ERRSENDFAIL;
+        }
+
+        reterr = sxs_poll_one(sd, SXS_POLLOUT, p_timeout, &revents);
         if (reterr != SXS_SUCCESS) {
-            sxs_perror("sxs_send_nbytes_nb: sxs_select:", reterr);
-            reterr = sxs_set_nonblock(sd, 0);
-            if (reterr != SXS_SUCCESS) {
-                sxs_perror("sxs_send_nbytes_nb: sxs_set_nonblock:", reterr);
-                return SXS_ERRSETNONBLOCK;
-            }
+            sxs_perror("sxs_send_dontwait: sxs_poll_one:", reterr);
             return SXS_ERRSELECTFAIL;
         }
 
-        if (num_ready == 0) {   /* reach the specified timeout */
-            reterr = sxs_set_nonblock(sd, 0);
-            if (reterr != SXS_SUCCESS) {
-                sxs_perror("sxs_send_nbytes_nb: sxs_set_nonblock:", reterr);
-                return SXS_ERRSETNONBLOCK;
-            }
+        if (revents == 0) {   /* reached the timeout */
             return SXS_ERRSENDTIMEDOUT;
-        } else {    /* socket has data and is ready for recving */
-            reterr = sxs_send(sd, (buf + tot_bytes_sent),
-                (len - tot_bytes_sent), 0, &bytes_sent);
-            if (reterr != SXS_SUCCESS) {
-                sxs_perror("sxs_send_nbytes_nb: sxs_recv:", reterr);
-                reterr = sxs_set_nonblock(sd, 0);
-                if (reterr != SXS_SUCCESS) {
-                    sxs_perror("sxs_send_nbytes_nb: sxs_set_nonblock:",
-                        reterr);
-                    return SXS_ERRSETNONBLOCK;
-                }
-                return SXS_ERRSENDFAIL;
-            } else {
-                tot_bytes_sent = tot_bytes_sent + bytes_sent;
-            }
         }
     }
+}
 
-    reterr = sxs_set_nonblock(sd, 0);
+sxs_error_t sxs_send_dontwait(sxs_socket_t sd, const sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    sxs_ssize_t *p_sent) {
+#ifdef MSG_DONTWAIT
+    return sxs_send_once_wait(sd, buf, len, (flags | MSG_DONTWAIT), p_timeout,
+        p_sent);
+#else
+    sxs_error_t reterr;
+    sxs_error_t seterr;
+
+    reterr = sxs_set_nonblock(sd, 1);
     if (reterr != SXS_SUCCESS) {
-        sxs_perror("sxs_send_nbytes_nb: sxs_set_nonblock:", reterr);
+        sxs_perror("sxs_send_dontwait: sxs_set_nonblock:", reterr);
         return SXS_ERRSETNONBLOCK;
     }
 
-    return SXS_SUCCESS;
+    reterr = sxs_send_once_wait(sd, buf, len, flags, p_timeout,
+        p_sent);
+
+    seterr = sxs_set_nonblock(sd, 0);
+    if (seterr != SXS_SUCCESS) {
+        sxs_perror("sxs_send_dontwait: sxs_set_nonblock:", seterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return reterr;
+#endif
 }
 
-sxs_error_t sxs_sendto(sxs_socket_t sd, const sxs_buf_t msg, sxs_size_t len,
-    int flags, const sxs_sockaddr_t *to, sxs_socklen_t tolen,
-    sxs_ssize_t *p_sent) {
-    
+sxs_error_t sxs_send_nbytes_dontwait(sxs_socket_t sd,
+    const sxs_buf_t buf, sxs_size_t len, const struct timeval *p_timeout) {
+#ifdef MSG_DONTWAIT
+    return sxs_send_nbytes_wait(sd, buf, len, MSG_DONTWAIT, p_timeout,
+        NULL);
+#else
+    sxs_error_t reterr;
+    sxs_error_t seterr;
+
+    reterr = sxs_set_nonblock(sd, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_send_nbytes_dontwait: sxs_set_nonblock:", reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    reterr = sxs_send_nbytes_wait(sd, buf, len, 0, p_timeout,
+        NULL);
+
+    seterr = sxs_set_nonblock(sd, 0);
+    if (seterr != SXS_SUCCESS) {
+        sxs_perror("sxs_send_nbytes_dontwait: sxs_set_nonblock:", seterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return reterr;
+#endif
+}
+
+sxs_error_t sxs_sendv(sxs_socket_t sd, const sxs_iovec_t *p_iov,
+    int iovcnt, int flags, sxs_ssize_t *p_sent) {
+
+#ifdef WIN32
+    DWORD sent;
+
+    if (sxs_uring_engine_enabled()) {
+        return sxs_uring_engine_sendv(sd, p_iov, iovcnt, flags, p_sent);
+    }
+
+    if (WSASend(sd, (LPWSABUF)p_iov, (DWORD)iovcnt, &sent, (DWORD)flags,
+        NULL, NULL) == SXS_SOCKET_ERROR) {
+        return sxs_map_errno(WSAGetLastError());
+    }
+
+    (*p_sent) = (sxs_ssize_t)sent;
+#else
+    struct msghdr msg;
     sxs_ssize_t r;
-    sxs_errno_t errsv;
-    
-    r = sendto(sd, msg, len, flags, to, tolen);
+
+    if (sxs_uring_engine_enabled()) {
+        return sxs_uring_engine_sendv(sd, p_iov, iovcnt, flags, p_sent);
+    }
+
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov = (struct iovec *)p_iov;
+    msg.msg_iovlen = iovcnt;
+
+    r = sendmsg(sd, &msg, flags);
     if (r == SXS_SOCKET_ERROR) {
-#ifdef WIN32
-        errsv = WSAGetLastError();
-        if (errsv == WSANOTINITIALISED) {
-            return SXS_WSANOTINITIALISED;
-        } else if (errsv == WSAENETDOWN) {
-            return SXS_ENETDOWN;
-        } else if (errsv == WSAEACCES) {
-            return SXS_EACCES;
-        } else if (errsv == WSAEINVAL) {
-            return SXS_EINVAL;
-        } else if (errsv == WSAEINTR) {
-            return SXS_EINTR;
-        } else if (errsv == WSAEINPROGRESS) {
-            return SXS_EINPROGRESS;
-        } else if (errsv == WSAEFAULT) {
-            return SXS_EFAULT;
-        } else if (errsv == WSAENETRESET) {
-            return SXS_ENETRESET;
-        } else if (errsv == WSAENOBUFS) {
-            return SXS_ENOBUFS;
-        } else if (errsv == WSAENOTCONN) {
-            return SXS_ENOTCONN;
-        } else if (errsv == WSAENOTSOCK) {
-            return SXS_ENOTSOCK;
-        } else if (errsv == WSAEOPNOTSUPP) {
-            return SXS_EOPNOTSUPP;
-        } else if (errsv == WSAESHUTDOWN) {
-            return SXS_ESHUTDOWN;
-        } else if (errsv == WSAEWOULDBLOCK) {
-            return SXS_EWOULDBLOCK;
-        } else if (errsv == WSAEMSGSIZE) {
-            return SXS_EMSGSIZE;
-        } else if (errsv == WSAEHOSTUNREACH) {
-            return SXS_EHOSTUNREACH;
-        } else if (errsv == WSAECONNABORTED) {
-            return SXS_ECONNABORTED;
-        } else if (errsv == WSAECONNRESET) {
-            return SXS_ECONNRESET;
-        } else if (errsv == WSAEADDRNOTAVAIL) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_sent) = r;
+#endif
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_sendv_nbytes(sxs_socket_t sd, sxs_iovec_t *p_iov,
+    int iovcnt) {
+
+    sxs_iovec_t saved;
+    sxs_ssize_t bytes_sent;
+    sxs_size_t off;
+    sxs_error_t reterr;
+    int idx, cnt;
+
+    idx = 0;
+    off = 0;
+    sxs_iov_advance(p_iov, iovcnt, &idx, &off, 0);
+
+    /* The buffer the previous send stopped within is trimmed in place
+     * for the next send and restored right after it, so the array is
+     * neither copied nor left changed. */
+    while (idx < iovcnt) {
+        cnt = ((iovcnt - idx) > SXS_IOV_MAX) ? SXS_IOV_MAX : (iovcnt - idx);
+
+        saved = p_iov[idx];
+        SXS_IOV_BASE(p_iov[idx]) = (char *)SXS_IOV_BASE(saved) + off;
+        SXS_IOV_LEN(p_iov[idx]) = SXS_IOV_LEN(saved) - off;
+        reterr = sxs_sendv(sd, &p_iov[idx], cnt, 0, &bytes_sent);
+        p_iov[idx] = saved;
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        }
+
+        sxs_iov_advance(p_iov, iovcnt, &idx, &off, (sxs_size_t)bytes_sent);
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_sendfile(sxs_socket_t sd, int fd, sxs_uint64_t offset,
+    sxs_size_t count, sxs_ssize_t *p_sent) {
+
+#if defined(__linux__)
+    off64_t off;
+    ssize_t r;
+
+    off = (off64_t)offset;
+    if (!SXS_OFF_FITS(off, offset)) {
+        return SXS_EINVAL;
+    }
+    r = sendfile64(sd, fd, &off, count);
+    if (r == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_sent) = r;
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+    off_t off;
+    off_t len;
+    int r;
+
+    off = (off_t)offset;
+    if (!SXS_OFF_FITS(off, offset)) {
+        return SXS_EINVAL;
+    }
+
+    /* These report the bytes sent before being interrupted or finding
+     * the socket full, which counts as a partial send. */
+    #if defined(__APPLE__)
+    len = (off_t)count;
+    r = sendfile(fd, sd, off, &len, NULL, 0);
+    #else
+    len = 0;
+    r = sendfile(fd, sd, off, count, NULL, &len, 0);
+    #endif
+    if ((r == -1) &&
+        !(((errno == EAGAIN) || (errno == EINTR)) && (len > 0))) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_sent) = (sxs_ssize_t)len;
+#else
+    char buf[SXS_SENDFILE_CHUNK];
+    sxs_size_t chunk;
+    #ifdef WIN32
+    __int64 off;
+    int r;
+    #else
+    off_t off;
+    ssize_t r;
+    #endif
+
+    #ifdef WIN32
+    off = (__int64)offset;
+    #else
+    off = (off_t)offset;
+    #endif
+    if (!SXS_OFF_FITS(off, offset)) {
+        return SXS_EINVAL;
+    }
+
+    chunk = (count > SXS_SENDFILE_CHUNK) ? SXS_SENDFILE_CHUNK : count;
+
+    #ifdef WIN32
+    if (_lseeki64(fd, off, SEEK_SET) == -1) {
+        return sxs_map_errno(errno);
+    }
+    r = _read(fd, buf, (unsigned int)chunk);
+    #else
+    r = pread(fd, buf, chunk, off);
+    #endif
+    if (r == -1) {
+        return sxs_map_errno(errno);
+    } else if (r == 0) {    /* end of file */
+        (*p_sent) = 0;
+        return SXS_SUCCESS;
+    }
+
+    /* Bytes read but not sent are simply read again by the next call. */
+    return sxs_send(sd, buf, (sxs_size_t)r, 0, p_sent);
+#endif
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_sendfile_nbytes(sxs_socket_t sd, int fd,
+    sxs_uint64_t offset, sxs_size_t count) {
+
+    sxs_size_t tot_bytes_sent;
+    sxs_ssize_t bytes_sent = 0;
+    sxs_error_t reterr;
+
+    tot_bytes_sent = 0;
+
+    while (tot_bytes_sent < count) {
+        reterr = sxs_sendfile(sd, fd, (offset + tot_bytes_sent),
+            (count - tot_bytes_sent), &bytes_sent);
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        } else if (bytes_sent == 0) {
+            return SXS_ERRFILEEOF;
+        } else {
+            tot_bytes_sent = tot_bytes_sent + bytes_sent;
+        }
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_sendfile_nbytes_nb(sxs_socket_t sd, int fd,
+    sxs_uint64_t offset, sxs_size_t count, const struct timeval *p_timeout) {
+
+    sxs_size_t tot_bytes_sent;
+    sxs_ssize_t bytes_sent = 0;
+    sxs_error_t reterr;
+    sxs_error_t seterr;
+    int revents;
+
+    reterr = sxs_set_nonblock(sd, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sendfile_nbytes_nb: sxs_set_nonblock:", reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    tot_bytes_sent = 0;
+
+    /* As in sxs_send_nbytes_wait() the socket is only waited on once
+     * it is full. */
+    while (tot_bytes_sent < count) {
+        reterr = sxs_sendfile(sd, fd, (offset + tot_bytes_sent),
+            (count - tot_bytes_sent), &bytes_sent);
+        if (reterr == SXS_SUCCESS) {
+            if (bytes_sent == 0) {
+                reterr = SXS_ERRFILEEOF;
+                break;
+            }
+            tot_bytes_sent = tot_bytes_sent + bytes_sent;
+            continue;
+        } else if (reterr != SXS_EWOULDBLOCK) {
+            sxs_perror("sxs_sendfile_nbytes_nb: sxs_sendfile:", reterr);
+            reterr = SXS_ERRSENDFAIL;
+            break;
+        }
+
+        reterr = sxs_poll_one(sd, SXS_POLLOUT, p_timeout, &revents);
+        if (reterr != SXS_SUCCESS) {
+            sxs_perror("sxs_sendfile_nbytes_nb: sxs_poll_one:", reterr);
+            reterr = SXS_ERRSELECTFAIL;
+            break;
+        }
+
+        if (revents == 0) {   /* reached the timeout */
+            reterr = SXS_ERRSENDTIMEDOUT;
+            break;
+        }
+    }
+
+    seterr = sxs_set_nonblock(sd, 0);
+    if (seterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sendfile_nbytes_nb: sxs_set_nonblock:", seterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return reterr;
+}
+
+sxs_error_t sxs_sendto(sxs_socket_t sd, const sxs_buf_t msg, sxs_size_t len,
+    int flags, const sxs_sockaddr_t *to, sxs_socklen_t tolen,
+    sxs_ssize_t *p_sent) {
+    
+    sxs_ssize_t r;
+    sxs_errno_t errsv;
+
+    if (sxs_uring_engine_enabled()) {
+        return sxs_uring_engine_send(sd, msg, len, flags, to, tolen, p_sent);
+    }
+    
+    r = sendto(sd, msg, len, flags, to, tolen);
+    if (r == SXS_SOCKET_ERROR) {
+#ifdef WIN32
+        errsv = WSAGetLastError();
+        if (errsv == WSANOTINITIALISED) {
+            return SXS_WSANOTINITIALISED;
+        } else if (errsv == WSAENETDOWN) {
+            return SXS_ENETDOWN;
+        } else if (errsv == WSAEACCES) {
+            return SXS_EACCES;
+        } else if (errsv == WSAEINVAL) {
+            return SXS_EINVAL;
+        } else if (errsv == WSAEINTR) {
+            return SXS_EINTR;
+        } else if (errsv == WSAEINPROGRESS) {
+            return SXS_EINPROGRESS;
+        } else if (errsv == WSAEFAULT) {
+            return SXS_EFAULT;
+        } else if (errsv == WSAENETRESET) {
+            return SXS_ENETRESET;
+        } else if (errsv == WSAENOBUFS) {
+            return SXS_ENOBUFS;
+        } else if (errsv == WSAENOTCONN) {
+            return SXS_ENOTCONN;
+        } else if (errsv == WSAENOTSOCK) {
+            return SXS_ENOTSOCK;
+        } else if (errsv == WSAEOPNOTSUPP) {
+            return SXS_EOPNOTSUPP;
+        } else if (errsv == WSAESHUTDOWN) {
+            return SXS_ESHUTDOWN;
+        } else if (errsv == WSAEWOULDBLOCK) {
+            return SXS_EWOULDBLOCK;
+        } else if (errsv == WSAEMSGSIZE) {
+            return SXS_EMSGSIZE;
+        } else if (errsv == WSAEHOSTUNREACH) {
+            return SXS_EHOSTUNREACH;
+        } else if (errsv == WSAECONNABORTED) {
+            return SXS_ECONNABORTED;
+        } else if (errsv == WSAECONNRESET) {
+            return SXS_ECONNRESET;
+        } else if (errsv == WSAEADDRNOTAVAIL) {
             return SXS_EADDRNOTAVAIL;
         } else if (errsv == WSAEAFNOSUPPORT) {
             return SXS_EAFNOSUPPORT;
@@ -1021,6 +1578,11 @@ sxs_error_t sxs_recv(sxs_socket_t sd, sxs_buf_t buf, sxs_size_t len,
     sxs_ssize_t r;
     sxs_errno_t errsv;
 
+    if (sxs_uring_engine_enabled()) {
+        return sxs_uring_engine_recv(sd, buf, len, flags, NULL, NULL,
+            p_recvd);
+    }
+
     r = recv(sd, buf, len, flags);
     if (r == SXS_SOCKET_ERROR) {
 #ifdef WIN32
@@ -1096,9 +1658,7 @@ sxs_error_t sxs_recv_nb(sxs_socket_t sd, sxs_buf_t buf, sxs_size_t len,
 
     sxs_ssize_t bytes_recvd;
     sxs_error_t reterr;
-    fd_set recvfds;
-    struct timeval timeout;
-    int num_ready;
+    int revents;
 
     reterr = sxs_set_nonblock(sd, 1);
     if (reterr != SXS_SUCCESS) {
@@ -1106,13 +1666,9 @@ sxs_error_t sxs_recv_nb(sxs_socket_t sd, sxs_buf_t buf, sxs_size_t len,
         return SXS_ERRSETNONBLOCK;
     }
 
-    FD_ZERO(&recvfds);
-    FD_SET(sd, &recvfds);
-    timeout.tv_sec = p_timeout->tv_sec;
-    timeout.tv_usec = p_timeout->tv_usec;
-    reterr = sxs_select((sd + 1), &recvfds, NULL, NULL, &timeout, &num_ready);
+    reterr = sxs_poll_one(sd, SXS_POLLIN, p_timeout, &revents);
     if (reterr != SXS_SUCCESS) {
-            sxs_perror("sxs_recv_nb: sxs_select:", reterr);
+            sxs_perror("sxs_recv_nb: sxs_poll_one:", reterr);
             reterr = sxs_set_nonblock(sd, 0);
             if (reterr != SXS_SUCCESS) {
                 sxs_perror("sxs_recv_nb: sxs_set_nonblock:", reterr);
@@ -1121,7 +1677,7 @@ sxs_error_t sxs_recv_nb(sxs_socket_t sd, sxs_buf_t buf, sxs_size_t len,
             return SXS_ERRSELECTFAIL;
     }
 
-    if (num_ready == 0) {   /* reached the timeout */
+    if (revents == 0) {   /* reached the timeout */
         reterr = sxs_set_nonblock(sd, 0);
         if (reterr != SXS_SUCCESS) {
             sxs_perror("sxs_recv_nb: sxs_set_nonblock:", reterr);
@@ -1190,85 +1746,509 @@ sxs_error_t sxs_recv_nbytes(sxs_socket_t sd, sxs_buf_t buf,
     return SXS_SUCCESS;
 }
 
-sxs_error_t sxs_recv_nbytes_nb(sxs_socket_t sd, sxs_buf_t buf,
-    sxs_size_t len, const struct timeval *p_timeout) {
+sxs_error_t sxs_recv_nbytes_wait(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    const sxs_uint64_t *p_deadline_ms) {
 
+    struct timeval timeout;
     sxs_ssize_t tot_bytes_recvd;
     sxs_ssize_t bytes_recvd;
     sxs_error_t reterr;
-    fd_set recvfds;
-    struct timeval timeout;
-    int num_ready;
+    int revents;
 
     tot_bytes_recvd = 0;
 
+    /* The receive is attempted first and the socket only waited on once
+     * it is drained, which saves a poll per chunk when data is queued. */
+    while (tot_bytes_recvd < len) {
+        reterr = sxs_recv(sd, (buf + tot_bytes_recvd),
+            (len - tot_bytes_recvd), flags, &bytes_recvd);
+        if (reterr == SXS_SUCCESS) {
+            if (bytes_recvd == 0) { /* peer cleanly disconnected */
+                return SXS_ERRCONNCLOSED;
+            }
+            tot_bytes_recvd = tot_bytes_recvd + bytes_recvd;
+            continue;
+        } else if (reterr != SXS_EWOULDBLOCK) {
+            sxs_perror("sxs_recv_nbytes_wait: sxs_recv:", reterr);
+            return SXS_ERRRECVFAIL;
+        }
+
+        if (p_deadline_ms != NULL) {
+            sxs_deadline_timeout(*p_deadline_ms, &timeout);
+            p_timeout = &timeout;
+        }
+
+        reterr = sxs_poll_one(sd, SXS_POLLIN, p_timeout, &revents);
+        if (reterr != SXS_SUCCESS) {
+            sxs_perror("sxs_recv_nbytes_wait: sxs_poll_one:", reterr);
+            return SXS_ERRSELECTFAIL;
+        }
+
+        if (revents == 0) {   /* reach the specified timeout */
+            return SXS_ERRRECVTIMEDOUT;
+        }
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_recv_nbytes_nb(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, const struct timeval *p_timeout) {
+
+    sxs_error_t reterr;
+    sxs_error_t seterr;
+
     reterr = sxs_set_nonblock(sd, 1);
     if (reterr != SXS_SUCCESS) {
         sxs_perror("sxs_recv_nbytes_nb: sxs_set_nonblock:", reterr);
         return SXS_ERRSETNONBLOCK;
     }
 
-    while (tot_bytes_recvd < len) {
-        FD_ZERO(&recvfds);
-        FD_SET(sd, &recvfds);
-        timeout.tv_sec = p_timeout->tv_sec;
-        timeout.tv_usec = p_timeout->tv_usec;
-        reterr = sxs_select((sd + 1), &recvfds, NULL, NULL, &timeout,
-            &num_ready);
-        if (reterr != SXS_SUCCESS) {
-            sxs_perror("sxs_recv_nbytes_nb: sxs_select:", reterr);
-            reterr = sxs_set_nonblock(sd, 0);
-            if (reterr != SXS_SUCCESS) {
-                sxs_perror("sxs_recv_nbytes_nb: sxs_set_nonblock:", reterr);
-                return SXS_ERRSETNONBLOCK;
+    reterr = sxs_recv_nbytes_wait(sd, buf, len, 0, p_timeout, NULL);
+
+    seterr = sxs_set_nonblock(sd, 0);
+    if (seterr != SXS_SUCCESS) {
+        sxs_perror("sxs_recv_nbytes_nb: sxs_set_nonblock:", seterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return reterr;
+}
+
+sxs_error_t sxs_recv_nbytes_dl(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, sxs_uint64_t deadline_ms) {
+
+    sxs_error_t reterr;
+    sxs_error_t seterr;
+
+    reterr = sxs_set_nonblock(sd, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_recv_nbytes_dl: sxs_set_nonblock:", reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    reterr = sxs_recv_nbytes_wait(sd, buf, len, 0, NULL, &deadline_ms);
+
+    seterr = sxs_set_nonblock(sd, 0);
+    if (seterr != SXS_SUCCESS) {
+        sxs_perror("sxs_recv_nbytes_dl: sxs_set_nonblock:", seterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return reterr;
+}
+
+/* Receive once from a socket which does not block, either because of
+ * its I/O mode or 'flags', waiting up to 'p_timeout' for data. */
+static sxs_error_t sxs_recv_once_wait(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    sxs_ssize_t *p_recvd) {
+
+    sxs_error_t reterr;
+    int revents;
+
+    while (1) {
+        reterr = sxs_recv(sd, buf, len, flags, p_recvd);
+        if (reterr == SXS_SUCCESS) {
+            if (*p_recvd == 0) { /* peer cleanly disconnected */
+                return SXS_ERRCONNCLOSED;
             }
+            return SXS_SUCCESS;
+        } else if (reterr != SXS_EWOULDBLOCK) {
+            sxs_perror("sxs_recv_dontwait: sxs_recv:", reterr);
+            return SXS_ERRRECVFAIL;
+        }
+
+        reterr = sxs_poll_one(sd, SXS_POLLIN, p_timeout, &revents);
+        if (reterr != SXS_SUCCESS) {
+            sxs_perror("sxs_recv_dontwait: sxs_poll_one:", reterr);
             return SXS_ERRSELECTFAIL;
         }
 
-        if (num_ready == 0) {   /* reach the specified timeout */
-            reterr = sxs_set_nonblock(sd, 0);
-            if (reterr != SXS_SUCCESS) {
-                sxs_perror("sxs_recv_nbytes_nb: sxs_set_nonblock:", reterr);
-                return SXS_ERRSETNONBLOCK;
-            }
+        if (revents == 0) {   /* reached the timeout */
             return SXS_ERRRECVTIMEDOUT;
-        } else {    /* socket has data and is ready for recving */
-            reterr = sxs_recv(sd, (buf + tot_bytes_recvd),
-                (len - tot_bytes_recvd), 0, &bytes_recvd);
-            if (reterr != SXS_SUCCESS) {
-                sxs_perror("sxs_recv_nbytes_nb: sxs_recv:", reterr);
-                reterr = sxs_set_nonblock(sd, 0);
+        }
+    }
+}
+
+sxs_error_t sxs_recv_dontwait(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    sxs_ssize_t *p_recvd) {
+#ifdef MSG_DONTWAIT
+    return sxs_recv_once_wait(sd, buf, len, (flags | MSG_DONTWAIT), p_timeout,
+        p_recvd);
+#else
+    sxs_error_t reterr;
+    sxs_error_t seterr;
+
+    reterr = sxs_set_nonblock(sd, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_recv_dontwait: sxs_set_nonblock:", reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    reterr = sxs_recv_once_wait(sd, buf, len, flags, p_timeout,
+        p_recvd);
+
+    seterr = sxs_set_nonblock(sd, 0);
+    if (seterr != SXS_SUCCESS) {
+        sxs_perror("sxs_recv_dontwait: sxs_set_nonblock:", seterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return reterr;
+#endif
+}
+
+sxs_error_t sxs_recv_nbytes_dontwait(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, const struct timeval *p_timeout) {
+#ifdef MSG_DONTWAIT
+    return sxs_recv_nbytes_wait(sd, buf, len, MSG_DONTWAIT, p_timeout,
+        NULL);
+#else
+    sxs_error_t reterr;
+    sxs_error_t seterr;
+
+    reterr = sxs_set_nonblock(sd, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_recv_nbytes_dontwait: sxs_set_nonblock:", reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    reterr = sxs_recv_nbytes_wait(sd, buf, len, 0, p_timeout,
+        NULL);
+
+    seterr = sxs_set_nonblock(sd, 0);
+    if (seterr != SXS_SUCCESS) {
+        sxs_perror("sxs_recv_nbytes_dontwait: sxs_set_nonblock:", seterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return reterr;
+#endif
+}
+
+sxs_error_t sxs_recvv(sxs_socket_t sd, const sxs_iovec_t *p_iov,
+    int iovcnt, int flags, sxs_ssize_t *p_recvd) {
+
+#ifdef WIN32
+    DWORD recvd;
+    DWORD fl;
+
+    if (sxs_uring_engine_enabled()) {
+        return sxs_uring_engine_recvv(sd, p_iov, iovcnt, flags, p_recvd);
+    }
+
+    fl = (DWORD)flags;
+    if (WSARecv(sd, (LPWSABUF)p_iov, (DWORD)iovcnt, &recvd, &fl,
+        NULL, NULL) == SXS_SOCKET_ERROR) {
+        return sxs_map_errno(WSAGetLastError());
+    }
+
+    (*p_recvd) = (sxs_ssize_t)recvd;
+#else
+    struct msghdr msg;
+    sxs_ssize_t r;
+
+    if (sxs_uring_engine_enabled()) {
+        return sxs_uring_engine_recvv(sd, p_iov, iovcnt, flags, p_recvd);
+    }
+
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov = (struct iovec *)p_iov;
+    msg.msg_iovlen = iovcnt;
+
+    r = recvmsg(sd, &msg, flags);
+    if (r == SXS_SOCKET_ERROR) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_recvd) = r;
+#endif
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_recvv_nbytes(sxs_socket_t sd, sxs_iovec_t *p_iov,
+    int iovcnt) {
+
+    sxs_iovec_t saved;
+    sxs_ssize_t bytes_recvd;
+    sxs_size_t off;
+    sxs_error_t reterr;
+    int idx, cnt;
+
+    idx = 0;
+    off = 0;
+    sxs_iov_advance(p_iov, iovcnt, &idx, &off, 0);
+
+    /* See sxs_sendv_nbytes() for how partial progress is tracked. */
+    while (idx < iovcnt) {
+        cnt = ((iovcnt - idx) > SXS_IOV_MAX) ? SXS_IOV_MAX : (iovcnt - idx);
+
+        saved = p_iov[idx];
+        SXS_IOV_BASE(p_iov[idx]) = (char *)SXS_IOV_BASE(saved) + off;
+        SXS_IOV_LEN(p_iov[idx]) = SXS_IOV_LEN(saved) - off;
+        reterr = sxs_recvv(sd, &p_iov[idx], cnt, 0, &bytes_recvd);
+        p_iov[idx] = saved;
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        } else if (bytes_recvd == 0) { /* peer cleanly disconnected */
+            return SXS_ERRCONNCLOSED;
+        }
+
+        sxs_iov_advance(p_iov, iovcnt, &idx, &off, (sxs_size_t)bytes_recvd);
+    }
+
+    return SXS_SUCCESS;
+}
+
+/* Write all of a buffer to a file at its current offset, passing back
+ * via 'p_written' how much was written even on failure. */
+static sxs_error_t sxs_write_all(int fd, const char *p_buf, sxs_size_t len,
+    sxs_size_t *p_written) {
+#ifdef WIN32
+    int r;
+#else
+    ssize_t r;
+#endif
+
+    (*p_written) = 0;
+
+    while (len > 0) {
+#ifdef WIN32
+        r = _write(fd, p_buf, (unsigned int)len);
+#else
+        r = write(fd, p_buf, len);
+#endif
+        if (r == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return sxs_map_errno(errno);
+        }
+        p_buf = p_buf + r;
+        len = len - r;
+        (*p_written) = (*p_written) + r;
+    }
+
+    return SXS_SUCCESS;
+}
+
+#ifdef SXS_SPLICE
+/* Move 'len' bytes from a pipe to a file, passing back via 'p_moved'
+ * how many reached the file even on failure. Files which can not be
+ * spliced into, e.g. ones opened with O_APPEND, make '*p_use_splice'
+ * 0 and the data is then read from the pipe and written instead. On
+ * failure whatever is left in the pipe is drained, so that it is
+ * discarded here rather than by closing the pipe. */
+static sxs_error_t sxs_pipe_to_file(int pipe_fd, int fd, sxs_size_t len,
+    char *p_buf, sxs_size_t buf_size, int *p_use_splice,
+    sxs_size_t *p_moved) {
+
+    sxs_error_t reterr;
+    sxs_size_t written;
+    ssize_t r;
+
+    (*p_moved) = 0;
+    reterr = SXS_SUCCESS;
+
+    while (len > 0) {
+        if (*p_use_splice) {
+            r = splice(pipe_fd, NULL, fd, NULL, len, SPLICE_F_MOVE);
+            if ((r == -1) && (errno == EINVAL)) {
+                (*p_use_splice) = 0;
+                continue;
+            }
+        } else {
+            r = read(pipe_fd, p_buf, ((len > buf_size) ? buf_size : len));
+            if (r > 0) {
+                reterr = sxs_write_all(fd, p_buf, r, &written);
+                (*p_moved) = (*p_moved) + written;
                 if (reterr != SXS_SUCCESS) {
-                    sxs_perror("sxs_recv_nbytes_nb: sxs_set_nonblock:",
-                        reterr);
-                    return SXS_ERRSETNONBLOCK;
-                }
-                return SXS_ERRRECVFAIL;
-            } else {
-                if (bytes_recvd == 0) { /* peer cleanly disconnected */
-                    /* The peer cleanly closed the connection before the
-                     * tot number of bytes were read nito the buffer. */
-                    reterr = sxs_set_nonblock(sd, 0);
-                    if (reterr != SXS_SUCCESS) {
-                        sxs_perror("sxs_recv_nbytes_nb: sxs_set_nonblock:",
-                            reterr);
-                        return SXS_ERRSETNONBLOCK;
-                    }
-                    return SXS_ERRCONNCLOSED;
-                } else {
-                    tot_bytes_recvd = tot_bytes_recvd + bytes_recvd;
+                    len = len - r;
+                    break;
                 }
             }
         }
+
+        if (r == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            reterr = sxs_map_errno(errno);
+            break;
+        } else if (r == 0) {
+            reterr = SXS_EIO;
+            break;
+        }
+        len = len - r;
+        if (*p_use_splice) {
+            (*p_moved) = (*p_moved) + r;
+        }
+    }
+
+    /* The pipe only ever holds the data being moved, so it is all
+     * still there to be read. */
+    while (len > 0) {
+        r = read(pipe_fd, p_buf, ((len > buf_size) ? buf_size : len));
+        if (r == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        } else if (r == 0) {
+            break;
+        }
+        len = len - r;
     }
 
-    reterr = sxs_set_nonblock(sd, 0);
+    return reterr;
+}
+#endif
+
+/* Receive exactly 'count' bytes from a socket into a file. If 'wait' is
+ * set the socket is non-blocking and waited on for up to 'p_timeout'
+ * whenever it is empty, and receive errors are reported as by
+ * sxs_recv_nbytes_nb(). */
+static sxs_error_t sxs_recv_to_file_wait(sxs_socket_t sd, int fd,
+    sxs_size_t count, int wait, const struct timeval *p_timeout,
+    sxs_size_t *p_written) {
+
+    char buf[SXS_RECV_TO_FILE_CHUNK];
+#ifdef SXS_SPLICE
+    int pipe_fds[2];
+    int pipe_size;
+    int use_splice;
+    ssize_t r;
+#endif
+    sxs_size_t tot_bytes_recvd;
+    sxs_ssize_t bytes_recvd;
+    sxs_size_t bytes_written;
+    sxs_size_t chunk;
+    sxs_error_t reterr;
+    int revents;
+
+    tot_bytes_recvd = 0;
+    reterr = SXS_SUCCESS;
+
+    /* Without a pipe the data is simply copied. */
+#ifdef SXS_SPLICE
+    use_splice = (pipe2(pipe_fds, O_CLOEXEC) == 0);
+    pipe_size = -1;
+    if (use_splice) {
+    #ifdef F_SETPIPE_SZ
+        fcntl(pipe_fds[1], F_SETPIPE_SZ, SXS_RECV_TO_FILE_PIPE_SIZE);
+        pipe_size = fcntl(pipe_fds[1], F_GETPIPE_SZ);
+    #endif
+        if (pipe_size <= 0) {
+            pipe_size = 65536;
+        }
+    }
+#endif
+
+    while (tot_bytes_recvd < count) {
+        chunk = count - tot_bytes_recvd;
+
+#ifdef SXS_SPLICE
+        if (use_splice) {
+            if (chunk > (sxs_size_t)pipe_size) {
+                chunk = pipe_size;
+            }
+            r = splice(sd, NULL, pipe_fds[1], NULL, chunk, SPLICE_F_MOVE);
+            reterr = (r == -1) ? sxs_map_errno(errno) : SXS_SUCCESS;
+            bytes_recvd = r;
+        } else
+#endif
+        {
+            if (chunk > SXS_RECV_TO_FILE_CHUNK) {
+                chunk = SXS_RECV_TO_FILE_CHUNK;
+            }
+            reterr = sxs_recv(sd, buf, chunk, 0, &bytes_recvd);
+        }
+
+        if ((reterr == SXS_EWOULDBLOCK) && wait) {
+            reterr = sxs_poll_one(sd, SXS_POLLIN, p_timeout, &revents);
+            if (reterr != SXS_SUCCESS) {
+                sxs_perror("sxs_recv_to_file_nb: sxs_poll_one:", reterr);
+                reterr = SXS_ERRSELECTFAIL;
+                break;
+            }
+            if (revents == 0) {   /* reached the timeout */
+                reterr = SXS_ERRRECVTIMEDOUT;
+                break;
+            }
+            continue;
+        } else if (reterr != SXS_SUCCESS) {
+            if (wait) {
+                sxs_perror("sxs_recv_to_file_nb: sxs_recv:", reterr);
+                reterr = SXS_ERRRECVFAIL;
+            }
+            break;
+        } else if (bytes_recvd == 0) { /* peer cleanly disconnected */
+            reterr = SXS_ERRCONNCLOSED;
+            break;
+        }
+
+#ifdef SXS_SPLICE
+        if (use_splice) {
+            reterr = sxs_pipe_to_file(pipe_fds[0], fd, bytes_recvd, buf,
+                sizeof(buf), &use_splice, &bytes_written);
+        } else
+#endif
+        {
+            reterr = sxs_write_all(fd, buf, bytes_recvd, &bytes_written);
+        }
+
+        /* What did reach the file before a failure is counted, the rest
+         * of the chunk has left the socket and is lost. */
+        tot_bytes_recvd = tot_bytes_recvd + bytes_written;
+        if (reterr != SXS_SUCCESS) {
+            break;
+        }
+    }
+
+#ifdef SXS_SPLICE
+    if (pipe_size > 0) {    /* the pipe was created */
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+    }
+#endif
+
+    if (p_written != NULL) {
+        (*p_written) = tot_bytes_recvd;
+    }
+
+    return reterr;
+}
+
+sxs_error_t sxs_recv_to_file(sxs_socket_t sd, int fd, sxs_size_t count,
+    sxs_size_t *p_written) {
+    return sxs_recv_to_file_wait(sd, fd, count, 0, NULL, p_written);
+}
+
+sxs_error_t sxs_recv_to_file_nb(sxs_socket_t sd, int fd, sxs_size_t count,
+    const struct timeval *p_timeout, sxs_size_t *p_written) {
+
+    sxs_error_t reterr;
+    sxs_error_t seterr;
+
+    reterr = sxs_set_nonblock(sd, 1);
     if (reterr != SXS_SUCCESS) {
-        sxs_perror("sxs_recv_nbytes_nb: sxs_set_nonblock:", reterr);
+        sxs_perror("sxs_recv_to_file_nb: sxs_set_nonblock:", reterr);
         return SXS_ERRSETNONBLOCK;
     }
 
-    return SXS_SUCCESS;
+    reterr = sxs_recv_to_file_wait(sd, fd, count, 1, p_timeout, p_written);
+
+    seterr = sxs_set_nonblock(sd, 0);
+    if (seterr != SXS_SUCCESS) {
+        sxs_perror("sxs_recv_to_file_nb: sxs_set_nonblock:", seterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return reterr;
 }
 
 sxs_error_t sxs_recvfrom(sxs_socket_t sd, sxs_buf_t buf, sxs_size_t len,
@@ -1278,6 +2258,11 @@ sxs_error_t sxs_recvfrom(sxs_socket_t sd, sxs_buf_t buf, sxs_size_t len,
     sxs_ssize_t r;
     sxs_errno_t errsv;
     
+    if (sxs_uring_engine_enabled()) {
+        return sxs_uring_engine_recv(sd, buf, len, flags, from, fromlen,
+            p_recvd);
+    }
+
     r = recvfrom(sd, buf, len, flags, from, fromlen);
     if (r == SXS_SOCKET_ERROR) {
 #ifdef WIN32
@@ -1348,6 +2333,179 @@ sxs_error_t sxs_recvfrom(sxs_socket_t sd, sxs_buf_t buf, sxs_size_t len,
     return SXS_SUCCESS;
 }
 
+/* Whether an error sending a datagram concerns only that datagram, e.g.
+ * its size or destination, rather than the socket, so that the rest of
+ * a batch can still be sent. */
+static int sxs_mmsg_slot_error(sxs_error_t err) {
+    return (err == SXS_EMSGSIZE) || (err == SXS_ECONNREFUSED) ||
+        (err == SXS_EHOSTUNREACH) || (err == SXS_ENETUNREACH) ||
+        (err == SXS_EACCES) || (err == SXS_EADDRNOTAVAIL) ||
+        (err == SXS_EAFNOSUPPORT) || (err == SXS_EDESTADDRREQ) ||
+        (err == SXS_EINVAL) || (err == SXS_EPERM);
+}
+
+sxs_error_t sxs_sendmmsg(sxs_socket_t sd, sxs_mmsg_t *p_msgs, int num,
+    int flags, int *p_num_done) {
+
+#ifdef SXS_MMSG
+    struct mmsghdr hdrs[SXS_MMSG_BATCH];
+    struct iovec iovs[SXS_MMSG_BATCH];
+    int i, cnt, r;
+#endif
+    sxs_error_t reterr;
+    int done;
+
+    done = 0;
+    reterr = SXS_SUCCESS;
+
+    while (done < num) {
+#ifdef SXS_MMSG
+        cnt = ((num - done) > SXS_MMSG_BATCH) ? SXS_MMSG_BATCH : (num - done);
+        memset(hdrs, 0, (cnt * sizeof(struct mmsghdr)));
+        for (i = 0; i < cnt; i++) {
+            iovs[i].iov_base = p_msgs[done + i].buf;
+            iovs[i].iov_len = p_msgs[done + i].len;
+            hdrs[i].msg_hdr.msg_iov = &iovs[i];
+            hdrs[i].msg_hdr.msg_iovlen = 1;
+            if (p_msgs[done + i].addr != NULL) {
+                hdrs[i].msg_hdr.msg_name = p_msgs[done + i].addr;
+                hdrs[i].msg_hdr.msg_namelen = p_msgs[done + i].addrlen;
+            }
+        }
+
+        /* The kernel stops at the first datagram it fails to send, and
+         * only reports the error if it is the first of the call, so the
+         * datagram after a short count is retried to find out why. */
+        r = sendmmsg(sd, hdrs, cnt, flags);
+        if (r == SXS_SOCKET_ERROR) {
+            reterr = sxs_map_errno(errno);
+        } else {
+            for (i = 0; i < r; i++) {
+                p_msgs[done + i].result = hdrs[i].msg_len;
+                p_msgs[done + i].err = SXS_SUCCESS;
+            }
+            done = done + r;
+            continue;
+        }
+#else
+        reterr = sxs_sendto(sd, p_msgs[done].buf, p_msgs[done].len, flags,
+            p_msgs[done].addr, p_msgs[done].addrlen, &p_msgs[done].result);
+        if (reterr == SXS_SUCCESS) {
+            p_msgs[done].err = SXS_SUCCESS;
+            done++;
+            continue;
+        }
+#endif
+
+        if (!sxs_mmsg_slot_error(reterr)) {
+            break;
+        }
+
+        p_msgs[done].result = 0;
+        p_msgs[done].err = reterr;
+        reterr = SXS_SUCCESS;
+        done++;
+    }
+
+    (*p_num_done) = done;
+
+    /* An error that stopped the batch after some datagrams were sent is
+     * reported by the next call instead. */
+    return (done > 0) ? SXS_SUCCESS : reterr;
+}
+
+sxs_error_t sxs_recvmmsg(sxs_socket_t sd, sxs_mmsg_t *p_msgs, int num,
+    int flags, int *p_num_done) {
+
+#ifdef SXS_MMSG
+    struct mmsghdr hdrs[SXS_MMSG_BATCH];
+    struct iovec iovs[SXS_MMSG_BATCH];
+    int i, cnt, r;
+#else
+    struct timeval zero_timeout;
+    int revents;
+#endif
+    sxs_error_t reterr;
+    int done;
+    int f;
+
+    done = 0;
+    reterr = SXS_SUCCESS;
+
+    /* Only the first datagram is waited for, the rest of the batch is
+     * whatever else is already queued on the socket. */
+#ifdef SXS_MMSG
+    f = flags | MSG_WAITFORONE;
+#else
+    f = flags;
+    zero_timeout.tv_sec = 0;
+    zero_timeout.tv_usec = 0;
+#endif
+
+    while (done < num) {
+#ifdef SXS_MMSG
+        cnt = ((num - done) > SXS_MMSG_BATCH) ? SXS_MMSG_BATCH : (num - done);
+        memset(hdrs, 0, (cnt * sizeof(struct mmsghdr)));
+        for (i = 0; i < cnt; i++) {
+            iovs[i].iov_base = p_msgs[done + i].buf;
+            iovs[i].iov_len = p_msgs[done + i].len;
+            hdrs[i].msg_hdr.msg_iov = &iovs[i];
+            hdrs[i].msg_hdr.msg_iovlen = 1;
+            if (p_msgs[done + i].addr != NULL) {
+                hdrs[i].msg_hdr.msg_name = p_msgs[done + i].addr;
+                hdrs[i].msg_hdr.msg_namelen = p_msgs[done + i].addrlen;
+            }
+        }
+
+        r = recvmmsg(sd, hdrs, cnt, f, NULL);
+        if (r == SXS_SOCKET_ERROR) {
+            reterr = sxs_map_errno(errno);
+            break;
+        }
+
+        for (i = 0; i < r; i++) {
+            p_msgs[done + i].result = hdrs[i].msg_len;
+            p_msgs[done + i].addrlen = hdrs[i].msg_hdr.msg_namelen;
+            if (hdrs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                p_msgs[done + i].err = SXS_EMSGSIZE;
+            } else {
+                p_msgs[done + i].err = SXS_SUCCESS;
+            }
+        }
+        done = done + r;
+
+        if (r < cnt) {
+            break;
+        }
+        f = flags | MSG_DONTWAIT;
+#else
+        if (done > 0) {
+            reterr = sxs_poll_one(sd, SXS_POLLIN, &zero_timeout, &revents);
+            if ((reterr != SXS_SUCCESS) || (revents == 0)) {
+                break;
+            }
+        }
+
+        reterr = sxs_recvfrom(sd, p_msgs[done].buf, p_msgs[done].len, f,
+            p_msgs[done].addr,
+            ((p_msgs[done].addr != NULL) ? &p_msgs[done].addrlen : NULL),
+            &p_msgs[done].result);
+        if (reterr == SXS_EMSGSIZE) {   /* truncated to fit the buffer */
+            p_msgs[done].result = p_msgs[done].len;
+        } else if (reterr != SXS_SUCCESS) {
+            break;
+        }
+        p_msgs[done].err = reterr;
+        reterr = SXS_SUCCESS;
+        done++;
+#endif
+    }
+
+    (*p_num_done) = done;
+
+    return (done > 0) ? SXS_SUCCESS : reterr;
+}
+
 sxs_error_t sxs_close(sxs_socket_t sd) {
     int r;
     sxs_errno_t errsv;
@@ -2003,3 +3161,49 @@ void sxs_perror(const char *s, sxs_error_t errnum) {
 
     return;
 }
+
+sxs_error_t sxs_map_errno(sxs_errno_t errsv) {
+    int i;
+
+#ifdef WIN32
+    for (i = 0; i < SXS_UNIXBOTH_ERRMAP_SIZE; i++) {
+        if (sxs_winboth_errmap[i] == errsv) {
+            return SXS_UNIXWIN_ERR_START + i;
+        }
+    }
+
+    for (i = 0; i < SXS_WIN_ERRMAP_SIZE; i++) {
+        if (sxs_win_errmap[i] == errsv) {
+            return SXS_WIN_ERR_START + i;
+        }
+    }
+#else
+    for (i = 0; i < SXS_UNIXBOTH_ERRMAP_SIZE; i++) {
+        if (sxs_unixboth_errmap[i] == errsv) {
+            return SXS_UNIXWIN_ERR_START + i;
+        }
+    }
+
+    for (i = 0; i < SXS_UNIXMAC_ERRMAP_SIZE; i++) {
+        if (sxs_unixmac_errmap[i] == errsv) {
+            return SXS_UNIXMAC_ERR_START + i;
+        }
+    }
+
+    #ifdef __APPLE__
+    for (i = 0; i < SXS_MAC_ERRMAP_SIZE; i++) {
+        if (sxs_mac_errmap[i] == errsv) {
+            return SXS_MAC_ERR_START + i;
+        }
+    }
+    #else
+    for (i = 0; i < SXS_UNIX_ERRMAP_SIZE; i++) {
+        if (sxs_unix_errmap[i] == errsv) {
+            return SXS_UNIX_ERR_START + i;
+        }
+    }
+    #endif
+#endif
+
+    return SXS_UNKNOWN_ERROR;
+}
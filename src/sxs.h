@@ -49,6 +49,128 @@ extern "C" {
  */
 SXS_EXPORT sxs_error_t sxs_init(void);
 
+/**
+ * @def SXS_ENGINE_DEFAULT
+ * @brief A macro used to identify the default engine.
+ *
+ * The default engine implements each sxs function with the equivalent
+ * system call.
+ */
+#define SXS_ENGINE_DEFAULT 0
+
+/**
+ * @def SXS_ENGINE_URING
+ * @brief A macro used to identify the io_uring engine.
+ *
+ * The io_uring engine makes sxs_send(), sxs_recv(), sxs_sendto() and
+ * sxs_recvfrom() wait on an io_uring owned by the calling thread when
+ * they would block, on sockets in blocking mode without a send or
+ * receive timeout. Calls which do not have to wait, and all others, use
+ * the system calls. It is only available on Linux 5.6 or newer. To
+ * batch many operations into a single system call use the API in
+ * sxs_uring.h directly.
+ */
+#define SXS_ENGINE_URING 1
+
+/**
+ * @def SXS_MEM_HUGEPAGES
+ * @brief A memory policy flag asking for huge pages.
+ *
+ * The SXS_MEM_HUGEPAGES flag backs I/O buffers of 2 MiB or more with
+ * huge pages, rounding them up to a multiple of the huge page size.
+ * Pages reserved for huge page mappings are used if there are any, and
+ * transparent huge pages otherwise. With Windows it needs the lock
+ * pages in memory privilege. Ring buffers keep normal pages, as they
+ * are made of shared memory mapped twice.
+ */
+#define SXS_MEM_HUGEPAGES 0x01
+
+/**
+ * @def SXS_MEM_NUMA
+ * @brief A memory policy flag binding memory to a NUMA node.
+ *
+ * The SXS_MEM_NUMA flag binds I/O buffers to the NUMA node given by the
+ * 'mem_node' member of sxs_init_opts_t, typically the node the network
+ * interface and the threads serving it are attached to.
+ */
+#define SXS_MEM_NUMA 0x02
+
+/**
+ * @def SXS_MEM_PREFAULT
+ * @brief A memory policy flag prefaulting memory.
+ *
+ * The SXS_MEM_PREFAULT flag touches every page of an I/O buffer when it
+ * is allocated, so that the first receives into it do not take page
+ * faults.
+ */
+#define SXS_MEM_PREFAULT 0x04
+
+/**
+ * @def SXS_MEM_LOCK
+ * @brief A memory policy flag locking memory.
+ *
+ * The SXS_MEM_LOCK flag locks I/O buffers in memory, as mlock() does, so
+ * that they are never paged out. The lock is subject to the memory
+ * locking limit of the process.
+ */
+#define SXS_MEM_LOCK 0x08
+
+/**
+ * @typedef sxs_init_opts_t
+ * @brief Library initialization options.
+ *
+ * The sxs_init_opts_t type is a structure holding the options passed to
+ * sxs_init_ex(). The 'engine' member selects the engine, one of the
+ * SXS_ENGINE_* values. The 'uring_entries' member is the number of
+ * submission queue entries of each io_uring created by the io_uring
+ * engine, or 0 for the default. The 'mem_flags' member is the memory
+ * policy of the I/O buffers lib_sxs allocates itself, for read and
+ * write buffers, ring buffers and buffer pools, as one or more OR'd
+ * SXS_MEM_* flags, and 'mem_node' is the NUMA node used with
+ * SXS_MEM_NUMA. The policy is best effort: memory the system cannot
+ * provide as asked is allocated without the part it cannot honour.
+ * Members which are not used should be zeroed.
+ */
+typedef struct sxs_init_opts {
+    int engine;
+    unsigned int uring_entries;
+    int mem_flags;
+    int mem_node;
+} sxs_init_opts_t;
+
+/**
+ * Initialize the library with options.
+ *
+ * The sxs_init_ex() function behaves like sxs_init() except that it also
+ * applies the given options. If 'p_opts' is NULL it is equivalent to
+ * sxs_init(). If the requested engine is not available on this system
+ * the library silently falls back to the default engine, sxs_engine()
+ * may be used to find out which engine is in use.
+ * @param p_opts Pointer to the options to initialize the library with.
+ * @return A a value representing an error or success.
+ * @retval SXS_SUCCESS Successfully initialized the library.
+ * @retval SXS_WSASYSNOTREADY Network subsystem is not ready for comm.
+ * @retval SXS_WSAVERNOTSUPPORTED Version of Winsock is not supported.
+ * @retval SXS_EINPROGRESS A blocking call is in progress.
+ * @retval SXS_WSAEPROCLIM Max number of processes has been hit.
+ * @retval SXS_EFAULT One of the internal parameters was not a valid
+ * pointer.
+ * @retval SXS_EINVAL The 'engine' option is not a known engine, the
+ * 'mem_flags' option has unknown flags or the 'mem_node' option is not
+ * a valid node number.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_init_ex(const sxs_init_opts_t *p_opts);
+
+/**
+ * Get the engine in use.
+ *
+ * The sxs_engine() function returns the engine selected when the
+ * library was initialized, one of the SXS_ENGINE_* values.
+ * @return The engine in use.
+ */
+SXS_EXPORT int sxs_engine(void);
+
 /**
  * Uninitialize the library.
  *
@@ -73,7 +195,9 @@ SXS_EXPORT sxs_error_t sxs_uninit(void);
  * address family). Acceptable values for the 'domain' are the
  * following, SXS_AF_INET, and SXS_AF_UNIX. The 'type' parameter specifies the
  * communication semantics to use given one of the following types,
- * SXS_SOCK_STREAM, SXS_SOCK_DGRAM, SXS_SOCK_SEQPACKET, SXS_SOCK_RAW, and SXS_SOCK_RDM. The
+ * SXS_SOCK_STREAM, SXS_SOCK_DGRAM, SXS_SOCK_SEQPACKET, SXS_SOCK_RAW, and SXS_SOCK_RDM,
+ * optionally OR'd with SXS_SOCK_NONBLOCK and SXS_SOCK_CLOEXEC to create
+ * the socket non-blocking and close-on-exec in a single step. The
  * 'protocol' parameter specifies a particular protocol to be used with
  * the socket. Normally only a single protocol exists to support a
  * particular socket type within a given protocol family, in which case
@@ -205,6 +329,29 @@ SXS_EXPORT sxs_error_t sxs_listen(sxs_socket_t sd, int backlog);
 SXS_EXPORT sxs_error_t sxs_accept(sxs_socket_t sd, sxs_sockaddr_t *addr,
     sxs_socklen_t *addrlen, sxs_socket_t *p_sd);
 
+/**
+ * Accept a connection on a socket and set flags on the new socket.
+ *
+ * The sxs_accept4() function behaves like sxs_accept() and additionally
+ * applies the OR'd SXS_SOCK_NONBLOCK and SXS_SOCK_CLOEXEC 'flags' to the
+ * accepted socket. Where the system has accept4() this is done by the
+ * accept itself, saving the system calls it would otherwise take to
+ * set them afterwards, which is how it is done elsewhere.
+ * @param sd The socket descriptor of the socket to accept connection on.
+ * @param addr Pointer to sockaddr struct to store the peers address in.
+ * @param addrlen A value-result parameter, initialized to the size of
+ * the buffer associated with 'addr', and modified on return to indicate
+ * the actual size of the address stored there.
+ * @param flags Zero or more OR'd SXS_SOCK_NONBLOCK and SXS_SOCK_CLOEXEC.
+ * @param p_sd Pointer to socket descriptor to store the new socket in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_accept().
+ * @retval SXS_SUCCESS Successfully accepted a connection.
+ * @retval SXS_EINVAL The 'flags' parameter contains unknown flags.
+ */
+SXS_EXPORT sxs_error_t sxs_accept4(sxs_socket_t sd, sxs_sockaddr_t *addr,
+    sxs_socklen_t *addrlen, int flags, sxs_socket_t *p_sd);
+
 /**
  * Connect the specified socket to the specified address.
  *
@@ -467,6 +614,206 @@ SXS_EXPORT sxs_error_t sxs_send_nbytes(sxs_socket_t sd, const sxs_buf_t buf,
 SXS_EXPORT sxs_error_t sxs_send_nbytes_nb(sxs_socket_t sd,
     const sxs_buf_t buf, sxs_size_t len, const struct timeval *p_timeout);
 
+/**
+ * Send a specified number of bytes before a deadline.
+ *
+ * The sxs_send_nbytes_dl() function behaves like sxs_send_nbytes_nb()
+ * except that 'deadline_ms' bounds the whole transfer rather than each
+ * wait for the socket to be ready. It is an absolute point in time on
+ * the clock of sxs_monotonic_ms(), and the time left until it is
+ * recomputed before every wait, so a peer accepting only a few bytes at
+ * a time can not hold the caller beyond it. The same deadline may be
+ * passed to several calls to bound a whole exchange.
+ * @param sd The socket descriptor of the socket to send bytes on.
+ * @param buf The pointer to the buffer containing the data to send.
+ * @param len The number of bytes to send over the socket.
+ * @param deadline_ms The monotonic time, in milliseconds, by which all
+ * the bytes must have been sent.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully sent all the data on the socket.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets
+ * non-blocking/blocking state.
+ * @retval SXS_ERRSELECTFAIL Failed to monitor socket descriptor for
+ * being ready for sending.
+ * @retval SXS_ERRSENDTIMEDOUT The deadline passed before all the data
+ * was sent.
+ * @retval SXS_ERRSENDFAIL Failed to send data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_send_nbytes_dl(sxs_socket_t sd,
+    const sxs_buf_t buf, sxs_size_t len, sxs_uint64_t deadline_ms);
+
+/**
+ * Send data without blocking and without changing the I/O mode.
+ *
+ * The sxs_send_dontwait() function behaves like sxs_send_nb() except
+ * that it leaves the I/O mode of the socket alone and instead passes
+ * MSG_DONTWAIT to each send. It is therefore safe to use on a socket
+ * another thread is using in blocking mode, and costs no system call
+ * beyond the send itself when the socket has room. The socket is only
+ * waited on, for up to 'p_timeout', when it is full. Where MSG_DONTWAIT
+ * is not available, e.g. on Windows, the I/O mode is switched for the
+ * duration of the call as sxs_send_nb() does.
+ * @param sd The socket descriptor of the socket to send bytes on.
+ * @param buf The pointer to the buffer containing data to send.
+ * @param len The number of bytes to attempt to send over the socket.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for waiting for the socket to be ready to send data on.
+ * @param p_sent Pointer to var to store resulting num of bytes sent.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully sent the data on the socket.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets
+ * non-blocking/blocking state.
+ * @retval SXS_ERRSELECTFAIL Failed to monitor socket descriptor for
+ * being ready for sending.
+ * @retval SXS_ERRSENDTIMEDOUT Timed out waiting for the socket to be
+ * ready for sending.
+ * @retval SXS_ERRSENDFAIL Failed to send data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_send_dontwait(sxs_socket_t sd,
+    const sxs_buf_t buf, sxs_size_t len, int flags,
+    const struct timeval *p_timeout, sxs_ssize_t *p_sent);
+
+/**
+ * Send a specified number of bytes without changing the I/O mode.
+ *
+ * The sxs_send_nbytes_dontwait() function behaves like
+ * sxs_send_nbytes_nb() except that it leaves the I/O mode of the socket
+ * alone and instead passes MSG_DONTWAIT to each send, as
+ * sxs_send_dontwait() does.
+ * @param sd The socket descriptor of the socket to send bytes on.
+ * @param buf The pointer to the buffer containing the data to send.
+ * @param len The number of bytes to send over the socket.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for the socket to be ready for sending.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_send_dontwait().
+ * @retval SXS_SUCCESS Successfully sent all the data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_send_nbytes_dontwait(sxs_socket_t sd,
+    const sxs_buf_t buf, sxs_size_t len, const struct timeval *p_timeout);
+
+/**
+ * Send data gathered from several buffers.
+ *
+ * The sxs_sendv() function behaves like sxs_send() except that the data
+ * to send is gathered from the 'iovcnt' buffers described by the array
+ * 'p_iov', in order, so that a header, a payload and a trailer held in
+ * separate buffers are sent with a single system call and without first
+ * copying them together. At most SXS_IOV_MAX buffers may be given. Like
+ * sxs_send() it may send fewer bytes than the buffers hold.
+ * @param sd The socket descriptor of the socket to send bytes on.
+ * @param p_iov Pointer to the array of buffers containing data to send.
+ * @param iovcnt The number of buffers in the array.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_sent Pointer to var to store resulting num of bytes sent.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_send(), and SXS_EMSGSIZE if 'iovcnt' is
+ * larger than the system supports.
+ * @retval SXS_SUCCESS Successfully sent the data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_sendv(sxs_socket_t sd, const sxs_iovec_t *p_iov,
+    int iovcnt, int flags, sxs_ssize_t *p_sent);
+
+/**
+ * Send all the data gathered from several buffers.
+ *
+ * The sxs_sendv_nbytes() function is the vectored counterpart of
+ * sxs_send_nbytes(). It calls sxs_sendv() until every byte of the
+ * 'iovcnt' buffers described by 'p_iov' has been sent, resuming each
+ * time from the byte of the buffer a partial send stopped within. The
+ * array may be longer than SXS_IOV_MAX. The buffer a send resumes
+ * within is adjusted in place for the duration of that send, so the
+ * array must not be shared with another thread during the call, but it
+ * is left unchanged when the function returns.
+ * @param sd The socket descriptor of the socket to send bytes on.
+ * @param p_iov Pointer to the array of buffers containing data to send.
+ * @param iovcnt The number of buffers in the array.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_sendv().
+ * @retval SXS_SUCCESS Successfully sent all the data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_sendv_nbytes(sxs_socket_t sd, sxs_iovec_t *p_iov,
+    int iovcnt);
+
+/**
+ * Send data from a file.
+ *
+ * The sxs_sendfile() function sends up to 'count' bytes of the file
+ * 'fd', starting at byte 'offset' of the file, on the socket 'sd'. The
+ * file's own offset is not used and, on Unix, not changed. Where the
+ * system has a sendfile() call the kernel moves the data straight from
+ * the page cache to the socket without copying it through userspace.
+ * Elsewhere the data is read in chunks and sent with sxs_send(). Like
+ * sxs_send() it may send fewer bytes than requested, in which case the
+ * caller continues from 'offset' plus the bytes sent, and if the socket
+ * is non-blocking and full it fails with SXS_EWOULDBLOCK. At the end of
+ * the file 0 bytes are sent.
+ * @param sd The socket descriptor of the socket to send bytes on.
+ * @param fd The file descriptor of the file to send, a regular file.
+ * @param offset The offset in the file of the first byte to send.
+ * @param count The number of bytes to attempt to send.
+ * @param p_sent Pointer to var to store resulting num of bytes sent.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_send(), along with those of reading the file.
+ * @retval SXS_SUCCESS Successfully sent data on the socket.
+ * @retval SXS_EWOULDBLOCK The socket is non-blocking and full.
+ * @retval SXS_EINVAL The file does not support sendfile(), e.g. it is a
+ * pipe, the socket is not a stream socket, or 'offset' is larger than
+ * the system's file offsets can hold.
+ */
+SXS_EXPORT sxs_error_t sxs_sendfile(sxs_socket_t sd, int fd,
+    sxs_uint64_t offset, sxs_size_t count, sxs_ssize_t *p_sent);
+
+/**
+ * Send a specified number of bytes from a file.
+ *
+ * The sxs_sendfile_nbytes() function is the file counterpart of
+ * sxs_send_nbytes(). It calls sxs_sendfile() until exactly 'count'
+ * bytes of the file 'fd' starting at 'offset' have been sent on the
+ * blocking socket 'sd'.
+ * @param sd The socket descriptor of the socket to send bytes on.
+ * @param fd The file descriptor of the file to send, a regular file.
+ * @param offset The offset in the file of the first byte to send.
+ * @param count The number of bytes to send.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_sendfile().
+ * @retval SXS_SUCCESS Successfully sent all the data on the socket.
+ * @retval SXS_ERRFILEEOF The file ended before 'count' bytes were sent.
+ */
+SXS_EXPORT sxs_error_t sxs_sendfile_nbytes(sxs_socket_t sd, int fd,
+    sxs_uint64_t offset, sxs_size_t count);
+
+/**
+ * Send a specified number of bytes from a file in non-blocking mode.
+ *
+ * The sxs_sendfile_nbytes_nb() function is the file counterpart of
+ * sxs_send_nbytes_nb(). It sets the socket 'sd' to non-blocking I/O
+ * mode, sends exactly 'count' bytes of the file 'fd' starting at
+ * 'offset', waiting up to 'p_timeout' whenever the socket is full, and
+ * sets the socket back to blocking mode before returning.
+ * @param sd The socket descriptor of the socket to send bytes on.
+ * @param fd The file descriptor of the file to send, a regular file.
+ * @param offset The offset in the file of the first byte to send.
+ * @param count The number of bytes to send.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for the socket to be ready for sending.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully sent all the data on the socket.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets
+ * non-blocking/blocking state.
+ * @retval SXS_ERRSELECTFAIL Failed to monitor socket descriptor for
+ * being ready for sending.
+ * @retval SXS_ERRSENDTIMEDOUT Timed out waiting for the socket to be
+ * ready for sending.
+ * @retval SXS_ERRSENDFAIL Failed to send data on the socket.
+ * @retval SXS_ERRFILEEOF The file ended before 'count' bytes were sent.
+ */
+SXS_EXPORT sxs_error_t sxs_sendfile_nbytes_nb(sxs_socket_t sd, int fd,
+    sxs_uint64_t offset, sxs_size_t count, const struct timeval *p_timeout);
+
 /**
  * Transmit a message to another socket.
  *
@@ -669,6 +1016,195 @@ SXS_EXPORT sxs_error_t sxs_recv_nbytes(sxs_socket_t sd, sxs_buf_t buf,
 SXS_EXPORT sxs_error_t sxs_recv_nbytes_nb(sxs_socket_t sd, sxs_buf_t buf,
     sxs_size_t len, const struct timeval *p_timeout);
 
+/**
+ * Receive a specified number of bytes before a deadline.
+ *
+ * The sxs_recv_nbytes_dl() function behaves like sxs_recv_nbytes_nb()
+ * except that 'deadline_ms' bounds the whole transfer rather than each
+ * wait for data to become available. It is an absolute point in time on
+ * the clock of sxs_monotonic_ms(), and the time left until it is
+ * recomputed before every wait, so a peer trickling a few bytes at a
+ * time can not hold the caller beyond it. The same deadline may be
+ * passed to several calls to bound a whole exchange.
+ * @param sd The socket descriptor of the socket to receive bytes on.
+ * @param buf The pointer to the buffer to store received data in.
+ * @param len The number of bytes to receive over the socket.
+ * @param deadline_ms The monotonic time, in milliseconds, by which all
+ * the bytes must have been received.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully received all the data on the socket.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets
+ * non-blocking/blocking state.
+ * @retval SXS_ERRSELECTFAIL Failed to monitor socket descriptor for
+ * available data.
+ * @retval SXS_ERRRECVTIMEDOUT The deadline passed before all the data
+ * was received.
+ * @retval SXS_ERRRECVFAIL Failed to receive data from the socket.
+ * @retval SXS_ERRCONNCLOSED Peer closed socket before finished
+ * receiving all the data.
+ */
+SXS_EXPORT sxs_error_t sxs_recv_nbytes_dl(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, sxs_uint64_t deadline_ms);
+
+/**
+ * Receive data without blocking and without changing the I/O mode.
+ *
+ * The sxs_recv_dontwait() function behaves like sxs_recv_nb() except
+ * that it leaves the I/O mode of the socket alone and instead passes
+ * MSG_DONTWAIT to each receive. It is therefore safe to use on a socket
+ * another thread is using in blocking mode, and costs no system call
+ * beyond the receive itself when data is queued. The socket is only
+ * waited on, for up to 'p_timeout', when no data is queued. Where
+ * MSG_DONTWAIT is not available, e.g. on Windows, the I/O mode is
+ * switched for the duration of the call as sxs_recv_nb() does.
+ * @param sd The socket descriptor of the socket to receive bytes on.
+ * @param buf The pointer to the buffer to store received data in.
+ * @param len The size of the buffer in bytes.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for waiting for data to be available on the socket.
+ * @param p_recvd Pointer to var to store resulting num of bytes
+ * received.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully received data from the socket.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets
+ * non-blocking/blocking state.
+ * @retval SXS_ERRSELECTFAIL Failed to monitor socket descriptor for
+ * available data.
+ * @retval SXS_ERRRECVTIMEDOUT Timed out waiting for data to become
+ * available on the socket descriptor.
+ * @retval SXS_ERRRECVFAIL Failed to receive data from the socket.
+ * @retval SXS_ERRCONNCLOSED Peer closed the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_recv_dontwait(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    sxs_ssize_t *p_recvd);
+
+/**
+ * Receive a specified number of bytes without changing the I/O mode.
+ *
+ * The sxs_recv_nbytes_dontwait() function behaves like
+ * sxs_recv_nbytes_nb() except that it leaves the I/O mode of the socket
+ * alone and instead passes MSG_DONTWAIT to each receive, as
+ * sxs_recv_dontwait() does.
+ * @param sd The socket descriptor of the socket to receive bytes on.
+ * @param buf The pointer to the buffer to store received data in.
+ * @param len The number of bytes to receive over the socket.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for data to be available on the socket.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recv_dontwait().
+ * @retval SXS_SUCCESS Successfully received all the data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_recv_nbytes_dontwait(sxs_socket_t sd,
+    sxs_buf_t buf, sxs_size_t len, const struct timeval *p_timeout);
+
+/**
+ * Receive data scattered into several buffers.
+ *
+ * The sxs_recvv() function behaves like sxs_recv() except that the data
+ * received is scattered into the 'iovcnt' buffers described by the
+ * array 'p_iov', filling each before moving on to the next, so that for
+ * example a fixed size header and the start of a payload are received
+ * into separate buffers with a single system call. At most SXS_IOV_MAX
+ * buffers may be given.
+ * @param sd The socket descriptor of the socket to receive bytes on.
+ * @param p_iov Pointer to the array of buffers to store received data
+ * in.
+ * @param iovcnt The number of buffers in the array.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_recvd Pointer to var to store resulting num of bytes recv'd,
+ * which is 0 if the peer has closed the connection.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recv(), and SXS_EMSGSIZE if 'iovcnt' is
+ * larger than the system supports.
+ * @retval SXS_SUCCESS Successfully received data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_recvv(sxs_socket_t sd, const sxs_iovec_t *p_iov,
+    int iovcnt, int flags, sxs_ssize_t *p_recvd);
+
+/**
+ * Receive data filling several buffers completely.
+ *
+ * The sxs_recvv_nbytes() function is the vectored counterpart of
+ * sxs_recv_nbytes(). It calls sxs_recvv() until every one of the
+ * 'iovcnt' buffers described by 'p_iov' is full, resuming each time at
+ * the byte of the buffer a partial receive stopped within. The array is
+ * adjusted in place and restored as described for sxs_sendv_nbytes().
+ * @param sd The socket descriptor of the socket to receive bytes on.
+ * @param p_iov Pointer to the array of buffers to store received data
+ * in.
+ * @param iovcnt The number of buffers in the array.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recvv().
+ * @retval SXS_SUCCESS Successfully received all the data on the socket.
+ * @retval SXS_ERRCONNCLOSED Peer closed connection before finished.
+ */
+SXS_EXPORT sxs_error_t sxs_recvv_nbytes(sxs_socket_t sd, sxs_iovec_t *p_iov,
+    int iovcnt);
+
+/**
+ * Receive a specified number of bytes from the socket into a file.
+ *
+ * The sxs_recv_to_file() function is the reverse of sxs_sendfile(). It
+ * receives exactly 'count' bytes from the socket 'sd' and writes them
+ * to the file 'fd' at its current offset. On Linux the data is moved
+ * through a pipe with splice(), so it is never copied through
+ * userspace; elsewhere, or for files that do not support it such as
+ * ones opened with O_APPEND, it is received into a buffer and written.
+ * As with sxs_recv_nbytes() a stream that ends early is reported as
+ * SXS_ERRCONNCLOSED. The number of bytes written to the file is passed
+ * back via 'p_written' in every case, which allows receiving up to
+ * 'count' bytes or until the end of the stream. Should writing the file
+ * fail, the bytes of the chunk being moved which did not reach the file
+ * have already been received from the socket and are discarded, so the
+ * stream can not be resumed past 'p_written'.
+ * @param sd The socket descriptor of the socket to receive bytes on.
+ * @param fd The file descriptor of the file to write to.
+ * @param count The number of bytes to receive.
+ * @param p_written Pointer to var to store the number of bytes written
+ * in, may be NULL.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recv(), along with those of writing the file.
+ * @retval SXS_SUCCESS Successfully received all the data into the file.
+ * @retval SXS_ERRCONNCLOSED Peer closed connection before finished.
+ */
+SXS_EXPORT sxs_error_t sxs_recv_to_file(sxs_socket_t sd, int fd,
+    sxs_size_t count, sxs_size_t *p_written);
+
+/**
+ * Receive a specified number of bytes into a file in non-blocking mode.
+ *
+ * The sxs_recv_to_file_nb() function is to sxs_recv_to_file() what
+ * sxs_recv_nbytes_nb() is to sxs_recv_nbytes(). It sets the socket to
+ * non-blocking I/O mode, receives exactly 'count' bytes into the file
+ * waiting up to 'p_timeout' whenever no data is available, and sets
+ * the socket back to blocking mode before returning.
+ * @param sd The socket descriptor of the socket to receive bytes on.
+ * @param fd The file descriptor of the file to write to.
+ * @param count The number of bytes to receive.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for data to be available on the socket.
+ * @param p_written Pointer to var to store the number of bytes written
+ * in, may be NULL.
+ * @return A value representing an error or success. The possible
+ * errors also include those of writing the file.
+ * @retval SXS_SUCCESS Successfully received all the data into the file.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets
+ * non-blocking/blocking state.
+ * @retval SXS_ERRSELECTFAIL Failed to monitor socket descriptor for
+ * available data.
+ * @retval SXS_ERRRECVTIMEDOUT Timed out waiting for data to become
+ * available on the socket descriptor.
+ * @retval SXS_ERRRECVFAIL Failed to receive data from the socket.
+ * @retval SXS_ERRCONNCLOSED Peer closed connection before finished.
+ */
+SXS_EXPORT sxs_error_t sxs_recv_to_file_nb(sxs_socket_t sd, int fd,
+    sxs_size_t count, const struct timeval *p_timeout,
+    sxs_size_t *p_written);
+
 /**
  * Receive a message from a socket.
  *
@@ -728,6 +1264,85 @@ SXS_EXPORT sxs_error_t sxs_recvfrom(sxs_socket_t sd, sxs_buf_t buf,
     sxs_size_t len, int flags, sxs_sockaddr_t *from,
     sxs_socklen_t *fromlen, sxs_ssize_t *p_recvd);
 
+/**
+ * @typedef sxs_mmsg_t
+ * @brief A datagram of a batch.
+ *
+ * The sxs_mmsg_t type is a structure describing one datagram of a batch
+ * sent with sxs_sendmmsg() or received with sxs_recvmmsg(). The 'buf'
+ * and 'len' members give the buffer holding or receiving the datagram.
+ * The 'addr' member points to the address to send it to or to store the
+ * sender's address in, with 'addrlen' its size, or is NULL for a
+ * connected socket. On return 'result' holds the number of bytes sent
+ * or received and 'err' the outcome for this datagram alone, and for a
+ * received datagram 'addrlen' holds the size of the sender's address.
+ */
+typedef struct sxs_mmsg {
+    sxs_buf_t buf;
+    sxs_size_t len;
+    sxs_sockaddr_t *addr;
+    sxs_socklen_t addrlen;
+    sxs_ssize_t result;
+    sxs_error_t err;
+} sxs_mmsg_t;
+
+/**
+ * Transmit a batch of datagrams.
+ *
+ * The sxs_sendmmsg() function sends the 'num' datagrams described by
+ * the array 'p_msgs', each as if by sxs_sendto(), but hands them to the
+ * system many at a time with sendmmsg() where it is available, so that
+ * a batch costs a system call rather than one per datagram. Elsewhere
+ * the datagrams are sent one by one. The number of datagrams processed
+ * is passed back via 'p_num_done'. A datagram that fails for a reason
+ * of its own, e.g. SXS_EMSGSIZE or an unreachable destination, has the
+ * error stored in its 'err' member and the rest of the batch is still
+ * sent. Any other error, e.g. SXS_EWOULDBLOCK when the socket is full,
+ * stops the batch. It is returned if no datagram was processed, and
+ * otherwise left for the next call to report.
+ * @param sd The socket descriptor of the socket to send datagrams on.
+ * @param p_msgs Pointer to the array of datagrams to send.
+ * @param num The number of datagrams in the array.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_num_done Pointer to var to store the number of datagrams
+ * processed in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_sendto().
+ * @retval SXS_SUCCESS Successfully processed at least one datagram, or
+ * 'num' is 0.
+ */
+SXS_EXPORT sxs_error_t sxs_sendmmsg(sxs_socket_t sd, sxs_mmsg_t *p_msgs,
+    int num, int flags, int *p_num_done);
+
+/**
+ * Receive a batch of datagrams.
+ *
+ * The sxs_recvmmsg() function receives up to 'num' datagrams into the
+ * array 'p_msgs', each as if by sxs_recvfrom(), with recvmmsg() where it
+ * is available so that a batch costs a system call rather than one per
+ * datagram. Only the first datagram is waited for, blocking as
+ * sxs_recvfrom() would, after which the function takes only datagrams
+ * already queued on the socket. The number of datagrams received is
+ * passed back via 'p_num_done'. A datagram too large for its buffer is
+ * truncated and, where the system reports it, has SXS_EMSGSIZE stored
+ * in its 'err' member. An error after at least one datagram was
+ * received is left for the next call to report.
+ * @param sd The socket descriptor of the socket to receive datagrams on.
+ * @param p_msgs Pointer to the array of datagrams to receive into.
+ * @param num The number of datagrams in the array.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_num_done Pointer to var to store the number of datagrams
+ * received in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recvfrom().
+ * @retval SXS_SUCCESS Successfully received at least one datagram, or
+ * 'num' is 0.
+ */
+SXS_EXPORT sxs_error_t sxs_recvmmsg(sxs_socket_t sd, sxs_mmsg_t *p_msgs,
+    int num, int flags, int *p_num_done);
+
 /**
  * Close the socket associated with the given socket descriptor.
  *
@@ -916,7 +1531,11 @@ SXS_EXPORT sxs_uint16_t sxs_ntohs(sxs_uint16_t netshort);
  * descriptor from the given set. FD_ISSET() returns a non-zero value if
  * the specified socket descriptor is part of the given set, otherwise
  * zero is returned. FD_SET() adds the specified descriptor to the given
- * set.  FD_ZERO() initializes a set to a NULL or empty set.
+ * set.  FD_ZERO() initializes a set to a NULL or empty set. Note: The
+ * fd_set structures can not hold socket descriptors whose value is
+ * FD_SETSIZE or greater, and the cost of each call grows with 'nfds'.
+ * Applications monitoring many sockets should use the poller API found
+ * in sxs_poll.h instead.
  * @param nfds The highest-numbered socket descriptor in any of the
  * three sets plus 1.
  * @param readfds Pointer to set of sockets to be checked for
@@ -0,0 +1,648 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_bufpool.c
+ * @brief This is an implementation file for the lib_sxs buffer pool API.
+ *
+ * The sxs_bufpool.c file is an implementation file which contains all
+ * the definitions for the functions which compose the buffer pool API
+ * of lib_sxs.
+ *
+ * The global free list of each class is a stack of batches, each a
+ * chain of buffers. Its head holds the id of the first batch rather
+ * than a pointer, next to a tag bumped by every change, so that both
+ * fit in a single 64 bit compare and swap and a batch popped and pushed
+ * back meanwhile cannot be mistaken for an unchanged head. Ids are
+ * mapped back to buffers through a table of chunks which are never
+ * freed before the pool, so a stale id still names a valid buffer.
+ */
+
+#include "sxs_bufpool.h"
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+#ifndef WIN32
+    #include <pthread.h>
+#endif
+
+/* Windows builds are made with MinGW, so the GCC atomic builtins are
+ * available on every system lib_sxs is built for. */
+#define SXS_BUFPOOL_LOAD_ACQ(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SXS_BUFPOOL_LOAD_RLX(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define SXS_BUFPOOL_STORE_REL(p, v) \
+    __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define SXS_BUFPOOL_STORE_RLX(p, v) \
+    __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define SXS_BUFPOOL_CAS(p, p_old, v) \
+    __atomic_compare_exchange_n((p), (p_old), (v), 1, __ATOMIC_ACQ_REL, \
+        __ATOMIC_ACQUIRE)
+#define SXS_BUFPOOL_ADD(p, v) __atomic_add_fetch((p), (v), __ATOMIC_ACQ_REL)
+
+/* Buffer ids are looked up in a table of up to this many chunks of
+ * 2^SXS_BUFPOOL_CHUNK_SHIFT buffers each. Id 0 means no buffer. */
+#define SXS_BUFPOOL_CHUNK_SHIFT 12
+#define SXS_BUFPOOL_CHUNK_SIZE (1 << SXS_BUFPOOL_CHUNK_SHIFT)
+#define SXS_BUFPOOL_MAX_CHUNKS 4096
+
+#define SXS_BUFPOOL_DEF_MIN_SIZE 512
+#define SXS_BUFPOOL_DEF_MAX_SIZE 65536
+#define SXS_BUFPOOL_DEF_CACHE_COUNT 64
+#define SXS_BUFPOOL_DEF_BATCH_COUNT 16
+
+/* The 'p_next' member links a buffer into the cache of a thread or into
+ * its batch, and is only touched by the thread owning it. The
+ * 'next_batch' member links the first buffer of a batch to the next
+ * batch on the global list and is read by racing threads. */
+struct sxs_pbuf {
+    sxs_bufpool_t *p_pool;
+    struct sxs_pbuf *p_next;
+    char *p_data;
+    sxs_size_t size;
+    sxs_uint32_t refs;
+    sxs_uint32_t id;
+    sxs_uint32_t next_batch;
+    unsigned int batch_len;
+    int cls;
+};
+
+/* The buffers of a class allocated together on a miss. */
+struct sxs_bufpool_slab {
+    struct sxs_bufpool_slab *p_next;
+    sxs_mem_t mem;
+};
+
+/* The counters of a cache are only written by the thread owning it, so
+ * they are bumped without a locked instruction and merely read
+ * atomically by sxs_bufpool_stats(). */
+struct sxs_bufpool_cache {
+    sxs_bufpool_t *p_pool;
+    struct sxs_bufpool_cache *p_next;
+    sxs_uint32_t in_use;
+    sxs_pbuf_t *p_free[SXS_BUFPOOL_MAX_CLASSES];
+    unsigned int num_free[SXS_BUFPOOL_MAX_CLASSES];
+    sxs_uint64_t gets;
+    sxs_uint64_t cache_hits;
+    sxs_uint64_t global_hits;
+    sxs_uint64_t misses;
+    sxs_uint64_t oversize;
+    sxs_uint64_t releases;
+    sxs_uint64_t allocated;
+};
+
+struct sxs_bufpool {
+    unsigned int cache_count;
+    unsigned int batch_count;
+    int num_classes;
+    sxs_size_t class_size[SXS_BUFPOOL_MAX_CLASSES];
+    sxs_uint64_t heads[SXS_BUFPOOL_MAX_CLASSES];
+    sxs_uint32_t next_id;
+    int destroying;
+    struct sxs_bufpool_slab *p_slabs;
+    struct sxs_bufpool_cache *p_caches;
+#ifdef WIN32
+    DWORD cache_key;
+#else
+    pthread_key_t cache_key;
+#endif
+    sxs_pbuf_t **pp_chunks[SXS_BUFPOOL_MAX_CHUNKS];
+};
+
+#define SXS_BUFPOOL_COUNT(p_cache, field) \
+    SXS_BUFPOOL_STORE_RLX(&(p_cache)->field, \
+        (SXS_BUFPOOL_LOAD_RLX(&(p_cache)->field) + 1))
+
+static sxs_pbuf_t *sxs_bufpool_lookup(sxs_bufpool_t *p_pool,
+    sxs_uint32_t id) {
+
+    sxs_pbuf_t **pp_chunk;
+
+    pp_chunk = SXS_BUFPOOL_LOAD_ACQ(
+        &p_pool->pp_chunks[id >> SXS_BUFPOOL_CHUNK_SHIFT]);
+
+    return pp_chunk[id & (SXS_BUFPOOL_CHUNK_SIZE - 1)];
+}
+
+/* Push the batch of 'len' buffers starting with 'p_first' on the global
+ * list of its class. */
+static void sxs_bufpool_push(sxs_bufpool_t *p_pool, sxs_pbuf_t *p_first,
+    unsigned int len) {
+
+    sxs_uint64_t *p_head;
+    sxs_uint64_t old_head;
+    sxs_uint64_t new_head;
+
+    p_first->batch_len = len;
+    p_head = &p_pool->heads[p_first->cls];
+    old_head = SXS_BUFPOOL_LOAD_ACQ(p_head);
+    do {
+        SXS_BUFPOOL_STORE_RLX(&p_first->next_batch,
+            (sxs_uint32_t)old_head);
+        new_head = (((old_head >> 32) + 1) << 32) | p_first->id;
+    } while (!SXS_BUFPOOL_CAS(p_head, &old_head, new_head));
+}
+
+/* Pop a batch from the global list of the class 'cls', or return NULL
+ * if it is empty. */
+static sxs_pbuf_t *sxs_bufpool_pop(sxs_bufpool_t *p_pool, int cls) {
+    sxs_uint64_t *p_head;
+    sxs_uint64_t old_head;
+    sxs_uint64_t new_head;
+    sxs_pbuf_t *p_first;
+    sxs_uint32_t next;
+
+    p_head = &p_pool->heads[cls];
+    old_head = SXS_BUFPOOL_LOAD_ACQ(p_head);
+    do {
+        if ((sxs_uint32_t)old_head == 0) {
+            return NULL;
+        }
+        p_first = sxs_bufpool_lookup(p_pool, (sxs_uint32_t)old_head);
+        next = SXS_BUFPOOL_LOAD_RLX(&p_first->next_batch);
+        new_head = (((old_head >> 32) + 1) << 32) | next;
+    } while (!SXS_BUFPOOL_CAS(p_head, &old_head, new_head));
+
+    return p_first;
+}
+
+/* Hand the oldest 'batch_count' free buffers of the class 'cls' of the
+ * cache, or all of them if 'all' is set, to the global list. */
+static void sxs_bufpool_spill(struct sxs_bufpool_cache *p_cache, int cls,
+    int all) {
+
+    sxs_bufpool_t *p_pool;
+    sxs_pbuf_t *p_first;
+    sxs_pbuf_t *p_rest;
+    sxs_pbuf_t *p_buf;
+    unsigned int keep;
+    unsigned int len;
+    unsigned int i;
+
+    p_pool = p_cache->p_pool;
+    keep = 0;
+    if (!all) {
+        keep = p_cache->num_free[cls] - p_pool->batch_count;
+    }
+
+    if (keep == 0) {
+        p_first = p_cache->p_free[cls];
+        p_cache->p_free[cls] = NULL;
+    } else {
+        p_buf = p_cache->p_free[cls];
+        for (i = 1; i < keep; i++) {
+            p_buf = p_buf->p_next;
+        }
+        p_first = p_buf->p_next;
+        p_buf->p_next = NULL;
+    }
+    p_cache->num_free[cls] = keep;
+
+    while (p_first != NULL) {
+        p_buf = p_first;
+        for (len = 1; (len < p_pool->batch_count) &&
+            (p_buf->p_next != NULL); len++) {
+            p_buf = p_buf->p_next;
+        }
+        p_rest = p_buf->p_next;
+        p_buf->p_next = NULL;
+        sxs_bufpool_push(p_pool, p_first, len);
+        p_first = p_rest;
+    }
+}
+
+/* Return the buffers of a cache whose thread is exiting to the global
+ * lists, and leave the cache for the next thread to come along. */
+static void sxs_bufpool_cache_release(void *p_data) {
+    struct sxs_bufpool_cache *p_cache;
+    int cls;
+
+    p_cache = (struct sxs_bufpool_cache *)p_data;
+    if ((p_cache == NULL) || p_cache->p_pool->destroying) {
+        return;
+    }
+
+    for (cls = 0; cls < p_cache->p_pool->num_classes; cls++) {
+        sxs_bufpool_spill(p_cache, cls, 1);
+    }
+    SXS_BUFPOOL_STORE_REL(&p_cache->in_use, 0);
+}
+
+#ifdef WIN32
+static VOID WINAPI sxs_bufpool_fls_release(PVOID p_data) {
+    sxs_bufpool_cache_release(p_data);
+}
+#endif
+
+/* Get the cache of the calling thread, taking over the cache of an
+ * exited thread or creating one if it has none yet. */
+static struct sxs_bufpool_cache *sxs_bufpool_cache(sxs_bufpool_t *p_pool) {
+    struct sxs_bufpool_cache *p_cache;
+    struct sxs_bufpool_cache *p_head;
+    sxs_uint32_t unused;
+
+#ifdef WIN32
+    p_cache = (struct sxs_bufpool_cache *)FlsGetValue(p_pool->cache_key);
+#else
+    p_cache = (struct sxs_bufpool_cache *)pthread_getspecific(
+        p_pool->cache_key);
+#endif
+    if (p_cache != NULL) {
+        return p_cache;
+    }
+
+    p_cache = SXS_BUFPOOL_LOAD_ACQ(&p_pool->p_caches);
+    while (p_cache != NULL) {
+        unused = 0;
+        if ((SXS_BUFPOOL_LOAD_RLX(&p_cache->in_use) == 0) &&
+            SXS_BUFPOOL_CAS(&p_cache->in_use, &unused, 1)) {
+            break;
+        }
+        p_cache = p_cache->p_next;
+    }
+
+    if (p_cache == NULL) {
+        p_cache = (struct sxs_bufpool_cache *)calloc(1,
+            sizeof(struct sxs_bufpool_cache));
+        if (p_cache == NULL) {
+            return NULL;
+        }
+        p_cache->p_pool = p_pool;
+        p_cache->in_use = 1;
+
+        p_head = SXS_BUFPOOL_LOAD_ACQ(&p_pool->p_caches);
+        do {
+            p_cache->p_next = p_head;
+        } while (!SXS_BUFPOOL_CAS(&p_pool->p_caches, &p_head, p_cache));
+    }
+
+#ifdef WIN32
+    if (!FlsSetValue(p_pool->cache_key, p_cache)) {
+#else
+    if (pthread_setspecific(p_pool->cache_key, p_cache) != 0) {
+#endif
+        SXS_BUFPOOL_STORE_REL(&p_cache->in_use, 0);
+        return NULL;
+    }
+
+    return p_cache;
+}
+
+/* Make sure the chunk of the table holding 'id' exists. */
+static int sxs_bufpool_chunk(sxs_bufpool_t *p_pool, sxs_uint32_t id) {
+    sxs_pbuf_t **pp_chunk;
+    sxs_pbuf_t **pp_old;
+    sxs_uint32_t index;
+
+    index = id >> SXS_BUFPOOL_CHUNK_SHIFT;
+    if (SXS_BUFPOOL_LOAD_ACQ(&p_pool->pp_chunks[index]) != NULL) {
+        return 1;
+    }
+
+    pp_chunk = (sxs_pbuf_t **)calloc(SXS_BUFPOOL_CHUNK_SIZE,
+        sizeof(sxs_pbuf_t *));
+    if (pp_chunk == NULL) {
+        return 0;
+    }
+
+    pp_old = NULL;
+    if (!SXS_BUFPOOL_CAS(&p_pool->pp_chunks[index], &pp_old, pp_chunk)) {
+        free(pp_chunk);
+    }
+
+    return 1;
+}
+
+/* Allocate a batch of buffers of the class 'cls' and chain them into
+ * the cache. With huge pages a whole huge page worth of buffers is
+ * allocated, and those beyond the cache's share go to the global list. */
+static sxs_error_t sxs_bufpool_grow(sxs_bufpool_t *p_pool,
+    struct sxs_bufpool_cache *p_cache, int cls) {
+
+    struct sxs_bufpool_slab *p_slab;
+    struct sxs_bufpool_slab *p_head;
+    sxs_pbuf_t *p_bufs;
+    sxs_uint32_t first;
+    sxs_size_t size;
+    unsigned int count;
+    unsigned int i;
+
+    count = p_pool->batch_count;
+    size = p_pool->class_size[cls];
+    if ((count * size) < sxs_mem_huge_size()) {
+        count = sxs_mem_huge_size() / size;
+        if (count > SXS_BUFPOOL_CHUNK_SIZE) {
+            count = SXS_BUFPOOL_CHUNK_SIZE;
+        }
+    }
+
+    first = SXS_BUFPOOL_ADD(&p_pool->next_id, count) - count + 1;
+    if ((first < 1) || ((first + count) >
+        ((sxs_uint32_t)SXS_BUFPOOL_MAX_CHUNKS * SXS_BUFPOOL_CHUNK_SIZE))) {
+        return SXS_ENOMEM;
+    }
+    if ((!sxs_bufpool_chunk(p_pool, first)) ||
+        (!sxs_bufpool_chunk(p_pool, (first + count - 1)))) {
+        return SXS_ENOMEM;
+    }
+
+    p_slab = (struct sxs_bufpool_slab *)malloc(
+        sizeof(struct sxs_bufpool_slab) + (count * sizeof(sxs_pbuf_t)));
+    if (p_slab == NULL) {
+        return SXS_ENOMEM;
+    }
+    if (sxs_mem_alloc((count * size), &p_slab->mem) != SXS_SUCCESS) {
+        free(p_slab);
+        return SXS_ENOMEM;
+    }
+
+    p_bufs = (sxs_pbuf_t *)(p_slab + 1);
+    for (i = 0; i < count; i++) {
+        p_bufs[i].p_pool = p_pool;
+        p_bufs[i].p_next = p_cache->p_free[cls];
+        p_bufs[i].p_data = p_slab->mem.p_data + (i * size);
+        p_bufs[i].size = size;
+        p_bufs[i].refs = 0;
+        p_bufs[i].id = first + i;
+        p_bufs[i].next_batch = 0;
+        p_bufs[i].batch_len = 0;
+        p_bufs[i].cls = cls;
+        p_pool->pp_chunks[(first + i) >> SXS_BUFPOOL_CHUNK_SHIFT]
+            [(first + i) & (SXS_BUFPOOL_CHUNK_SIZE - 1)] = &p_bufs[i];
+        p_cache->p_free[cls] = &p_bufs[i];
+    }
+    p_cache->num_free[cls] += count;
+
+    p_head = SXS_BUFPOOL_LOAD_ACQ(&p_pool->p_slabs);
+    do {
+        p_slab->p_next = p_head;
+    } while (!SXS_BUFPOOL_CAS(&p_pool->p_slabs, &p_head, p_slab));
+
+    SXS_BUFPOOL_STORE_RLX(&p_cache->allocated,
+        (SXS_BUFPOOL_LOAD_RLX(&p_cache->allocated) + count));
+
+    while (p_cache->num_free[cls] > p_pool->cache_count) {
+        sxs_bufpool_spill(p_cache, cls, 0);
+    }
+
+    return SXS_SUCCESS;
+}
+
+static sxs_size_t sxs_bufpool_pow2(sxs_size_t size) {
+    sxs_size_t pow2;
+
+    pow2 = 1;
+    while ((pow2 < size) && (pow2 != 0)) {
+        pow2 = pow2 << 1;
+    }
+
+    return pow2;
+}
+
+sxs_error_t sxs_bufpool_create(const sxs_bufpool_opts_t *p_opts,
+    sxs_bufpool_t **pp_pool) {
+
+    sxs_bufpool_t *p_pool;
+    sxs_size_t min_size;
+    sxs_size_t max_size;
+    sxs_size_t size;
+    unsigned int cache_count;
+    unsigned int batch_count;
+    int num_classes;
+
+    min_size = SXS_BUFPOOL_DEF_MIN_SIZE;
+    max_size = SXS_BUFPOOL_DEF_MAX_SIZE;
+    cache_count = SXS_BUFPOOL_DEF_CACHE_COUNT;
+    batch_count = SXS_BUFPOOL_DEF_BATCH_COUNT;
+    if (p_opts != NULL) {
+        if (p_opts->min_size != 0) {
+            min_size = p_opts->min_size;
+        }
+        if (p_opts->max_size != 0) {
+            max_size = p_opts->max_size;
+        }
+        if (p_opts->cache_count != 0) {
+            cache_count = p_opts->cache_count;
+        }
+        if (p_opts->batch_count != 0) {
+            batch_count = p_opts->batch_count;
+        }
+    }
+
+    min_size = sxs_bufpool_pow2(min_size);
+    max_size = sxs_bufpool_pow2(max_size);
+    if ((min_size == 0) || (max_size == 0) || (min_size > max_size) ||
+        (batch_count > cache_count) ||
+        (batch_count > SXS_BUFPOOL_CHUNK_SIZE)) {
+        return SXS_EINVAL;
+    }
+
+    num_classes = 1;
+    for (size = min_size; size < max_size; size = size << 1) {
+        num_classes++;
+    }
+    if (num_classes > SXS_BUFPOOL_MAX_CLASSES) {
+        return SXS_EINVAL;
+    }
+
+    p_pool = (sxs_bufpool_t *)calloc(1, sizeof(sxs_bufpool_t));
+    if (p_pool == NULL) {
+        return SXS_ENOMEM;
+    }
+
+#ifdef WIN32
+    p_pool->cache_key = FlsAlloc(sxs_bufpool_fls_release);
+    if (p_pool->cache_key == FLS_OUT_OF_INDEXES) {
+#else
+    if (pthread_key_create(&p_pool->cache_key,
+        sxs_bufpool_cache_release) != 0) {
+#endif
+        free(p_pool);
+        return SXS_ENOMEM;
+    }
+
+    p_pool->cache_count = cache_count;
+    p_pool->batch_count = batch_count;
+    p_pool->num_classes = num_classes;
+    for (num_classes = 0, size = min_size; num_classes < p_pool->num_classes;
+        num_classes++, size = size << 1) {
+        p_pool->class_size[num_classes] = size;
+    }
+
+    (*pp_pool) = p_pool;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_bufpool_destroy(sxs_bufpool_t *p_pool) {
+    struct sxs_bufpool_cache *p_cache;
+    struct sxs_bufpool_slab *p_slab;
+    void *p_next;
+    int i;
+
+    /* Deleting the key does not run the release of the caches of the
+     * threads still alive; with Windows it may, which is ignored. */
+    p_pool->destroying = 1;
+#ifdef WIN32
+    FlsFree(p_pool->cache_key);
+#else
+    pthread_key_delete(p_pool->cache_key);
+#endif
+
+    p_cache = p_pool->p_caches;
+    while (p_cache != NULL) {
+        p_next = p_cache->p_next;
+        free(p_cache);
+        p_cache = (struct sxs_bufpool_cache *)p_next;
+    }
+
+    p_slab = p_pool->p_slabs;
+    while (p_slab != NULL) {
+        p_next = p_slab->p_next;
+        sxs_mem_free(&p_slab->mem);
+        free(p_slab);
+        p_slab = (struct sxs_bufpool_slab *)p_next;
+    }
+
+    for (i = 0; i < SXS_BUFPOOL_MAX_CHUNKS; i++) {
+        free(p_pool->pp_chunks[i]);
+    }
+
+    free(p_pool);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_bufpool_get(sxs_bufpool_t *p_pool, sxs_size_t size,
+    sxs_pbuf_t **pp_buf) {
+
+    struct sxs_bufpool_cache *p_cache;
+    sxs_pbuf_t *p_buf;
+    sxs_error_t reterr;
+    int cls;
+
+    p_cache = sxs_bufpool_cache(p_pool);
+    if (p_cache == NULL) {
+        return SXS_ENOMEM;
+    }
+    SXS_BUFPOOL_COUNT(p_cache, gets);
+
+    for (cls = 0; cls < p_pool->num_classes; cls++) {
+        if (size <= p_pool->class_size[cls]) {
+            break;
+        }
+    }
+
+    if (cls == p_pool->num_classes) {
+        p_buf = (sxs_pbuf_t *)malloc(sizeof(sxs_pbuf_t) + size);
+        if (p_buf == NULL) {
+            return SXS_ENOMEM;
+        }
+        p_buf->p_pool = p_pool;
+        p_buf->p_next = NULL;
+        p_buf->p_data = (char *)(p_buf + 1);
+        p_buf->size = size;
+        p_buf->id = 0;
+        p_buf->cls = -1;
+        SXS_BUFPOOL_COUNT(p_cache, oversize);
+    } else {
+        if (p_cache->p_free[cls] != NULL) {
+            SXS_BUFPOOL_COUNT(p_cache, cache_hits);
+        } else {
+            p_buf = sxs_bufpool_pop(p_pool, cls);
+            if (p_buf != NULL) {
+                p_cache->p_free[cls] = p_buf;
+                p_cache->num_free[cls] = p_buf->batch_len;
+                SXS_BUFPOOL_COUNT(p_cache, global_hits);
+            } else {
+                reterr = sxs_bufpool_grow(p_pool, p_cache, cls);
+                if (reterr != SXS_SUCCESS) {
+                    return reterr;
+                }
+                SXS_BUFPOOL_COUNT(p_cache, misses);
+            }
+        }
+
+        p_buf = p_cache->p_free[cls];
+        p_cache->p_free[cls] = p_buf->p_next;
+        p_cache->num_free[cls]--;
+        p_buf->p_next = NULL;
+    }
+
+    SXS_BUFPOOL_STORE_RLX(&p_buf->refs, 1);
+    (*pp_buf) = p_buf;
+
+    return SXS_SUCCESS;
+}
+
+void sxs_bufpool_stats(sxs_bufpool_t *p_pool, sxs_bufpool_stats_t *p_stats) {
+    struct sxs_bufpool_cache *p_cache;
+
+    memset(p_stats, 0, sizeof(sxs_bufpool_stats_t));
+
+    p_cache = SXS_BUFPOOL_LOAD_ACQ(&p_pool->p_caches);
+    while (p_cache != NULL) {
+        p_stats->gets += SXS_BUFPOOL_LOAD_RLX(&p_cache->gets);
+        p_stats->cache_hits += SXS_BUFPOOL_LOAD_RLX(&p_cache->cache_hits);
+        p_stats->global_hits += SXS_BUFPOOL_LOAD_RLX(&p_cache->global_hits);
+        p_stats->misses += SXS_BUFPOOL_LOAD_RLX(&p_cache->misses);
+        p_stats->oversize += SXS_BUFPOOL_LOAD_RLX(&p_cache->oversize);
+        p_stats->releases += SXS_BUFPOOL_LOAD_RLX(&p_cache->releases);
+        p_stats->allocated += SXS_BUFPOOL_LOAD_RLX(&p_cache->allocated);
+        p_cache = p_cache->p_next;
+    }
+}
+
+sxs_buf_t sxs_pbuf_data(const sxs_pbuf_t *p_buf) {
+    return (sxs_buf_t)p_buf->p_data;
+}
+
+sxs_size_t sxs_pbuf_size(const sxs_pbuf_t *p_buf) {
+    return p_buf->size;
+}
+
+void sxs_pbuf_ref(sxs_pbuf_t *p_buf) {
+    SXS_BUFPOOL_ADD(&p_buf->refs, 1);
+}
+
+void sxs_pbuf_unref(sxs_pbuf_t *p_buf) {
+    struct sxs_bufpool_cache *p_cache;
+    sxs_bufpool_t *p_pool;
+    int cls;
+
+    if (SXS_BUFPOOL_ADD(&p_buf->refs, -1) != 0) {
+        return;
+    }
+
+    p_pool = p_buf->p_pool;
+    cls = p_buf->cls;
+    p_cache = sxs_bufpool_cache(p_pool);
+    if (p_cache != NULL) {
+        SXS_BUFPOOL_COUNT(p_cache, releases);
+    }
+
+    if (cls < 0) {
+        free(p_buf);
+    } else if (p_cache == NULL) {
+        /* Without a cache of its own the thread hands the buffer to the
+         * global list as a batch of one. */
+        sxs_bufpool_push(p_pool, p_buf, 1);
+    } else {
+        p_buf->p_next = p_cache->p_free[cls];
+        p_cache->p_free[cls] = p_buf;
+        p_cache->num_free[cls]++;
+        if (p_cache->num_free[cls] > p_pool->cache_count) {
+            sxs_bufpool_spill(p_cache, cls, 0);
+        }
+    }
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_bufpool.h
+ * @brief This is a specifications file for the lib_sxs buffer pool API.
+ *
+ * The sxs_bufpool.h file is a specifications file that defines the
+ * functions which compose the buffer pool API of lib_sxs. A buffer pool
+ * hands out I/O buffers of a few fixed size classes and recycles them,
+ * so that connections coming and going do not allocate and free memory
+ * around every sxs_recv() and sxs_send().
+ *
+ * Every thread getting buffers from a pool has a cache of free buffers
+ * of its own, which serves most requests without any synchronization.
+ * Caches exchange buffers with a global free list of the pool in
+ * batches, and the global list is lock-free, so threads never wait for
+ * each other. Buffers are reference counted: a buffer filled by an I/O
+ * thread may be handed to a worker thread, or shared by several, and is
+ * recycled by whichever thread drops the last reference.
+ */
+
+#ifndef SXS_BUFPOOL_H
+#define SXS_BUFPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+
+/**
+ * @def SXS_BUFPOOL_MAX_CLASSES
+ * @brief The largest number of size classes a pool may have.
+ */
+#define SXS_BUFPOOL_MAX_CLASSES 24
+
+/**
+ * @typedef sxs_bufpool_t
+ * @brief An opaque buffer pool.
+ *
+ * The sxs_bufpool_t type represents a pool of buffers and the caches
+ * of the threads using it.
+ */
+typedef struct sxs_bufpool sxs_bufpool_t;
+
+/**
+ * @typedef sxs_pbuf_t
+ * @brief An opaque pooled buffer.
+ *
+ * The sxs_pbuf_t type represents a reference counted buffer obtained
+ * from a buffer pool.
+ */
+typedef struct sxs_pbuf sxs_pbuf_t;
+
+/**
+ * @typedef sxs_bufpool_opts_t
+ * @brief The configuration of a buffer pool.
+ *
+ * The sxs_bufpool_opts_t type is a structure holding the configuration
+ * of a buffer pool. The size classes are the powers of two from
+ * 'min_size' to 'max_size', both rounded up to a power of two, and a
+ * buffer is taken from the smallest class it fits in. The
+ * 'cache_count' member is the number of free buffers of each class a
+ * thread keeps for itself, and 'batch_count' the number of buffers
+ * moved between a thread's cache and the global list at once. A member
+ * left 0 takes its default value, 512, 65536, 64 and 16 respectively.
+ */
+typedef struct sxs_bufpool_opts {
+    sxs_size_t min_size;
+    sxs_size_t max_size;
+    unsigned int cache_count;
+    unsigned int batch_count;
+} sxs_bufpool_opts_t;
+
+/**
+ * @typedef sxs_bufpool_stats_t
+ * @brief The statistics of a buffer pool.
+ *
+ * The sxs_bufpool_stats_t type is a structure holding the counters of a
+ * buffer pool, summed over all the threads which used it. The 'gets'
+ * member counts the buffers handed out, of which 'cache_hits' came from
+ * the cache of the calling thread, 'global_hits' from the global free
+ * list, 'misses' from newly allocated memory, and 'oversize' were
+ * larger than the largest class and allocated for the request alone.
+ * The 'releases' member counts the buffers whose last reference was
+ * dropped, and 'allocated' the pooled buffers allocated so far, whose
+ * memory is kept until the pool is destroyed.
+ */
+typedef struct sxs_bufpool_stats {
+    sxs_uint64_t gets;
+    sxs_uint64_t cache_hits;
+    sxs_uint64_t global_hits;
+    sxs_uint64_t misses;
+    sxs_uint64_t oversize;
+    sxs_uint64_t releases;
+    sxs_uint64_t allocated;
+} sxs_bufpool_stats_t;
+
+/**
+ * Create a buffer pool.
+ *
+ * The sxs_bufpool_create() function creates an empty buffer pool
+ * configured by 'p_opts', or with the default configuration if it is
+ * NULL, and passes it back via 'pp_pool'. Memory is allocated as
+ * buffers are requested.
+ * @param p_opts Pointer to the configuration of the pool, or NULL.
+ * @param pp_pool Pointer to pool pointer to store the new pool in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the pool.
+ * @retval SXS_EINVAL The configuration has too many size classes,
+ * 'min_size' is larger than 'max_size' or 'batch_count' is larger than
+ * 'cache_count'.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_bufpool_create(const sxs_bufpool_opts_t *p_opts,
+    sxs_bufpool_t **pp_pool);
+
+/**
+ * Destroy a buffer pool.
+ *
+ * The sxs_bufpool_destroy() function releases all the memory of the
+ * pool, including the caches of all threads. No thread may use the
+ * pool or any of its buffers during or after the call.
+ * @param p_pool Pointer to the pool to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the pool.
+ */
+SXS_EXPORT sxs_error_t sxs_bufpool_destroy(sxs_bufpool_t *p_pool);
+
+/**
+ * Get a buffer from a pool.
+ *
+ * The sxs_bufpool_get() function passes back a buffer of at least
+ * 'size' bytes via 'pp_buf', holding a single reference. The buffer is
+ * not cleared. It may be used from any thread, and is returned to the
+ * pool when its last reference is dropped with sxs_pbuf_unref().
+ * @param p_pool Pointer to the pool.
+ * @param size The minimum size of the buffer in bytes.
+ * @param pp_buf Pointer to buffer pointer to store the buffer in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully got a buffer.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_bufpool_get(sxs_bufpool_t *p_pool,
+    sxs_size_t size, sxs_pbuf_t **pp_buf);
+
+/**
+ * Get the statistics of a buffer pool.
+ *
+ * The sxs_bufpool_stats() function passes back the counters of the
+ * pool via 'p_stats'. The counters of other threads are read while
+ * they may be changing, so they are only consistent with each other
+ * when the pool is idle.
+ * @param p_pool Pointer to the pool.
+ * @param p_stats Pointer to the struct to store the counters in.
+ */
+SXS_EXPORT void sxs_bufpool_stats(sxs_bufpool_t *p_pool,
+    sxs_bufpool_stats_t *p_stats);
+
+/**
+ * Get the memory of a pooled buffer.
+ *
+ * The sxs_pbuf_data() function returns a pointer to the memory of the
+ * buffer, suitable for passing to sxs_recv() or sxs_send().
+ * @param p_buf Pointer to the buffer.
+ * @return Pointer to the memory of the buffer.
+ */
+SXS_EXPORT sxs_buf_t sxs_pbuf_data(const sxs_pbuf_t *p_buf);
+
+/**
+ * Get the size of a pooled buffer.
+ *
+ * The sxs_pbuf_size() function returns the number of bytes of the
+ * buffer, which is the size of its class and may exceed the size
+ * requested.
+ * @param p_buf Pointer to the buffer.
+ * @return The size of the buffer in bytes.
+ */
+SXS_EXPORT sxs_size_t sxs_pbuf_size(const sxs_pbuf_t *p_buf);
+
+/**
+ * Add a reference to a pooled buffer.
+ *
+ * The sxs_pbuf_ref() function adds a reference to the buffer, e.g.
+ * before handing it to another thread which will drop it when done.
+ * It may be called from any thread holding a reference.
+ * @param p_buf Pointer to the buffer.
+ */
+SXS_EXPORT void sxs_pbuf_ref(sxs_pbuf_t *p_buf);
+
+/**
+ * Drop a reference to a pooled buffer.
+ *
+ * The sxs_pbuf_unref() function drops a reference to the buffer. When
+ * the last one is dropped the buffer is returned to the cache of the
+ * calling thread, or freed if it was larger than the largest class.
+ * @param p_buf Pointer to the buffer.
+ */
+SXS_EXPORT void sxs_pbuf_unref(sxs_pbuf_t *p_buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_BUFPOOL_H */
@@ -212,6 +212,7 @@ extern sxs_int32_t sxs_unix_herrmap[SXS_UNIX_HERRMAP_SIZE];
 #define SXS_ERRSETSOCKOPTFAIL 6012 /**< Failed to set socket option */
 #define SXS_ERRCLOSEFAIL 6013 /**< Failed to close socket */
 #define SXS_ERRUNEXPECTED 6014 /**< An unexpected path was taken */
+#define SXS_ERRFILEEOF 6015 /**< File ended before all its data was sent */
 
 
 #define SXS_UNIXMAC_ERR_START 6333
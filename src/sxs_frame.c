@@ -0,0 +1,344 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_frame.c
+ * @brief This is an implementation file for the lib_sxs framing API.
+ *
+ * The sxs_frame.c file is an implementation file which contains all the
+ * definitions for the functions which compose the message framing API
+ * of lib_sxs.
+ */
+
+#include "sxs_frame.h"
+#include "sxs_config.h"
+
+struct sxs_framer {
+    sxs_rbuf_t *p_rbuf;
+    sxs_frame_opts_t opts;
+};
+
+static const sxs_frame_opts_t sxs_frame_default_opts = {
+    4, SXS_FRAME_BIG_ENDIAN, 0
+};
+
+static int sxs_frame_opts_valid(const sxs_frame_opts_t *p_opts) {
+    return ((p_opts->prefix_size >= 1) &&
+        (p_opts->prefix_size <= SXS_FRAME_MAX_PREFIX) &&
+        ((p_opts->byte_order == SXS_FRAME_BIG_ENDIAN) ||
+        (p_opts->byte_order == SXS_FRAME_LITTLE_ENDIAN)));
+}
+
+static sxs_uint64_t sxs_frame_decode(const sxs_frame_opts_t *p_opts,
+    const unsigned char *p_prefix) {
+
+    sxs_uint64_t len;
+    unsigned int i;
+
+    len = 0;
+    if (p_opts->byte_order == SXS_FRAME_BIG_ENDIAN) {
+        for (i = 0; i < p_opts->prefix_size; i++) {
+            len = (len << 8) | p_prefix[i];
+        }
+    } else {
+        for (i = p_opts->prefix_size; i > 0; i--) {
+            len = (len << 8) | p_prefix[i - 1];
+        }
+    }
+
+    return len;
+}
+
+/* Take the next frame if the read buffer already holds all of it,
+ * setting 'p_taken' accordingly. Nothing is received. */
+static sxs_error_t sxs_frame_take(sxs_framer_t *p_framer,
+    sxs_frame_t *p_frame, int *p_taken) {
+
+    const unsigned char *p_data;
+    const void *p_buffered;
+    sxs_size_t buffered;
+    sxs_uint64_t len;
+
+    (*p_taken) = 0;
+
+    sxs_rbuf_data(p_framer->p_rbuf, &p_buffered, &buffered);
+    if (buffered < p_framer->opts.prefix_size) {
+        return SXS_SUCCESS;
+    }
+
+    p_data = (const unsigned char *)p_buffered;
+    len = sxs_frame_decode(&p_framer->opts, p_data);
+    if (len > p_framer->opts.max_size) {
+        return SXS_EMSGSIZE;
+    }
+    if ((buffered - p_framer->opts.prefix_size) < len) {
+        return SXS_SUCCESS;
+    }
+
+    p_frame->p_data = p_data + p_framer->opts.prefix_size;
+    p_frame->len = (sxs_size_t)len;
+    sxs_rbuf_consume(p_framer->p_rbuf,
+        (p_framer->opts.prefix_size + p_frame->len));
+    (*p_taken) = 1;
+
+    return SXS_SUCCESS;
+}
+
+/* Receive a frame, waiting as sxs_rbuf_peek() does when 'wait' is zero
+ * and as sxs_rbuf_peek_nb() does with 'p_timeout' otherwise. */
+static sxs_error_t sxs_frame_recv_wait(sxs_framer_t *p_framer, int wait,
+    const struct timeval *p_timeout, sxs_frame_t *p_frame) {
+
+    const void *p_data;
+    sxs_error_t reterr;
+    sxs_uint64_t len;
+    int taken;
+
+    reterr = sxs_frame_take(p_framer, p_frame, &taken);
+    if ((reterr != SXS_SUCCESS) || taken) {
+        return reterr;
+    }
+
+    if (wait) {
+        reterr = sxs_rbuf_peek_nb(p_framer->p_rbuf,
+            p_framer->opts.prefix_size, p_timeout, &p_data);
+    } else {
+        reterr = sxs_rbuf_peek(p_framer->p_rbuf, p_framer->opts.prefix_size,
+            &p_data);
+    }
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    len = sxs_frame_decode(&p_framer->opts, (const unsigned char *)p_data);
+    if (len > p_framer->opts.max_size) {
+        return SXS_EMSGSIZE;
+    }
+
+    if (wait) {
+        reterr = sxs_rbuf_peek_nb(p_framer->p_rbuf,
+            (p_framer->opts.prefix_size + (sxs_size_t)len), p_timeout,
+            &p_data);
+    } else {
+        reterr = sxs_rbuf_peek(p_framer->p_rbuf,
+            (p_framer->opts.prefix_size + (sxs_size_t)len), &p_data);
+    }
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    p_frame->p_data = (const char *)p_data + p_framer->opts.prefix_size;
+    p_frame->len = (sxs_size_t)len;
+    sxs_rbuf_consume(p_framer->p_rbuf,
+        (p_framer->opts.prefix_size + p_frame->len));
+
+    return SXS_SUCCESS;
+}
+
+static sxs_error_t sxs_frame_recv_batch_wait(sxs_framer_t *p_framer,
+    int wait, const struct timeval *p_timeout, sxs_frame_t *p_frames,
+    int max, int *p_num) {
+
+    sxs_error_t reterr;
+    int taken;
+
+    if (max < 1) {
+        return SXS_EINVAL;
+    }
+
+    reterr = sxs_frame_recv_wait(p_framer, wait, p_timeout, &p_frames[0]);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    /* The frames taken so far stay valid as nothing more is received.
+     * An oversized frame is left for the next call to report. */
+    (*p_num) = 1;
+    while ((*p_num) < max) {
+        reterr = sxs_frame_take(p_framer, &p_frames[*p_num], &taken);
+        if ((reterr != SXS_SUCCESS) || (!taken)) {
+            break;
+        }
+        (*p_num)++;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_frame_create(sxs_rbuf_t *p_rbuf,
+    const sxs_frame_opts_t *p_opts, sxs_framer_t **pp_framer) {
+
+    sxs_framer_t *p_framer;
+    sxs_size_t max_size;
+
+    if (p_opts == NULL) {
+        p_opts = &sxs_frame_default_opts;
+    }
+
+    if ((!sxs_frame_opts_valid(p_opts)) ||
+        (sxs_rbuf_size(p_rbuf) <= p_opts->prefix_size)) {
+        return SXS_EINVAL;
+    }
+
+    /* Frames are handed out as views of the read buffer, so every frame
+     * accepted has to fit in it along with its prefix. */
+    max_size = sxs_rbuf_size(p_rbuf) - p_opts->prefix_size;
+    if (p_opts->max_size > max_size) {
+        return SXS_EINVAL;
+    } else if (p_opts->max_size != 0) {
+        max_size = p_opts->max_size;
+    }
+
+    p_framer = (sxs_framer_t *)malloc(sizeof(sxs_framer_t));
+    if (p_framer == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    p_framer->p_rbuf = p_rbuf;
+    p_framer->opts = *p_opts;
+    p_framer->opts.max_size = max_size;
+
+    (*pp_framer) = p_framer;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_frame_destroy(sxs_framer_t *p_framer) {
+    free(p_framer);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_frame_recv(sxs_framer_t *p_framer, sxs_frame_t *p_frame) {
+    return sxs_frame_recv_wait(p_framer, 0, NULL, p_frame);
+}
+
+sxs_error_t sxs_frame_recv_nb(sxs_framer_t *p_framer,
+    const struct timeval *p_timeout, sxs_frame_t *p_frame) {
+    return sxs_frame_recv_wait(p_framer, 1, p_timeout, p_frame);
+}
+
+sxs_error_t sxs_frame_recv_batch(sxs_framer_t *p_framer,
+    sxs_frame_t *p_frames, int max, int *p_num) {
+    return sxs_frame_recv_batch_wait(p_framer, 0, NULL, p_frames, max,
+        p_num);
+}
+
+sxs_error_t sxs_frame_recv_batch_nb(sxs_framer_t *p_framer,
+    const struct timeval *p_timeout, sxs_frame_t *p_frames, int max,
+    int *p_num) {
+    return sxs_frame_recv_batch_wait(p_framer, 1, p_timeout, p_frames, max,
+        p_num);
+}
+
+sxs_error_t sxs_frame_dispatch(sxs_framer_t *p_framer, sxs_frame_cb_t cb,
+    void *p_data, int *p_num) {
+
+    struct timeval timeout;
+    sxs_error_t fillerr;
+    sxs_error_t reterr;
+    sxs_frame_t frame;
+    int num;
+    int taken;
+
+    if (p_num != NULL) {
+        (*p_num) = 0;
+    }
+
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 0;
+    fillerr = sxs_rbuf_fill_nb(p_framer->p_rbuf, &timeout);
+    if ((fillerr == SXS_ERRRECVTIMEDOUT) || (fillerr == SXS_ENOBUFS)) {
+        fillerr = SXS_SUCCESS;
+    }
+
+    /* The callback may destroy the framer, so it is not touched after
+     * the callback asks to stop. */
+    num = 0;
+    while (1) {
+        reterr = sxs_frame_take(p_framer, &frame, &taken);
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        } else if (!taken) {
+            break;
+        }
+
+        num++;
+        if (p_num != NULL) {
+            (*p_num) = num;
+        }
+        if (cb(p_framer, &frame, p_data) != 0) {
+            return fillerr;
+        }
+    }
+
+    return fillerr;
+}
+
+sxs_error_t sxs_frame_encode(const sxs_frame_opts_t *p_opts,
+    sxs_size_t len, void *p_prefix, unsigned int *p_prefix_size) {
+
+    unsigned char *p_out;
+    sxs_uint64_t value;
+    unsigned int i;
+
+    if (p_opts == NULL) {
+        p_opts = &sxs_frame_default_opts;
+    }
+
+    if (!sxs_frame_opts_valid(p_opts)) {
+        return SXS_EINVAL;
+    }
+
+    value = (sxs_uint64_t)len;
+    if ((p_opts->prefix_size < 8) &&
+        ((value >> (8 * p_opts->prefix_size)) != 0)) {
+        return SXS_EMSGSIZE;
+    }
+
+    p_out = (unsigned char *)p_prefix;
+    for (i = 0; i < p_opts->prefix_size; i++) {
+        if (p_opts->byte_order == SXS_FRAME_BIG_ENDIAN) {
+            p_out[p_opts->prefix_size - 1 - i] = (unsigned char)value;
+        } else {
+            p_out[i] = (unsigned char)value;
+        }
+        value = value >> 8;
+    }
+
+    (*p_prefix_size) = p_opts->prefix_size;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_frame_send(sxs_socket_t sd, const sxs_frame_opts_t *p_opts,
+    const sxs_buf_t buf, sxs_size_t len) {
+
+    unsigned char prefix[SXS_FRAME_MAX_PREFIX];
+    unsigned int prefix_size;
+    sxs_iovec_t iov[2];
+    sxs_error_t reterr;
+
+    reterr = sxs_frame_encode(p_opts, len, prefix, &prefix_size);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    SXS_IOV_BASE(iov[0]) = (char *)prefix;
+    SXS_IOV_LEN(iov[0]) = prefix_size;
+    SXS_IOV_BASE(iov[1]) = (char *)buf;
+    SXS_IOV_LEN(iov[1]) = len;
+
+    return sxs_sendv_nbytes(sd, iov, 2);
+}
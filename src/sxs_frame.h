@@ -0,0 +1,290 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_frame.h
+ * @brief This is a specifications file for the lib_sxs framing API.
+ *
+ * The sxs_frame.h file is a specifications file that defines the
+ * functions which compose the message framing API of lib_sxs. A framer
+ * splits the stream read through a read buffer into frames, each made
+ * of a length prefix followed by that many bytes of payload, and
+ * passes back views of the payloads in the read buffer rather than
+ * copies of them. The width and byte order of the prefix and the
+ * largest payload accepted are configurable.
+ *
+ * Frames may be received one at a time or in batches, either blocking
+ * or with a timeout, or dispatched to a callback from the read callback
+ * of an event loop. A view of a frame stays valid until the next call
+ * which may receive through the same read buffer, so all the frames of
+ * a batch may be used together.
+ */
+
+#ifndef SXS_FRAME_H
+#define SXS_FRAME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+#include "sxs_rbuf.h"
+
+/**
+ * @def SXS_FRAME_BIG_ENDIAN
+ * @brief The length prefix is in network (big endian) byte order.
+ */
+#define SXS_FRAME_BIG_ENDIAN 0
+
+/**
+ * @def SXS_FRAME_LITTLE_ENDIAN
+ * @brief The length prefix is in little endian byte order.
+ */
+#define SXS_FRAME_LITTLE_ENDIAN 1
+
+/**
+ * @def SXS_FRAME_MAX_PREFIX
+ * @brief The widest length prefix supported, in bytes.
+ */
+#define SXS_FRAME_MAX_PREFIX 8
+
+/**
+ * @typedef sxs_frame_opts_t
+ * @brief The format of the frames of a stream.
+ *
+ * The sxs_frame_opts_t type is a structure describing the framing of a
+ * stream. The 'prefix_size' member is the width of the length prefix in
+ * bytes, from 1 to SXS_FRAME_MAX_PREFIX, and 'byte_order' is either
+ * SXS_FRAME_BIG_ENDIAN or SXS_FRAME_LITTLE_ENDIAN. The prefix holds the
+ * length of the payload alone. The 'max_size' member is the largest
+ * payload accepted; 0 selects the largest one the read buffer can hold
+ * alongside its prefix.
+ */
+typedef struct sxs_frame_opts {
+    unsigned int prefix_size;
+    int byte_order;
+    sxs_size_t max_size;
+} sxs_frame_opts_t;
+
+/**
+ * @typedef sxs_frame_t
+ * @brief A view of the payload of a frame.
+ *
+ * The sxs_frame_t type is a structure holding a pointer to the payload
+ * of a received frame in 'p_data' and its length in 'len'.
+ */
+typedef struct sxs_frame {
+    const void *p_data;
+    sxs_size_t len;
+} sxs_frame_t;
+
+/**
+ * @typedef sxs_framer_t
+ * @brief An opaque framer of a stream.
+ *
+ * The sxs_framer_t type represents the framing state of the stream
+ * read through a read buffer.
+ */
+typedef struct sxs_framer sxs_framer_t;
+
+/**
+ * @typedef sxs_frame_cb_t
+ * @brief A frame callback.
+ *
+ * The sxs_frame_cb_t type is the type of the callback called by
+ * sxs_frame_dispatch() for each received frame. The callback is passed
+ * the framer, a view of the frame and the user data pointer given to
+ * sxs_frame_dispatch(). It returns 0 to be called for the next frame,
+ * or non-zero to stop the dispatch, e.g. after closing the connection.
+ */
+typedef int (*sxs_frame_cb_t)(sxs_framer_t *p_framer,
+    const sxs_frame_t *p_frame, void *p_data);
+
+/**
+ * Create a framer.
+ *
+ * The sxs_frame_create() function creates a framer which reads frames
+ * of the format 'p_opts' through the read buffer 'p_rbuf', and passes
+ * it back via 'pp_framer'. If 'p_opts' is NULL, frames have a 4 byte
+ * big endian prefix. The framer does not take ownership of the read
+ * buffer, which must outlive it.
+ * @param p_rbuf Pointer to the read buffer to read frames through.
+ * @param p_opts Pointer to the format of the frames, or NULL.
+ * @param pp_framer Pointer to framer pointer to store the new framer
+ * in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the framer.
+ * @retval SXS_EINVAL The format is invalid, or its maximum payload
+ * does not fit in the read buffer.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_frame_create(sxs_rbuf_t *p_rbuf,
+    const sxs_frame_opts_t *p_opts, sxs_framer_t **pp_framer);
+
+/**
+ * Destroy a framer.
+ *
+ * The sxs_frame_destroy() function releases all resources associated
+ * with the framer. The read buffer is not destroyed.
+ * @param p_framer Pointer to the framer to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the framer.
+ */
+SXS_EXPORT sxs_error_t sxs_frame_destroy(sxs_framer_t *p_framer);
+
+/**
+ * Receive a frame.
+ *
+ * The sxs_frame_recv() function receives through the read buffer until
+ * a whole frame is buffered, consumes it, and passes back a view of its
+ * payload via 'p_frame'. A frame announcing a payload larger than the
+ * maximum is an error which leaves the stream unusable.
+ * @param p_framer Pointer to the framer.
+ * @param p_frame Pointer to the view to store the frame in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_rbuf_peek().
+ * @retval SXS_SUCCESS Successfully received a frame.
+ * @retval SXS_EMSGSIZE The frame is larger than the maximum.
+ */
+SXS_EXPORT sxs_error_t sxs_frame_recv(sxs_framer_t *p_framer,
+    sxs_frame_t *p_frame);
+
+/**
+ * Receive a frame with a timeout.
+ *
+ * The sxs_frame_recv_nb() function behaves like sxs_frame_recv() except
+ * that each wait for data is bounded by 'p_timeout'. The part of a
+ * frame received before a timeout stays in the read buffer, so the
+ * call may simply be repeated.
+ * @param p_framer Pointer to the framer.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for data to be available on the socket.
+ * @param p_frame Pointer to the view to store the frame in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_rbuf_peek_nb().
+ * @retval SXS_SUCCESS Successfully received a frame.
+ * @retval SXS_EMSGSIZE The frame is larger than the maximum.
+ */
+SXS_EXPORT sxs_error_t sxs_frame_recv_nb(sxs_framer_t *p_framer,
+    const struct timeval *p_timeout, sxs_frame_t *p_frame);
+
+/**
+ * Receive a batch of frames.
+ *
+ * The sxs_frame_recv_batch() function receives a frame as
+ * sxs_frame_recv() does, then takes every other whole frame the read
+ * buffer already holds, up to 'max' frames in all, without receiving
+ * again. The views are stored in 'p_frames' and their number is passed
+ * back via 'p_num'. One large receive therefore yields all the frames
+ * it carried.
+ * @param p_framer Pointer to the framer.
+ * @param p_frames Pointer to the array of 'max' views to fill.
+ * @param max The number of views in the array.
+ * @param p_num Pointer to var to store the number of frames in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_frame_recv().
+ * @retval SXS_SUCCESS Successfully received at least one frame.
+ * @retval SXS_EINVAL 'max' is less than 1.
+ */
+SXS_EXPORT sxs_error_t sxs_frame_recv_batch(sxs_framer_t *p_framer,
+    sxs_frame_t *p_frames, int max, int *p_num);
+
+/**
+ * Receive a batch of frames with a timeout.
+ *
+ * The sxs_frame_recv_batch_nb() function behaves like
+ * sxs_frame_recv_batch() except that the first frame is received as
+ * sxs_frame_recv_nb() does.
+ * @param p_framer Pointer to the framer.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for data to be available on the socket.
+ * @param p_frames Pointer to the array of 'max' views to fill.
+ * @param max The number of views in the array.
+ * @param p_num Pointer to var to store the number of frames in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_frame_recv_nb().
+ * @retval SXS_SUCCESS Successfully received at least one frame.
+ * @retval SXS_EINVAL 'max' is less than 1.
+ */
+SXS_EXPORT sxs_error_t sxs_frame_recv_batch_nb(sxs_framer_t *p_framer,
+    const struct timeval *p_timeout, sxs_frame_t *p_frames, int max,
+    int *p_num);
+
+/**
+ * Dispatch the frames which have arrived.
+ *
+ * The sxs_frame_dispatch() function is meant to be called from the
+ * read callback of an event loop. It receives what has arrived on the
+ * socket without waiting, then calls 'cb' for each whole frame held by
+ * the read buffer, consuming it first, until none is left or 'cb' asks
+ * to stop. The number of frames dispatched is passed back via 'p_num',
+ * which may be NULL. Frames received before the peer closed the
+ * connection are dispatched before SXS_ERRCONNCLOSED is returned.
+ * @param p_framer Pointer to the framer.
+ * @param cb The callback to call for each frame.
+ * @param p_data User data pointer passed to the callback.
+ * @param p_num Pointer to var to store the number of frames in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_rbuf_fill_nb().
+ * @retval SXS_SUCCESS Successfully dispatched the buffered frames.
+ * @retval SXS_EMSGSIZE A frame is larger than the maximum.
+ * @retval SXS_ERRCONNCLOSED Peer closed the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_frame_dispatch(sxs_framer_t *p_framer,
+    sxs_frame_cb_t cb, void *p_data, int *p_num);
+
+/**
+ * Encode the length prefix of a frame.
+ *
+ * The sxs_frame_encode() function stores the length prefix of a frame
+ * with a payload of 'len' bytes, in the format 'p_opts' or the default
+ * format if it is NULL, in 'p_prefix', which must have room for
+ * SXS_FRAME_MAX_PREFIX bytes. The width of the prefix is passed back
+ * via 'p_prefix_size'. This allows frames to be assembled in a write
+ * buffer or sent along with other data.
+ * @param p_opts Pointer to the format of the frames, or NULL.
+ * @param len The length of the payload in bytes.
+ * @param p_prefix Pointer to the buffer to store the prefix in.
+ * @param p_prefix_size Pointer to var to store the prefix width in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully encoded the prefix.
+ * @retval SXS_EINVAL The format is invalid.
+ * @retval SXS_EMSGSIZE The length does not fit in the prefix.
+ */
+SXS_EXPORT sxs_error_t sxs_frame_encode(const sxs_frame_opts_t *p_opts,
+    sxs_size_t len, void *p_prefix, unsigned int *p_prefix_size);
+
+/**
+ * Send a frame.
+ *
+ * The sxs_frame_send() function sends a frame with the 'len' byte
+ * payload 'buf', in the format 'p_opts' or the default format if it is
+ * NULL, on the socket 'sd'. The prefix and the payload are sent
+ * together with sxs_sendv_nbytes(), without copying the payload.
+ * @param sd The socket descriptor of the socket to send the frame on.
+ * @param p_opts Pointer to the format of the frames, or NULL.
+ * @param buf The pointer to the payload.
+ * @param len The length of the payload in bytes.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_frame_encode() and sxs_sendv_nbytes().
+ * @retval SXS_SUCCESS Successfully sent the frame.
+ */
+SXS_EXPORT sxs_error_t sxs_frame_send(sxs_socket_t sd,
+    const sxs_frame_opts_t *p_opts, const sxs_buf_t buf, sxs_size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_FRAME_H */
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_internal.h
+ * @brief This is a specifications file for lib_sxs internal helpers.
+ *
+ * The sxs_internal.h file is a specifications file that defines the
+ * helper functions shared between the lib_sxs implementation files. It
+ * is not installed and must not be included by client applications.
+ */
+
+#ifndef SXS_INTERNAL_H
+#define SXS_INTERNAL_H
+
+#include "sxs.h"
+
+/* Map an operating system error value to its sxs error code. This is
+ * used where the failing operation is not a single well known system
+ * call whose errors can be enumerated, for example the results of
+ * operations completed by the kernel asynchronously. */
+sxs_error_t sxs_map_errno(sxs_errno_t errsv);
+
+/* Send or receive exactly 'len' bytes on a socket which is either in
+ * non-blocking mode or has MSG_DONTWAIT in 'flags'. Each wait for
+ * readiness is bounded by 'p_timeout' or, when 'p_deadline_ms' is not
+ * NULL, by the time left until that monotonic deadline. These are the
+ * loops shared by the *_nbytes_nb, *_nbytes_dl and *_nbytes_dontwait
+ * functions and the sxs_sock_t handle, which differ only in how they
+ * keep the socket from blocking. */
+sxs_error_t sxs_send_nbytes_wait(sxs_socket_t sd, const sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    const sxs_uint64_t *p_deadline_ms);
+sxs_error_t sxs_recv_nbytes_wait(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    const sxs_uint64_t *p_deadline_ms);
+
+/* Find the first occurrence of the 'delim_len' byte delimiter in 'len'
+ * bytes of data, returning NULL if it does not occur. The search uses
+ * the widest vector instructions the processor supports. */
+const char *sxs_scan_delim(const char *p_data, sxs_size_t len,
+    const char *p_delim, sxs_size_t delim_len);
+
+/* Memory backing the buffers lib_sxs manages itself, allocated as set
+ * by the memory policy given to sxs_init_ex(). The memory remembers how
+ * it was obtained so that it is released correctly even if the policy
+ * changes in the meantime, and 'size' may exceed the size asked for. */
+typedef struct sxs_mem {
+    char *p_data;
+    sxs_size_t size;
+    int mapped;
+} sxs_mem_t;
+
+sxs_error_t sxs_mem_policy(int flags, int node);
+sxs_error_t sxs_mem_alloc(sxs_size_t size, sxs_mem_t *p_mem);
+void sxs_mem_free(sxs_mem_t *p_mem);
+
+/* Bind, lock and prefault memory obtained elsewhere, e.g. the mappings
+ * of a ring buffer, as the memory policy says. */
+void sxs_mem_apply(void *p_data, sxs_size_t size);
+
+/* The huge page size when the memory policy asks for huge pages, which
+ * allocations should reach to get them, or 0. */
+sxs_size_t sxs_mem_huge_size(void);
+
+/* The io_uring engine hooks used by the sxs entry points in sxs.c when
+ * the engine has been selected with sxs_init_ex(). Only sends and
+ * receives which have to wait are made on the ring, see sxs_uring.c. */
+sxs_error_t sxs_uring_engine_init(unsigned int entries);
+void sxs_uring_engine_uninit(void);
+int sxs_uring_engine_enabled(void);
+sxs_error_t sxs_uring_engine_send(sxs_socket_t sd, const sxs_buf_t buf,
+    sxs_size_t len, int flags, const sxs_sockaddr_t *to,
+    sxs_socklen_t tolen, sxs_ssize_t *p_sent);
+sxs_error_t sxs_uring_engine_recv(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, int flags, sxs_sockaddr_t *from,
+    sxs_socklen_t *fromlen, sxs_ssize_t *p_recvd);
+sxs_error_t sxs_uring_engine_sendv(sxs_socket_t sd,
+    const sxs_iovec_t *p_iov, int iovcnt, int flags, sxs_ssize_t *p_sent);
+sxs_error_t sxs_uring_engine_recvv(sxs_socket_t sd,
+    const sxs_iovec_t *p_iov, int iovcnt, int flags, sxs_ssize_t *p_recvd);
+
+#endif /* SXS_INTERNAL_H */
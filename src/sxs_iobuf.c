@@ -0,0 +1,504 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_iobuf.c
+ * @brief This is an implementation file for the lib_sxs buffer chain
+ * API.
+ *
+ * The sxs_iobuf.c file is an implementation file which contains all the
+ * definitions for the functions which compose the buffer chain API of
+ * lib_sxs.
+ */
+
+#include "sxs_iobuf.h"
+#include "sxs_config.h"
+
+/* The number of slices gathered for a single vectored send. */
+#define SXS_IOBUF_IOV 64
+
+/* A block of memory shared by the slices referring to it. Copies are
+ * stored right after it, in the same allocation. */
+struct sxs_iobuf_mem {
+    sxs_uint32_t refs;
+    sxs_pbuf_t *p_pbuf;
+    sxs_iobuf_free_cb_t free_cb;
+    void *p_mem;
+    void *p_data;
+};
+
+struct sxs_iobuf_slice {
+    struct sxs_iobuf_slice *p_next;
+    struct sxs_iobuf_mem *p_mem;
+    char *p_data;
+    sxs_size_t len;
+};
+
+struct sxs_iobuf {
+    struct sxs_iobuf_slice *p_head;
+    struct sxs_iobuf_slice *p_tail;
+    sxs_size_t length;
+    int count;
+};
+
+static void sxs_iobuf_mem_unref(struct sxs_iobuf_mem *p_mem) {
+    if (__atomic_sub_fetch(&p_mem->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+
+    if (p_mem->p_pbuf != NULL) {
+        sxs_pbuf_unref(p_mem->p_pbuf);
+    } else if (p_mem->free_cb != NULL) {
+        p_mem->free_cb(p_mem->p_mem, p_mem->p_data);
+    }
+    free(p_mem);
+}
+
+static void sxs_iobuf_slice_free(struct sxs_iobuf_slice *p_slice) {
+    sxs_iobuf_mem_unref(p_slice->p_mem);
+    free(p_slice);
+}
+
+/* Put a new slice of 'p_mem' at either end of the chain. The slice
+ * takes over a reference to 'p_mem' held by the caller. */
+static sxs_error_t sxs_iobuf_add(sxs_iobuf_t *p_iobuf,
+    struct sxs_iobuf_mem *p_mem, char *p_data, sxs_size_t len, int front) {
+
+    struct sxs_iobuf_slice *p_slice;
+
+    p_slice = (struct sxs_iobuf_slice *)malloc(
+        sizeof(struct sxs_iobuf_slice));
+    if (p_slice == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    p_slice->p_mem = p_mem;
+    p_slice->p_data = p_data;
+    p_slice->len = len;
+
+    if (front) {
+        p_slice->p_next = p_iobuf->p_head;
+        p_iobuf->p_head = p_slice;
+        if (p_iobuf->p_tail == NULL) {
+            p_iobuf->p_tail = p_slice;
+        }
+    } else {
+        p_slice->p_next = NULL;
+        if (p_iobuf->p_tail == NULL) {
+            p_iobuf->p_head = p_slice;
+        } else {
+            p_iobuf->p_tail->p_next = p_slice;
+        }
+        p_iobuf->p_tail = p_slice;
+    }
+    p_iobuf->length += len;
+    p_iobuf->count++;
+
+    return SXS_SUCCESS;
+}
+
+static sxs_error_t sxs_iobuf_add_pbuf(sxs_iobuf_t *p_iobuf,
+    sxs_pbuf_t *p_buf, sxs_size_t offset, sxs_size_t len, int front) {
+
+    struct sxs_iobuf_mem *p_mem;
+
+    if ((offset > sxs_pbuf_size(p_buf)) ||
+        (len > (sxs_pbuf_size(p_buf) - offset))) {
+        return SXS_EINVAL;
+    }
+
+    p_mem = (struct sxs_iobuf_mem *)malloc(sizeof(struct sxs_iobuf_mem));
+    if (p_mem == NULL) {
+        return SXS_ENOMEM;
+    }
+    p_mem->refs = 1;
+    p_mem->p_pbuf = p_buf;
+    p_mem->free_cb = NULL;
+    p_mem->p_mem = NULL;
+    p_mem->p_data = NULL;
+
+    if (sxs_iobuf_add(p_iobuf, p_mem,
+        ((char *)sxs_pbuf_data(p_buf) + offset), len, front) !=
+        SXS_SUCCESS) {
+        free(p_mem);
+        return SXS_ENOMEM;
+    }
+    sxs_pbuf_ref(p_buf);
+
+    return SXS_SUCCESS;
+}
+
+static sxs_error_t sxs_iobuf_add_ref(sxs_iobuf_t *p_iobuf, void *p_mem,
+    sxs_size_t len, sxs_iobuf_free_cb_t free_cb, void *p_data, int front) {
+
+    struct sxs_iobuf_mem *p_block;
+
+    p_block = (struct sxs_iobuf_mem *)malloc(sizeof(struct sxs_iobuf_mem));
+    if (p_block == NULL) {
+        return SXS_ENOMEM;
+    }
+    p_block->refs = 1;
+    p_block->p_pbuf = NULL;
+    p_block->free_cb = free_cb;
+    p_block->p_mem = p_mem;
+    p_block->p_data = p_data;
+
+    if (sxs_iobuf_add(p_iobuf, p_block, (char *)p_mem, len, front) !=
+        SXS_SUCCESS) {
+        free(p_block);
+        return SXS_ENOMEM;
+    }
+
+    return SXS_SUCCESS;
+}
+
+static sxs_error_t sxs_iobuf_add_copy(sxs_iobuf_t *p_iobuf,
+    const void *p_mem, sxs_size_t len, int front) {
+
+    struct sxs_iobuf_mem *p_block;
+    char *p_copy;
+
+    p_block = (struct sxs_iobuf_mem *)malloc(sizeof(struct sxs_iobuf_mem) +
+        len);
+    if (p_block == NULL) {
+        return SXS_ENOMEM;
+    }
+    p_block->refs = 1;
+    p_block->p_pbuf = NULL;
+    p_block->free_cb = NULL;
+    p_block->p_mem = NULL;
+    p_block->p_data = NULL;
+
+    p_copy = (char *)(p_block + 1);
+    memcpy(p_copy, p_mem, len);
+
+    if (sxs_iobuf_add(p_iobuf, p_block, p_copy, len, front) !=
+        SXS_SUCCESS) {
+        free(p_block);
+        return SXS_ENOMEM;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_iobuf_create(sxs_iobuf_t **pp_iobuf) {
+    sxs_iobuf_t *p_iobuf;
+
+    p_iobuf = (sxs_iobuf_t *)malloc(sizeof(sxs_iobuf_t));
+    if (p_iobuf == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    p_iobuf->p_head = NULL;
+    p_iobuf->p_tail = NULL;
+    p_iobuf->length = 0;
+    p_iobuf->count = 0;
+
+    (*pp_iobuf) = p_iobuf;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_iobuf_destroy(sxs_iobuf_t *p_iobuf) {
+    sxs_iobuf_consume(p_iobuf, p_iobuf->length);
+    free(p_iobuf);
+
+    return SXS_SUCCESS;
+}
+
+sxs_size_t sxs_iobuf_length(const sxs_iobuf_t *p_iobuf) {
+    return p_iobuf->length;
+}
+
+int sxs_iobuf_count(const sxs_iobuf_t *p_iobuf) {
+    return p_iobuf->count;
+}
+
+sxs_error_t sxs_iobuf_append_pbuf(sxs_iobuf_t *p_iobuf, sxs_pbuf_t *p_buf,
+    sxs_size_t offset, sxs_size_t len) {
+    return sxs_iobuf_add_pbuf(p_iobuf, p_buf, offset, len, 0);
+}
+
+sxs_error_t sxs_iobuf_prepend_pbuf(sxs_iobuf_t *p_iobuf, sxs_pbuf_t *p_buf,
+    sxs_size_t offset, sxs_size_t len) {
+    return sxs_iobuf_add_pbuf(p_iobuf, p_buf, offset, len, 1);
+}
+
+sxs_error_t sxs_iobuf_append_ref(sxs_iobuf_t *p_iobuf, void *p_mem,
+    sxs_size_t len, sxs_iobuf_free_cb_t free_cb, void *p_data) {
+    return sxs_iobuf_add_ref(p_iobuf, p_mem, len, free_cb, p_data, 0);
+}
+
+sxs_error_t sxs_iobuf_prepend_ref(sxs_iobuf_t *p_iobuf, void *p_mem,
+    sxs_size_t len, sxs_iobuf_free_cb_t free_cb, void *p_data) {
+    return sxs_iobuf_add_ref(p_iobuf, p_mem, len, free_cb, p_data, 1);
+}
+
+sxs_error_t sxs_iobuf_append_copy(sxs_iobuf_t *p_iobuf, const void *p_mem,
+    sxs_size_t len) {
+    return sxs_iobuf_add_copy(p_iobuf, p_mem, len, 0);
+}
+
+sxs_error_t sxs_iobuf_prepend_copy(sxs_iobuf_t *p_iobuf, const void *p_mem,
+    sxs_size_t len) {
+    return sxs_iobuf_add_copy(p_iobuf, p_mem, len, 1);
+}
+
+void sxs_iobuf_append(sxs_iobuf_t *p_iobuf, sxs_iobuf_t *p_src) {
+    if (p_src->p_head == NULL) {
+        return;
+    }
+
+    if (p_iobuf->p_tail == NULL) {
+        p_iobuf->p_head = p_src->p_head;
+    } else {
+        p_iobuf->p_tail->p_next = p_src->p_head;
+    }
+    p_iobuf->p_tail = p_src->p_tail;
+    p_iobuf->length += p_src->length;
+    p_iobuf->count += p_src->count;
+
+    p_src->p_head = NULL;
+    p_src->p_tail = NULL;
+    p_src->length = 0;
+    p_src->count = 0;
+}
+
+void sxs_iobuf_prepend(sxs_iobuf_t *p_iobuf, sxs_iobuf_t *p_src) {
+    sxs_iobuf_append(p_src, p_iobuf);
+    sxs_iobuf_append(p_iobuf, p_src);
+}
+
+sxs_error_t sxs_iobuf_clone(const sxs_iobuf_t *p_iobuf,
+    sxs_iobuf_t **pp_clone) {
+
+    struct sxs_iobuf_slice *p_slice;
+    sxs_iobuf_t *p_clone;
+    sxs_error_t reterr;
+
+    reterr = sxs_iobuf_create(&p_clone);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    for (p_slice = p_iobuf->p_head; p_slice != NULL;
+        p_slice = p_slice->p_next) {
+        if (sxs_iobuf_add(p_clone, p_slice->p_mem, p_slice->p_data,
+            p_slice->len, 0) != SXS_SUCCESS) {
+            sxs_iobuf_destroy(p_clone);
+            return SXS_ENOMEM;
+        }
+        __atomic_add_fetch(&p_slice->p_mem->refs, 1, __ATOMIC_RELAXED);
+    }
+
+    (*pp_clone) = p_clone;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_iobuf_split(sxs_iobuf_t *p_iobuf, sxs_size_t offset,
+    sxs_iobuf_t **pp_tail) {
+
+    struct sxs_iobuf_slice *p_prev;
+    struct sxs_iobuf_slice *p_slice;
+    sxs_iobuf_t *p_tail;
+    sxs_error_t reterr;
+    sxs_size_t pos;
+    int count;
+
+    if (offset > p_iobuf->length) {
+        return SXS_EINVAL;
+    }
+
+    reterr = sxs_iobuf_create(&p_tail);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    /* Find the first slice ending past the offset. */
+    p_prev = NULL;
+    p_slice = p_iobuf->p_head;
+    pos = 0;
+    count = 0;
+    while ((p_slice != NULL) && ((pos + p_slice->len) <= offset)) {
+        pos += p_slice->len;
+        count++;
+        p_prev = p_slice;
+        p_slice = p_slice->p_next;
+    }
+
+    if ((p_slice != NULL) && (pos < offset)) {
+        /* The slice straddles the offset, so its end becomes a slice of
+         * its own heading the tail. */
+        if (sxs_iobuf_add(p_tail, p_slice->p_mem,
+            (p_slice->p_data + (offset - pos)),
+            (p_slice->len - (offset - pos)), 0) != SXS_SUCCESS) {
+            sxs_iobuf_destroy(p_tail);
+            return SXS_ENOMEM;
+        }
+        __atomic_add_fetch(&p_slice->p_mem->refs, 1, __ATOMIC_RELAXED);
+
+        p_tail->p_head->p_next = p_slice->p_next;
+        if (p_slice->p_next != NULL) {
+            p_tail->p_tail = p_iobuf->p_tail;
+        }
+        p_slice->len = offset - pos;
+        p_slice->p_next = NULL;
+        p_iobuf->p_tail = p_slice;
+        count++;
+    } else if (p_slice != NULL) {
+        p_tail->p_head = p_slice;
+        p_tail->p_tail = p_iobuf->p_tail;
+        if (p_prev == NULL) {
+            p_iobuf->p_head = NULL;
+        } else {
+            p_prev->p_next = NULL;
+        }
+        p_iobuf->p_tail = p_prev;
+    }
+
+    p_tail->length = p_iobuf->length - offset;
+    p_tail->count = p_iobuf->count - count + ((pos < offset) ? 1 : 0);
+    p_iobuf->length = offset;
+    p_iobuf->count = count;
+
+    (*pp_tail) = p_tail;
+
+    return SXS_SUCCESS;
+}
+
+void sxs_iobuf_consume(sxs_iobuf_t *p_iobuf, sxs_size_t len) {
+    struct sxs_iobuf_slice *p_slice;
+
+    while ((p_iobuf->p_head != NULL) && (len >= p_iobuf->p_head->len)) {
+        p_slice = p_iobuf->p_head;
+        len -= p_slice->len;
+        p_iobuf->length -= p_slice->len;
+        p_iobuf->count--;
+        p_iobuf->p_head = p_slice->p_next;
+        sxs_iobuf_slice_free(p_slice);
+    }
+
+    if (p_iobuf->p_head == NULL) {
+        p_iobuf->p_tail = NULL;
+    } else {
+        p_iobuf->p_head->p_data += len;
+        p_iobuf->p_head->len -= len;
+        p_iobuf->length -= len;
+    }
+}
+
+sxs_error_t sxs_iobuf_copy(const sxs_iobuf_t *p_iobuf, sxs_size_t offset,
+    void *p_mem, sxs_size_t len) {
+
+    struct sxs_iobuf_slice *p_slice;
+    char *p_out;
+    sxs_size_t part;
+
+    if ((offset > p_iobuf->length) || (len > (p_iobuf->length - offset))) {
+        return SXS_EINVAL;
+    }
+
+    p_out = (char *)p_mem;
+    p_slice = p_iobuf->p_head;
+    while (len > 0) {
+        if (offset >= p_slice->len) {
+            offset -= p_slice->len;
+        } else {
+            part = p_slice->len - offset;
+            if (part > len) {
+                part = len;
+            }
+            memcpy(p_out, (p_slice->p_data + offset), part);
+            p_out += part;
+            len -= part;
+            offset = 0;
+        }
+        p_slice = p_slice->p_next;
+    }
+
+    return SXS_SUCCESS;
+}
+
+void sxs_iobuf_iovec(const sxs_iobuf_t *p_iobuf, sxs_iovec_t *p_iov,
+    int max, int *p_num) {
+
+    struct sxs_iobuf_slice *p_slice;
+    int num;
+
+    num = 0;
+    for (p_slice = p_iobuf->p_head; (p_slice != NULL) && (num < max);
+        p_slice = p_slice->p_next) {
+        SXS_IOV_BASE(p_iov[num]) = p_slice->p_data;
+        SXS_IOV_LEN(p_iov[num]) = p_slice->len;
+        num++;
+    }
+
+    (*p_num) = num;
+}
+
+sxs_error_t sxs_iobuf_send(sxs_socket_t sd, sxs_iobuf_t *p_iobuf, int flags,
+    sxs_ssize_t *p_sent) {
+
+    sxs_iovec_t iov[SXS_IOBUF_IOV];
+    sxs_error_t reterr;
+    int max;
+    int num;
+
+    max = SXS_IOBUF_IOV;
+    if (SXS_IOV_MAX < max) {
+        max = SXS_IOV_MAX;
+    }
+
+    sxs_iobuf_iovec(p_iobuf, iov, max, &num);
+    if (num == 0) {
+        (*p_sent) = 0;
+        return SXS_SUCCESS;
+    }
+
+    reterr = sxs_sendv(sd, iov, num, flags, p_sent);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    sxs_iobuf_consume(p_iobuf, (sxs_size_t)(*p_sent));
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_iobuf_send_nbytes(sxs_socket_t sd, sxs_iobuf_t *p_iobuf) {
+    sxs_iovec_t iov[SXS_IOBUF_IOV];
+    sxs_error_t reterr;
+    sxs_size_t len;
+    int num;
+    int i;
+
+    /* Each group of slices is consumed once it has been sent in full,
+     * so a failure leaves the group it happened in at the front. */
+    while (p_iobuf->p_head != NULL) {
+        sxs_iobuf_iovec(p_iobuf, iov, SXS_IOBUF_IOV, &num);
+        reterr = sxs_sendv_nbytes(sd, iov, num);
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        }
+
+        len = 0;
+        for (i = 0; i < num; i++) {
+            len += SXS_IOV_LEN(iov[i]);
+        }
+        sxs_iobuf_consume(p_iobuf, len);
+    }
+
+    return SXS_SUCCESS;
+}
@@ -0,0 +1,356 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_iobuf.h
+ * @brief This is a specifications file for the lib_sxs buffer chain API.
+ *
+ * The sxs_iobuf.h file is a specifications file that defines the
+ * functions which compose the buffer chain API of lib_sxs. A buffer
+ * chain holds a message as a list of slices of reference counted
+ * memory, which may come from a buffer pool, from the user, or from a
+ * small copy made by the chain itself. Chains are split, joined and
+ * cloned by moving and sharing slices, never by copying their bytes,
+ * so a protocol layer can put a header in front of a payload it was
+ * handed, and the whole message is sent with a single vectored send.
+ *
+ * A chain is meant to be used by one thread at a time, but the memory
+ * its slices refer to is released by whichever chain drops the last
+ * reference, so clones may be handed to other threads.
+ */
+
+#ifndef SXS_IOBUF_H
+#define SXS_IOBUF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+#include "sxs_bufpool.h"
+
+/**
+ * @typedef sxs_iobuf_t
+ * @brief An opaque buffer chain.
+ *
+ * The sxs_iobuf_t type represents a chain of slices of reference
+ * counted memory holding a message.
+ */
+typedef struct sxs_iobuf sxs_iobuf_t;
+
+/**
+ * @typedef sxs_iobuf_free_cb_t
+ * @brief A memory release callback.
+ *
+ * The sxs_iobuf_free_cb_t type is the type of the callback called when
+ * the last slice referring to memory given to sxs_iobuf_append_ref() or
+ * sxs_iobuf_prepend_ref() is dropped. The callback is passed the
+ * pointer to the memory and the user data pointer given along with it.
+ * It may be called from any thread holding a chain of the memory.
+ */
+typedef void (*sxs_iobuf_free_cb_t)(void *p_mem, void *p_data);
+
+/**
+ * Create a buffer chain.
+ *
+ * The sxs_iobuf_create() function creates an empty buffer chain and
+ * passes it back via 'pp_iobuf'.
+ * @param pp_iobuf Pointer to chain pointer to store the new chain in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the chain.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_create(sxs_iobuf_t **pp_iobuf);
+
+/**
+ * Destroy a buffer chain.
+ *
+ * The sxs_iobuf_destroy() function drops all the slices of the chain
+ * and releases the chain itself.
+ * @param p_iobuf Pointer to the chain to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the chain.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_destroy(sxs_iobuf_t *p_iobuf);
+
+/**
+ * Get the length of a buffer chain.
+ *
+ * The sxs_iobuf_length() function returns the number of bytes held by
+ * all the slices of the chain.
+ * @param p_iobuf Pointer to the chain.
+ * @return The length of the chain in bytes.
+ */
+SXS_EXPORT sxs_size_t sxs_iobuf_length(const sxs_iobuf_t *p_iobuf);
+
+/**
+ * Get the number of slices of a buffer chain.
+ *
+ * The sxs_iobuf_count() function returns the number of slices of the
+ * chain, which is the number of buffers sxs_iobuf_iovec() needs to
+ * describe it.
+ * @param p_iobuf Pointer to the chain.
+ * @return The number of slices of the chain.
+ */
+SXS_EXPORT int sxs_iobuf_count(const sxs_iobuf_t *p_iobuf);
+
+/**
+ * Append a slice of a pooled buffer to a buffer chain.
+ *
+ * The sxs_iobuf_append_pbuf() function appends the 'len' bytes of the
+ * pooled buffer 'p_buf' starting at 'offset' to the chain. The chain
+ * takes a reference of its own on the buffer, so the caller may drop
+ * its reference whenever it likes.
+ * @param p_iobuf Pointer to the chain.
+ * @param p_buf Pointer to the pooled buffer.
+ * @param offset The offset of the slice in the buffer.
+ * @param len The length of the slice in bytes.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully appended the slice.
+ * @retval SXS_EINVAL The slice exceeds the buffer.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_append_pbuf(sxs_iobuf_t *p_iobuf,
+    sxs_pbuf_t *p_buf, sxs_size_t offset, sxs_size_t len);
+
+/**
+ * Prepend a slice of a pooled buffer to a buffer chain.
+ *
+ * The sxs_iobuf_prepend_pbuf() function behaves like
+ * sxs_iobuf_append_pbuf() except that the slice is put in front of the
+ * chain.
+ * @param p_iobuf Pointer to the chain.
+ * @param p_buf Pointer to the pooled buffer.
+ * @param offset The offset of the slice in the buffer.
+ * @param len The length of the slice in bytes.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully prepended the slice.
+ * @retval SXS_EINVAL The slice exceeds the buffer.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_prepend_pbuf(sxs_iobuf_t *p_iobuf,
+    sxs_pbuf_t *p_buf, sxs_size_t offset, sxs_size_t len);
+
+/**
+ * Append memory of the user to a buffer chain.
+ *
+ * The sxs_iobuf_append_ref() function appends the 'len' bytes at
+ * 'p_mem' to the chain without copying them. When the last slice
+ * referring to them is dropped, 'free_cb' is called with 'p_mem' and
+ * 'p_data'; if it is NULL the memory is assumed to outlive every chain
+ * referring to it, e.g. because it is static.
+ * @param p_iobuf Pointer to the chain.
+ * @param p_mem Pointer to the memory.
+ * @param len The length of the memory in bytes.
+ * @param free_cb The callback releasing the memory, or NULL.
+ * @param p_data User data pointer passed to the callback.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully appended the memory.
+ * @retval SXS_ENOMEM Insufficient memory is available, in which case
+ * the callback is not called.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_append_ref(sxs_iobuf_t *p_iobuf,
+    void *p_mem, sxs_size_t len, sxs_iobuf_free_cb_t free_cb, void *p_data);
+
+/**
+ * Prepend memory of the user to a buffer chain.
+ *
+ * The sxs_iobuf_prepend_ref() function behaves like
+ * sxs_iobuf_append_ref() except that the memory is put in front of the
+ * chain.
+ * @param p_iobuf Pointer to the chain.
+ * @param p_mem Pointer to the memory.
+ * @param len The length of the memory in bytes.
+ * @param free_cb The callback releasing the memory, or NULL.
+ * @param p_data User data pointer passed to the callback.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully prepended the memory.
+ * @retval SXS_ENOMEM Insufficient memory is available, in which case
+ * the callback is not called.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_prepend_ref(sxs_iobuf_t *p_iobuf,
+    void *p_mem, sxs_size_t len, sxs_iobuf_free_cb_t free_cb, void *p_data);
+
+/**
+ * Append a copy of some bytes to a buffer chain.
+ *
+ * The sxs_iobuf_append_copy() function appends a copy of the 'len'
+ * bytes at 'p_mem' to the chain. It is meant for short pieces such as
+ * a trailer built on the stack.
+ * @param p_iobuf Pointer to the chain.
+ * @param p_mem Pointer to the bytes to copy.
+ * @param len The number of bytes to copy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully appended the copy.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_append_copy(sxs_iobuf_t *p_iobuf,
+    const void *p_mem, sxs_size_t len);
+
+/**
+ * Prepend a copy of some bytes to a buffer chain.
+ *
+ * The sxs_iobuf_prepend_copy() function behaves like
+ * sxs_iobuf_append_copy() except that the copy is put in front of the
+ * chain. It is meant for headers, such as the length prefix encoded by
+ * sxs_frame_encode().
+ * @param p_iobuf Pointer to the chain.
+ * @param p_mem Pointer to the bytes to copy.
+ * @param len The number of bytes to copy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully prepended the copy.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_prepend_copy(sxs_iobuf_t *p_iobuf,
+    const void *p_mem, sxs_size_t len);
+
+/**
+ * Append a buffer chain to another.
+ *
+ * The sxs_iobuf_append() function moves all the slices of 'p_src' to
+ * the end of 'p_iobuf', leaving 'p_src' empty. No bytes are copied and
+ * nothing is allocated.
+ * @param p_iobuf Pointer to the chain to append to.
+ * @param p_src Pointer to the chain to move the slices of.
+ */
+SXS_EXPORT void sxs_iobuf_append(sxs_iobuf_t *p_iobuf, sxs_iobuf_t *p_src);
+
+/**
+ * Prepend a buffer chain to another.
+ *
+ * The sxs_iobuf_prepend() function moves all the slices of 'p_src' to
+ * the front of 'p_iobuf', leaving 'p_src' empty.
+ * @param p_iobuf Pointer to the chain to prepend to.
+ * @param p_src Pointer to the chain to move the slices of.
+ */
+SXS_EXPORT void sxs_iobuf_prepend(sxs_iobuf_t *p_iobuf, sxs_iobuf_t *p_src);
+
+/**
+ * Clone a buffer chain.
+ *
+ * The sxs_iobuf_clone() function creates a chain holding the same bytes
+ * as 'p_iobuf', sharing its memory, and passes it back via 'pp_clone'.
+ * Either chain may then be changed, split or destroyed without
+ * affecting the other, but the shared bytes themselves must not be
+ * modified through either.
+ * @param p_iobuf Pointer to the chain to clone.
+ * @param pp_clone Pointer to chain pointer to store the clone in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully cloned the chain.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_clone(const sxs_iobuf_t *p_iobuf,
+    sxs_iobuf_t **pp_clone);
+
+/**
+ * Split a buffer chain.
+ *
+ * The sxs_iobuf_split() function leaves the first 'offset' bytes of the
+ * chain in 'p_iobuf' and moves the rest to a new chain passed back via
+ * 'pp_tail'. A slice straddling the offset is split into two slices of
+ * the same memory.
+ * @param p_iobuf Pointer to the chain to split.
+ * @param offset The number of bytes to leave in the chain.
+ * @param pp_tail Pointer to chain pointer to store the rest in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully split the chain.
+ * @retval SXS_EINVAL The offset exceeds the length of the chain.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_split(sxs_iobuf_t *p_iobuf,
+    sxs_size_t offset, sxs_iobuf_t **pp_tail);
+
+/**
+ * Consume the front of a buffer chain.
+ *
+ * The sxs_iobuf_consume() function drops the first 'len' bytes of the
+ * chain, or all of them if it holds fewer, e.g. once they were sent.
+ * @param p_iobuf Pointer to the chain.
+ * @param len The number of bytes to drop.
+ */
+SXS_EXPORT void sxs_iobuf_consume(sxs_iobuf_t *p_iobuf, sxs_size_t len);
+
+/**
+ * Copy bytes out of a buffer chain.
+ *
+ * The sxs_iobuf_copy() function copies the 'len' bytes of the chain
+ * starting at 'offset' into 'p_mem', gathering them from as many slices
+ * as they span. It is meant for reading a header which may straddle
+ * slices.
+ * @param p_iobuf Pointer to the chain.
+ * @param offset The offset in the chain of the first byte to copy.
+ * @param p_mem Pointer to the memory to copy the bytes to.
+ * @param len The number of bytes to copy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully copied the bytes.
+ * @retval SXS_EINVAL The bytes exceed the chain.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_copy(const sxs_iobuf_t *p_iobuf,
+    sxs_size_t offset, void *p_mem, sxs_size_t len);
+
+/**
+ * Describe a buffer chain as an array of buffers.
+ *
+ * The sxs_iobuf_iovec() function stores a buffer for each of the first
+ * 'max' slices of the chain in 'p_iov' and passes back their number via
+ * 'p_num', so that the chain can be given to sxs_sendv() or
+ * sxs_sendv_nbytes(). The buffers stay valid until the chain is next
+ * changed.
+ * @param p_iobuf Pointer to the chain.
+ * @param p_iov Pointer to the array of 'max' buffers to fill.
+ * @param max The number of buffers in the array.
+ * @param p_num Pointer to var to store the number of buffers in.
+ */
+SXS_EXPORT void sxs_iobuf_iovec(const sxs_iobuf_t *p_iobuf,
+    sxs_iovec_t *p_iov, int max, int *p_num);
+
+/**
+ * Send the front of a buffer chain.
+ *
+ * The sxs_iobuf_send() function sends the chain on the socket 'sd' with
+ * a single call to sxs_sendv(), passing it 'flags', and consumes the
+ * bytes which were sent, whose number is passed back via 'p_sent'. With
+ * MSG_DONTWAIT in 'flags' it suits the write callback of an event loop.
+ * @param sd The socket descriptor of the socket to send bytes on.
+ * @param p_iobuf Pointer to the chain to send.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_sent Pointer to var to store resulting num of bytes sent.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_sendv().
+ * @retval SXS_SUCCESS Successfully sent data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_send(sxs_socket_t sd, sxs_iobuf_t *p_iobuf,
+    int flags, sxs_ssize_t *p_sent);
+
+/**
+ * Send a whole buffer chain.
+ *
+ * The sxs_iobuf_send_nbytes() function sends every byte of the chain on
+ * the socket 'sd' with sxs_sendv_nbytes(), and leaves the chain empty
+ * on success.
+ * @param sd The socket descriptor of the socket to send bytes on.
+ * @param p_iobuf Pointer to the chain to send.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_sendv_nbytes().
+ * @retval SXS_SUCCESS Successfully sent the whole chain.
+ */
+SXS_EXPORT sxs_error_t sxs_iobuf_send_nbytes(sxs_socket_t sd,
+    sxs_iobuf_t *p_iobuf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_IOBUF_H */
@@ -0,0 +1,547 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_loop.c
+ * @brief This is an implementation file for the lib_sxs event loop API.
+ *
+ * The sxs_loop.c file is an implementation file which contains all the
+ * definitions for the functions which compose the event loop (reactor)
+ * API of lib_sxs.
+ */
+
+#include "sxs_loop.h"
+#include "sxs_config.h"
+
+/* An entry in the connection table. The generation is handed to the
+ * poller as the user data of the socket so that events collected for a
+ * socket that was removed (and possibly re-added) by an earlier
+ * callback in the same iteration can be recognized and dropped. */
+struct sxs_loop_conn {
+    sxs_loop_cb_t read_cb;
+    sxs_loop_cb_t write_cb;
+    sxs_loop_cb_t error_cb;
+    void *p_data;
+    size_t gen;
+    int in_use;
+};
+
+struct sxs_loop {
+    sxs_poller_t *p_poller;
+    sxs_timer_wheel_t *p_timers;
+    struct sxs_loop_conn *p_conns;
+    size_t num_conns;
+    size_t next_gen;
+    sxs_loop_defer_t *p_deferred;   /* entries for the current iteration */
+    sxs_loop_defer_t *p_running;    /* entries being called */
+    volatile int stop;
+#ifdef WIN32
+    sxs_socket_t wake_sd;
+#else
+    int wake_fds[2];
+#endif
+};
+
+static sxs_error_t sxs_loop_wake_open(sxs_loop_t *p_loop) {
+#ifdef WIN32
+    /* Windows can not poll a pipe, so the loop wakes itself up with a
+     * loopback datagram socket connected to its own address. */
+    sxs_sockaddr_in_t addr;
+    sxs_socklen_t addrlen;
+    sxs_error_t reterr;
+
+    reterr = sxs_socket(SXS_AF_INET, SXS_SOCK_DGRAM, 0, &p_loop->wake_sd);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = SXS_AF_INET;
+    addr.sin_addr.s_addr = sxs_inet_addr("127.0.0.1");
+    addr.sin_port = 0;
+    addrlen = sizeof(addr);
+
+    reterr = sxs_bind(p_loop->wake_sd, (sxs_sockaddr_t *)&addr, addrlen);
+    if ((reterr == SXS_SUCCESS) && (getsockname(p_loop->wake_sd,
+        (sxs_sockaddr_t *)&addr, &addrlen) == SXS_SOCKET_ERROR)) {
+        reterr = SXS_UNKNOWN_ERROR;
+    }
+    if (reterr == SXS_SUCCESS) {
+        reterr = sxs_connect(p_loop->wake_sd, (sxs_sockaddr_t *)&addr,
+            addrlen);
+    }
+    if (reterr == SXS_SUCCESS) {
+        reterr = sxs_set_nonblock(p_loop->wake_sd, 1);
+    }
+    if (reterr != SXS_SUCCESS) {
+        sxs_close(p_loop->wake_sd);
+        return reterr;
+    }
+#else
+    sxs_errno_t errsv;
+    int i;
+
+    if (pipe(p_loop->wake_fds) == -1) {
+        errsv = errno;
+        if (errsv == EMFILE) {
+            return SXS_EMFILE;
+        } else if (errsv == ENFILE) {
+            return SXS_ENFILE;
+        } else {
+            return SXS_UNKNOWN_ERROR;
+        }
+    }
+
+    for (i = 0; i < 2; i++) {
+        fcntl(p_loop->wake_fds[i], F_SETFD, FD_CLOEXEC);
+        fcntl(p_loop->wake_fds[i], F_SETFL,
+            (fcntl(p_loop->wake_fds[i], F_GETFL, 0) | O_NONBLOCK));
+    }
+#endif
+
+    return SXS_SUCCESS;
+}
+
+static sxs_socket_t sxs_loop_wake_sd(sxs_loop_t *p_loop) {
+#ifdef WIN32
+    return p_loop->wake_sd;
+#else
+    return p_loop->wake_fds[0];
+#endif
+}
+
+static sxs_error_t sxs_loop_wake_close(sxs_loop_t *p_loop) {
+    sxs_error_t reterr;
+
+    reterr = SXS_SUCCESS;
+#ifdef WIN32
+    if (sxs_close(p_loop->wake_sd) != SXS_SUCCESS) {
+        reterr = SXS_ERRCLOSEFAIL;
+    }
+#else
+    if (close(p_loop->wake_fds[0]) == -1) {
+        reterr = SXS_ERRCLOSEFAIL;
+    }
+    if (close(p_loop->wake_fds[1]) == -1) {
+        reterr = SXS_ERRCLOSEFAIL;
+    }
+#endif
+
+    return reterr;
+}
+
+static void sxs_loop_wake_drain(sxs_loop_t *p_loop) {
+    char buf[64];
+
+#ifdef WIN32
+    while (recv(p_loop->wake_sd, buf, sizeof(buf), 0) > 0)
+        ;
+#else
+    while (read(p_loop->wake_fds[0], buf, sizeof(buf)) > 0)
+        ;
+#endif
+}
+
+static sxs_error_t sxs_loop_grow_conns(sxs_loop_t *p_loop, size_t index) {
+    struct sxs_loop_conn *p_conns;
+    size_t num_conns;
+
+    if (index < p_loop->num_conns) {
+        return SXS_SUCCESS;
+    }
+
+    num_conns = (p_loop->num_conns > 0) ? p_loop->num_conns : 64;
+    while (num_conns <= index) {
+        num_conns = num_conns * 2;
+    }
+
+    p_conns = realloc(p_loop->p_conns,
+        (num_conns * sizeof(struct sxs_loop_conn)));
+    if (p_conns == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    memset((p_conns + p_loop->num_conns), 0,
+        ((num_conns - p_loop->num_conns) * sizeof(struct sxs_loop_conn)));
+    p_loop->p_conns = p_conns;
+    p_loop->num_conns = num_conns;
+
+    return SXS_SUCCESS;
+}
+
+static struct sxs_loop_conn *sxs_loop_lookup(sxs_loop_t *p_loop,
+    sxs_socket_t sd, size_t gen) {
+
+    struct sxs_loop_conn *p_conn;
+
+    if ((size_t)sd >= p_loop->num_conns) {
+        return NULL;
+    }
+
+    p_conn = &p_loop->p_conns[(size_t)sd];
+    if ((!p_conn->in_use) || ((gen != 0) && (p_conn->gen != gen))) {
+        return NULL;
+    }
+
+    return p_conn;
+}
+
+static void sxs_loop_defer_unlink(sxs_loop_defer_t *p_defer) {
+    if (p_defer->p_prev != NULL) {
+        p_defer->p_prev->p_next = p_defer->p_next;
+    } else {
+        *(p_defer->pp_list) = p_defer->p_next;
+    }
+    if (p_defer->p_next != NULL) {
+        p_defer->p_next->p_prev = p_defer->p_prev;
+    }
+    p_defer->p_next = NULL;
+    p_defer->p_prev = NULL;
+    p_defer->pp_list = NULL;
+}
+
+/* Call the entries deferred so far. Entries deferred again by the
+ * callbacks are queued for the next iteration, while entries cancelled
+ * by them are unlinked from the list being called. */
+static void sxs_loop_run_deferred(sxs_loop_t *p_loop) {
+    sxs_loop_defer_t *p_defer;
+
+    p_loop->p_running = p_loop->p_deferred;
+    p_loop->p_deferred = NULL;
+    for (p_defer = p_loop->p_running; p_defer != NULL;
+        p_defer = p_defer->p_next) {
+        p_defer->pp_list = &p_loop->p_running;
+    }
+
+    while (p_loop->p_running != NULL) {
+        p_defer = p_loop->p_running;
+        sxs_loop_defer_unlink(p_defer);
+        p_defer->cb(p_loop, p_defer->p_data);
+    }
+}
+
+sxs_error_t sxs_loop_create(int max_events, sxs_loop_t **pp_loop) {
+    sxs_loop_t *p_loop;
+    sxs_error_t reterr;
+
+    p_loop = calloc(1, sizeof(sxs_loop_t));
+    if (p_loop == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    /* One extra event is reserved for the wake up descriptor. */
+    reterr = sxs_poller_create((max_events > 0) ? (max_events + 1) : 0,
+        &p_loop->p_poller);
+    if (reterr != SXS_SUCCESS) {
+        free(p_loop);
+        return reterr;
+    }
+
+    reterr = sxs_timer_wheel_create(1, &p_loop->p_timers);
+    if (reterr != SXS_SUCCESS) {
+        sxs_poller_destroy(p_loop->p_poller);
+        free(p_loop);
+        return reterr;
+    }
+
+    reterr = sxs_loop_wake_open(p_loop);
+    if (reterr != SXS_SUCCESS) {
+        sxs_timer_wheel_destroy(p_loop->p_timers);
+        sxs_poller_destroy(p_loop->p_poller);
+        free(p_loop);
+        return reterr;
+    }
+
+    reterr = sxs_poller_add(p_loop->p_poller, sxs_loop_wake_sd(p_loop),
+        SXS_POLLIN, NULL);
+    if (reterr != SXS_SUCCESS) {
+        sxs_loop_wake_close(p_loop);
+        sxs_timer_wheel_destroy(p_loop->p_timers);
+        sxs_poller_destroy(p_loop->p_poller);
+        free(p_loop);
+        return reterr;
+    }
+
+    p_loop->next_gen = 1;
+    *pp_loop = p_loop;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_loop_destroy(sxs_loop_t *p_loop) {
+    sxs_error_t reterr;
+
+    while (p_loop->p_deferred != NULL) {
+        sxs_loop_defer_unlink(p_loop->p_deferred);
+    }
+
+    reterr = sxs_poller_destroy(p_loop->p_poller);
+    sxs_timer_wheel_destroy(p_loop->p_timers);
+    if (sxs_loop_wake_close(p_loop) != SXS_SUCCESS) {
+        reterr = SXS_ERRCLOSEFAIL;
+    }
+    free(p_loop->p_conns);
+    free(p_loop);
+
+    return reterr;
+}
+
+sxs_error_t sxs_loop_add(sxs_loop_t *p_loop, sxs_socket_t sd, int events,
+    sxs_loop_cb_t read_cb, sxs_loop_cb_t write_cb, sxs_loop_cb_t error_cb,
+    void *p_data) {
+
+    struct sxs_loop_conn *p_conn;
+    sxs_error_t reterr;
+    size_t gen;
+
+    if (sd == SXS_INVALID_SOCKET) {
+        return SXS_EBADF;
+    }
+
+    reterr = sxs_loop_grow_conns(p_loop, (size_t)sd);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    p_conn = &p_loop->p_conns[(size_t)sd];
+    if (p_conn->in_use) {
+        return SXS_EEXIST;
+    }
+
+    gen = p_loop->next_gen++;
+    if (p_loop->next_gen == 0) {
+        p_loop->next_gen = 1;
+    }
+
+    reterr = sxs_poller_add(p_loop->p_poller, sd, events, (void *)gen);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    p_conn->read_cb = read_cb;
+    p_conn->write_cb = write_cb;
+    p_conn->error_cb = error_cb;
+    p_conn->p_data = p_data;
+    p_conn->gen = gen;
+    p_conn->in_use = 1;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_loop_modify(sxs_loop_t *p_loop, sxs_socket_t sd,
+    int events) {
+
+    struct sxs_loop_conn *p_conn;
+
+    p_conn = sxs_loop_lookup(p_loop, sd, 0);
+    if (p_conn == NULL) {
+        return SXS_ENOENT;
+    }
+
+    return sxs_poller_modify(p_loop->p_poller, sd, events,
+        (void *)p_conn->gen);
+}
+
+sxs_error_t sxs_loop_remove(sxs_loop_t *p_loop, sxs_socket_t sd) {
+    struct sxs_loop_conn *p_conn;
+
+    p_conn = sxs_loop_lookup(p_loop, sd, 0);
+    if (p_conn == NULL) {
+        return SXS_ENOENT;
+    }
+
+    memset(p_conn, 0, sizeof(struct sxs_loop_conn));
+
+    return sxs_poller_remove(p_loop->p_poller, sd);
+}
+
+sxs_timer_wheel_t *sxs_loop_timers(sxs_loop_t *p_loop) {
+    return p_loop->p_timers;
+}
+
+void sxs_loop_defer_init(sxs_loop_defer_t *p_defer,
+    sxs_loop_defer_cb_t cb, void *p_data) {
+    memset(p_defer, 0, sizeof(sxs_loop_defer_t));
+    p_defer->cb = cb;
+    p_defer->p_data = p_data;
+}
+
+void sxs_loop_defer(sxs_loop_t *p_loop, sxs_loop_defer_t *p_defer) {
+    if (p_defer->pp_list == &p_loop->p_deferred) {
+        return;
+    }
+    if (p_defer->pp_list != NULL) {    /* being called, or on another loop */
+        sxs_loop_defer_unlink(p_defer);
+    }
+
+    p_defer->p_prev = NULL;
+    p_defer->p_next = p_loop->p_deferred;
+    if (p_loop->p_deferred != NULL) {
+        p_loop->p_deferred->p_prev = p_defer;
+    }
+    p_loop->p_deferred = p_defer;
+    p_defer->pp_list = &p_loop->p_deferred;
+}
+
+void sxs_loop_defer_cancel(sxs_loop_defer_t *p_defer) {
+    if (p_defer->pp_list != NULL) {
+        sxs_loop_defer_unlink(p_defer);
+    }
+}
+
+int sxs_loop_defer_pending(const sxs_loop_defer_t *p_defer) {
+    return (p_defer->pp_list != NULL);
+}
+
+sxs_error_t sxs_loop_run_once(sxs_loop_t *p_loop,
+    const struct timeval *p_timeout, int *p_num_dispatched) {
+
+    sxs_poll_event_t *p_events;
+    struct sxs_loop_conn *p_conn;
+    struct timeval timer_timeout;
+    struct timeval zero_timeout;
+    sxs_uint64_t elapsed;
+    sxs_error_t reterr;
+    sxs_socket_t sd;
+    size_t gen;
+    long timer_ms;
+    int num_ready;
+    int num_dispatched;
+    int num_expired;
+    int events;
+    int i;
+
+    num_dispatched = 0;
+
+    /* The wait is bounded by the next timer, counted from the time the
+     * wheel was last advanced. */
+    sxs_timer_wheel_next(p_loop->p_timers, &timer_ms);
+    if (timer_ms >= 0) {
+        elapsed = sxs_monotonic_ms() - sxs_timer_wheel_now(p_loop->p_timers);
+        timer_ms = (elapsed < (sxs_uint64_t)timer_ms) ?
+            (timer_ms - (long)elapsed) : 0;
+        if ((p_timeout == NULL) || (((p_timeout->tv_sec * 1000) +
+            (p_timeout->tv_usec / 1000)) > timer_ms)) {
+            timer_timeout.tv_sec = timer_ms / 1000;
+            timer_timeout.tv_usec = (timer_ms % 1000) * 1000;
+            p_timeout = &timer_timeout;
+        }
+    }
+
+    /* Work deferred outside of an iteration must not wait for sockets. */
+    if (p_loop->p_deferred != NULL) {
+        zero_timeout.tv_sec = 0;
+        zero_timeout.tv_usec = 0;
+        p_timeout = &zero_timeout;
+    }
+
+    reterr = sxs_poller_wait(p_loop->p_poller, p_timeout, &p_events,
+        &num_ready);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    /* Timers are expired first so that timers started by the socket
+     * callbacks are relative to the current time. */
+    sxs_timer_wheel_advance(p_loop->p_timers, sxs_monotonic_ms(),
+        &num_expired);
+    num_dispatched += num_expired;
+
+    for (i = 0; i < num_ready; i++) {
+        sd = p_events[i].sd;
+        events = p_events[i].events;
+        gen = (size_t)p_events[i].p_data;
+
+        if (gen == 0) { /* wake up descriptor */
+            sxs_loop_wake_drain(p_loop);
+            continue;
+        }
+
+        /* The connection table may be reallocated and the entry removed
+         * by any callback, so it is looked up again before each one. */
+        p_conn = sxs_loop_lookup(p_loop, sd, gen);
+        if (p_conn == NULL) {
+            continue;
+        }
+        num_dispatched++;
+
+        if ((events & SXS_POLLERR) && (p_conn->error_cb != NULL)) {
+            p_conn->error_cb(p_loop, sd, events, p_conn->p_data);
+            continue;
+        }
+
+        if (events & (SXS_POLLIN | SXS_POLLHUP | SXS_POLLERR)) {
+            if (p_conn->read_cb != NULL) {
+                p_conn->read_cb(p_loop, sd, events, p_conn->p_data);
+            } else if (p_conn->error_cb != NULL) {
+                p_conn->error_cb(p_loop, sd, events, p_conn->p_data);
+            }
+        }
+
+        if (events & SXS_POLLOUT) {
+            p_conn = sxs_loop_lookup(p_loop, sd, gen);
+            if ((p_conn != NULL) && (p_conn->write_cb != NULL)) {
+                p_conn->write_cb(p_loop, sd, events, p_conn->p_data);
+            }
+        }
+    }
+
+    sxs_loop_run_deferred(p_loop);
+
+    if (p_num_dispatched != NULL) {
+        *p_num_dispatched = num_dispatched;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_loop_run(sxs_loop_t *p_loop) {
+    sxs_error_t reterr;
+
+    while (!p_loop->stop) {
+        reterr = sxs_loop_run_once(p_loop, NULL, NULL);
+        if ((reterr != SXS_SUCCESS) && (reterr != SXS_EINTR)) {
+            p_loop->stop = 0;
+            return reterr;
+        }
+    }
+
+    p_loop->stop = 0;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_loop_stop(sxs_loop_t *p_loop) {
+    char c;
+
+    c = 0;
+    p_loop->stop = 1;
+
+#ifdef WIN32
+    if (send(p_loop->wake_sd, &c, 1, 0) == SXS_SOCKET_ERROR) {
+        if (WSAGetLastError() != WSAEWOULDBLOCK) {
+            return SXS_UNKNOWN_ERROR;
+        }
+    }
+#else
+    /* A full pipe already guarantees a pending wake up. */
+    if (write(p_loop->wake_fds[1], &c, 1) == -1) {
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+            return SXS_UNKNOWN_ERROR;
+        }
+    }
+#endif
+
+    return SXS_SUCCESS;
+}
@@ -0,0 +1,312 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_loop.h
+ * @brief This is a specifications file for the lib_sxs event loop API.
+ *
+ * The sxs_loop.h file is a specifications file that defines the
+ * functions which compose the event loop (reactor) API of lib_sxs. An
+ * event loop dispatches per-socket callbacks as the sockets registered
+ * with it become ready, allowing a single thread to serve a large
+ * number of connections.
+ */
+
+#ifndef SXS_LOOP_H
+#define SXS_LOOP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+#include "sxs_poll.h"
+#include "sxs_timer.h"
+
+/**
+ * @typedef sxs_loop_t
+ * @brief An opaque event loop.
+ *
+ * The sxs_loop_t type represents an event loop. It owns a poller and a
+ * connection table indexed by socket descriptor which holds the
+ * callbacks registered for each socket.
+ */
+typedef struct sxs_loop sxs_loop_t;
+
+/**
+ * @typedef sxs_loop_cb_t
+ * @brief A socket event callback.
+ *
+ * The sxs_loop_cb_t type is the type of the read, write and error
+ * callbacks registered with sxs_loop_add(). The callback is passed the
+ * loop, the ready socket, the OR'd SXS_POLL* events which were reported
+ * and the user data pointer given at registration. A callback may
+ * freely add, modify or remove any socket, including its own.
+ */
+typedef void (*sxs_loop_cb_t)(sxs_loop_t *p_loop, sxs_socket_t sd,
+    int events, void *p_data);
+
+typedef struct sxs_loop_defer sxs_loop_defer_t;
+
+/**
+ * @typedef sxs_loop_defer_cb_t
+ * @brief A deferred callback.
+ *
+ * The sxs_loop_defer_cb_t type is the type of the callback called at
+ * the end of a loop iteration for a deferred entry. The callback is
+ * passed the loop and the user data pointer given to
+ * sxs_loop_defer_init(). The entry is no longer queued when the
+ * callback is called, so the callback may defer it again, in which case
+ * it is called at the end of the next iteration.
+ */
+typedef void (*sxs_loop_defer_cb_t)(sxs_loop_t *p_loop, void *p_data);
+
+/**
+ * @typedef sxs_loop_defer_t
+ * @brief A deferred callback entry.
+ *
+ * The sxs_loop_defer_t type is an entry which queues a callback to be
+ * called once at the end of the current loop iteration, e.g. to combine
+ * the work requested by several socket callbacks. Like a timer it is
+ * allocated by the application, usually as a member of its
+ * per-connection structure, so deferring it never allocates memory. Its
+ * members are private and must only be accessed through the
+ * sxs_loop_defer*() functions.
+ */
+struct sxs_loop_defer {
+    sxs_loop_defer_t *p_next;
+    sxs_loop_defer_t *p_prev;
+    sxs_loop_defer_t **pp_list;
+    sxs_loop_defer_cb_t cb;
+    void *p_data;
+};
+
+/**
+ * Create an event loop.
+ *
+ * The sxs_loop_create() function creates a new event loop with no
+ * registered sockets and passes it back via the 'pp_loop' parameter.
+ * The 'max_events' parameter specifies the maximum number of ready
+ * sockets dispatched per iteration of the loop.
+ * @param max_events Maximum number of ready sockets per iteration.
+ * @param pp_loop Pointer to loop pointer to store the new loop in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the loop.
+ * @retval SXS_EINVAL The 'max_events' parameter is not positive.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ * @retval SXS_EMFILE The per-process open file descriptor limit was hit.
+ * @retval SXS_ENFILE The system limit of open file descriptors was hit.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_loop_create(int max_events,
+    sxs_loop_t **pp_loop);
+
+/**
+ * Destroy an event loop.
+ *
+ * The sxs_loop_destroy() function releases all resources associated
+ * with the given loop. The registered sockets are not closed. It must
+ * not be called while the loop is running.
+ * @param p_loop Pointer to the loop to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the loop.
+ * @retval SXS_ERRCLOSEFAIL Failed to close an internal descriptor.
+ */
+SXS_EXPORT sxs_error_t sxs_loop_destroy(sxs_loop_t *p_loop);
+
+/**
+ * Register a socket and its callbacks with an event loop.
+ *
+ * The sxs_loop_add() function registers the socket 'sd' with the loop
+ * for the OR'd SXS_POLL* 'events'. Sockets are dispatched level
+ * triggered unless SXS_POLLET is included in 'events', in which case
+ * they are dispatched edge triggered and the callbacks must drain the
+ * socket until SXS_EWOULDBLOCK. When the socket becomes readable (or is
+ * hung up) 'read_cb' is called, when it becomes writable 'write_cb' is
+ * called and when an error is pending on it 'error_cb' is called. Any of
+ * the callbacks may be NULL. If 'error_cb' is NULL errors are reported
+ * to 'read_cb' instead, where they surface from the next receive.
+ * @param p_loop Pointer to the loop to register the socket with.
+ * @param sd The socket descriptor to register.
+ * @param events OR'd SXS_POLL* events to monitor the socket for.
+ * @param read_cb Callback to call when the socket is readable.
+ * @param write_cb Callback to call when the socket is writable.
+ * @param error_cb Callback to call when an error is pending.
+ * @param p_data User data pointer passed to the callbacks.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully registered the socket.
+ * @retval SXS_EEXIST The socket is already registered.
+ * @retval SXS_EBADF The socket descriptor is invalid.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_loop_add(sxs_loop_t *p_loop, sxs_socket_t sd,
+    int events, sxs_loop_cb_t read_cb, sxs_loop_cb_t write_cb,
+    sxs_loop_cb_t error_cb, void *p_data);
+
+/**
+ * Change the events a registered socket is monitored for.
+ *
+ * The sxs_loop_modify() function replaces the OR'd SXS_POLL* 'events' a
+ * registered socket is monitored for while keeping its callbacks and
+ * user data. It is typically used to enable SXS_POLLOUT only while
+ * there is data waiting to be sent.
+ * @param p_loop Pointer to the loop the socket is registered with.
+ * @param sd The socket descriptor to modify.
+ * @param events OR'd SXS_POLL* events to monitor the socket for.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully modified the socket.
+ * @retval SXS_ENOENT The socket is not registered.
+ * @retval SXS_EBADF The socket descriptor is invalid.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_loop_modify(sxs_loop_t *p_loop,
+    sxs_socket_t sd, int events);
+
+/**
+ * Unregister a socket from an event loop.
+ *
+ * The sxs_loop_remove() function unregisters the socket 'sd' from the
+ * loop. No callback will be called for the socket after this returns,
+ * even for events already collected in the current iteration. The
+ * socket must be removed before it is closed.
+ * @param p_loop Pointer to the loop the socket is registered with.
+ * @param sd The socket descriptor to unregister.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully unregistered the socket.
+ * @retval SXS_ENOENT The socket is not registered.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_loop_remove(sxs_loop_t *p_loop,
+    sxs_socket_t sd);
+
+/**
+ * Get the timer wheel of an event loop.
+ *
+ * The sxs_loop_timers() function returns the timer wheel owned by the
+ * loop. Timers started on it are expired by the loop itself, with a
+ * resolution of one millisecond, and their callbacks are called on the
+ * thread running the loop. The wheel must only be used from that
+ * thread.
+ * @param p_loop Pointer to the loop.
+ * @return Pointer to the timer wheel of the loop.
+ */
+SXS_EXPORT sxs_timer_wheel_t *sxs_loop_timers(sxs_loop_t *p_loop);
+
+/**
+ * Initialize a deferred callback entry.
+ *
+ * The sxs_loop_defer_init() function initializes the entry with the
+ * callback to call at the end of the iteration it is deferred in and
+ * the user data pointer to pass to it. An entry must be initialized
+ * once before it is first deferred.
+ * @param p_defer Pointer to the entry to initialize.
+ * @param cb The callback to call.
+ * @param p_data User data pointer passed to the callback.
+ */
+SXS_EXPORT void sxs_loop_defer_init(sxs_loop_defer_t *p_defer,
+    sxs_loop_defer_cb_t cb, void *p_data);
+
+/**
+ * Defer a callback to the end of the current loop iteration.
+ *
+ * The sxs_loop_defer() function queues the entry so that its callback
+ * is called once after the socket callbacks of the current iteration
+ * have been dispatched, or of the next one if called from outside the
+ * loop. Deferring an entry which is already queued has no effect, so
+ * it may be called for every piece of work the callback should cover.
+ * An iteration started while entries are queued does not wait for the
+ * sockets. The loop must only be used from the thread running it.
+ * @param p_loop Pointer to the loop.
+ * @param p_defer Pointer to the entry to defer.
+ */
+SXS_EXPORT void sxs_loop_defer(sxs_loop_t *p_loop,
+    sxs_loop_defer_t *p_defer);
+
+/**
+ * Cancel a deferred callback.
+ *
+ * The sxs_loop_defer_cancel() function removes the entry from the queue
+ * of its loop so that its callback is not called. Cancelling an entry
+ * which is not queued has no effect. An entry must be cancelled before
+ * the memory holding it is released.
+ * @param p_defer Pointer to the entry to cancel.
+ */
+SXS_EXPORT void sxs_loop_defer_cancel(sxs_loop_defer_t *p_defer);
+
+/**
+ * Check whether a deferred callback is queued.
+ *
+ * The sxs_loop_defer_pending() function checks whether the entry has
+ * been deferred and its callback has neither been called nor cancelled
+ * since.
+ * @param p_defer Pointer to the entry to check.
+ * @return Non-zero if the entry is queued, 0 otherwise.
+ */
+SXS_EXPORT int sxs_loop_defer_pending(const sxs_loop_defer_t *p_defer);
+
+/**
+ * Run a single iteration of an event loop.
+ *
+ * The sxs_loop_run_once() function waits up to 'p_timeout' for
+ * registered sockets to become ready and dispatches their callbacks. If
+ * 'p_timeout' is NULL it will block until at least one socket is ready
+ * or the loop is stopped. The wait is cut short when a timer of the
+ * loop's timer wheel is due, and expired timers are dispatched before
+ * the sockets. Deferred callbacks are called last.
+ * @param p_loop Pointer to the loop to run.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to wait for a socket to become ready.
+ * @param p_num_dispatched Pointer to var to store the number of ready
+ * sockets and expired timers dispatched in, may be NULL.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully ran the iteration.
+ * @retval SXS_EINTR A signal was caught.
+ * @retval SXS_EINVAL The timeout is invalid.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_loop_run_once(sxs_loop_t *p_loop,
+    const struct timeval *p_timeout, int *p_num_dispatched);
+
+/**
+ * Run an event loop until it is stopped.
+ *
+ * The sxs_loop_run() function repeatedly runs iterations of the loop on
+ * the calling thread until sxs_loop_stop() is called. Interrupted waits
+ * are restarted.
+ * @param p_loop Pointer to the loop to run.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS The loop was stopped.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_loop_run(sxs_loop_t *p_loop);
+
+/**
+ * Stop a running event loop.
+ *
+ * The sxs_loop_stop() function makes sxs_loop_run() return after the
+ * current iteration. It may be called from a callback or from any other
+ * thread, in which case a blocked wait is woken up.
+ * @param p_loop Pointer to the loop to stop.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully requested the loop to stop.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_loop_stop(sxs_loop_t *p_loop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_LOOP_H */
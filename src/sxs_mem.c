@@ -0,0 +1,276 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_mem.c
+ * @brief This is an implementation file for the lib_sxs I/O buffer
+ * memory allocator.
+ *
+ * The sxs_mem.c file is an implementation file which contains the
+ * allocator of the memory backing the buffers lib_sxs manages itself,
+ * those of the read and write buffers and of the buffer pools. It
+ * applies the memory policy given to sxs_init_ex(). Every part of the
+ * policy is best effort: memory is still handed out, with normal pages
+ * or on any node, when the system cannot honour it.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+#ifndef WIN32
+    #include <sys/mman.h>
+    #if defined(__linux__)
+        #include <sys/syscall.h>
+    #endif
+    #if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+        #define MAP_ANONYMOUS MAP_ANON
+    #endif
+#endif
+
+/* The size of the huge pages asked for, which is the only size x86-64
+ * and the default of arm64 Linux have transparent huge pages of. */
+#define SXS_MEM_HUGE_SIZE (2 * 1024 * 1024)
+
+/* mbind() is issued as a raw system call so that lib_sxs does not
+ * depend on libnuma, and these come from <linux/mempolicy.h>. */
+#define SXS_MEM_MPOL_BIND 2
+#define SXS_MEM_MAX_NODES 1024
+
+static int sxs_mem_policy_flags = 0;
+static int sxs_mem_policy_node = 0;
+
+sxs_error_t sxs_mem_policy(int flags, int node) {
+    if ((flags & ~(SXS_MEM_HUGEPAGES | SXS_MEM_NUMA | SXS_MEM_PREFAULT |
+        SXS_MEM_LOCK)) != 0) {
+        return SXS_EINVAL;
+    }
+    if ((flags & SXS_MEM_NUMA) &&
+        ((node < 0) || (node >= SXS_MEM_MAX_NODES))) {
+        return SXS_EINVAL;
+    }
+
+    sxs_mem_policy_flags = flags;
+    sxs_mem_policy_node = node;
+
+    return SXS_SUCCESS;
+}
+
+sxs_size_t sxs_mem_huge_size(void) {
+    if (sxs_mem_policy_flags & SXS_MEM_HUGEPAGES) {
+        return SXS_MEM_HUGE_SIZE;
+    }
+
+    return 0;
+}
+
+static sxs_size_t sxs_mem_page_size(void) {
+#ifdef WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return (sxs_size_t)info.dwPageSize;
+#else
+    long page;
+
+    page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) {
+        page = 4096;
+    }
+    return (sxs_size_t)page;
+#endif
+}
+
+void sxs_mem_apply(void *p_data, sxs_size_t size) {
+    volatile char *p_page;
+    sxs_size_t page;
+    sxs_size_t off;
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long nodemask[SXS_MEM_MAX_NODES / (8 * sizeof(unsigned long))];
+#endif
+
+    /* The node has to be set before the pages are first touched, as
+     * that is when they are placed. */
+#if defined(__linux__) && defined(SYS_mbind)
+    if (sxs_mem_policy_flags & SXS_MEM_NUMA) {
+        memset(nodemask, 0, sizeof(nodemask));
+        nodemask[sxs_mem_policy_node / (8 * sizeof(unsigned long))] =
+            1UL << (sxs_mem_policy_node % (8 * sizeof(unsigned long)));
+        syscall(SYS_mbind, p_data, (unsigned long)size,
+            SXS_MEM_MPOL_BIND, nodemask,
+            (unsigned long)((8 * sizeof(nodemask)) + 1), 0);
+    }
+#endif
+
+    if (sxs_mem_policy_flags & SXS_MEM_LOCK) {
+#ifdef WIN32
+        VirtualLock(p_data, size);
+#else
+        mlock(p_data, size);
+#endif
+    }
+
+    if (sxs_mem_policy_flags & SXS_MEM_PREFAULT) {
+        page = sxs_mem_page_size();
+        p_page = (volatile char *)p_data;
+        for (off = 0; off < size; off += page) {
+            p_page[off] = 0;
+        }
+    }
+}
+
+#ifdef WIN32
+
+static char *sxs_mem_map(sxs_size_t *p_size) {
+    SIZE_T large;
+    DWORD type;
+    char *p_data;
+
+    type = (MEM_RESERVE | MEM_COMMIT);
+    large = GetLargePageMinimum();
+    if ((sxs_mem_policy_flags & SXS_MEM_HUGEPAGES) && (large != 0) &&
+        ((*p_size) >= large)) {
+        type |= MEM_LARGE_PAGES;
+        (*p_size) = (((*p_size) + large - 1) / large) * large;
+    }
+
+    /* Large pages need the lock memory privilege, so they are asked for
+     * first and dropped if refused. */
+    while (1) {
+        if (sxs_mem_policy_flags & SXS_MEM_NUMA) {
+            p_data = (char *)VirtualAllocExNuma(GetCurrentProcess(), NULL,
+                (*p_size), type, PAGE_READWRITE,
+                (DWORD)sxs_mem_policy_node);
+        } else {
+            p_data = (char *)VirtualAlloc(NULL, (*p_size), type,
+                PAGE_READWRITE);
+        }
+        if ((p_data != NULL) || (!(type & MEM_LARGE_PAGES))) {
+            return p_data;
+        }
+        type &= ~MEM_LARGE_PAGES;
+    }
+}
+
+static void sxs_mem_unmap(char *p_data, sxs_size_t size) {
+    VirtualFree(p_data, 0, MEM_RELEASE);
+}
+
+#else
+
+static char *sxs_mem_map(sxs_size_t *p_size) {
+    sxs_size_t page;
+    char *p_data;
+#if defined(__linux__)
+    char *p_aligned;
+    sxs_size_t lead;
+#endif
+
+    page = sxs_mem_page_size();
+    (*p_size) = (((*p_size) + page - 1) / page) * page;
+    if ((*p_size) == 0) {
+        (*p_size) = page;
+    }
+
+#if defined(__linux__)
+    if ((sxs_mem_policy_flags & SXS_MEM_HUGEPAGES) &&
+        ((*p_size) >= SXS_MEM_HUGE_SIZE)) {
+        (*p_size) = (((*p_size) + SXS_MEM_HUGE_SIZE - 1) /
+            SXS_MEM_HUGE_SIZE) * SXS_MEM_HUGE_SIZE;
+
+        /* Pages from the reserved huge page pool are the surest, but
+         * most systems reserve none. */
+    #if defined(MAP_HUGETLB)
+        p_data = (char *)mmap(NULL, (*p_size), (PROT_READ | PROT_WRITE),
+            (MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB), -1, 0);
+        if (p_data != (char *)MAP_FAILED) {
+            return p_data;
+        }
+    #endif
+
+        /* Otherwise ask for transparent huge pages, which the kernel
+         * only uses for ranges aligned to the huge page size. */
+        p_data = (char *)mmap(NULL, ((*p_size) + SXS_MEM_HUGE_SIZE),
+            (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+        if (p_data == (char *)MAP_FAILED) {
+            return NULL;
+        }
+        p_aligned = (char *)((((unsigned long)p_data) +
+            SXS_MEM_HUGE_SIZE - 1) & ~((unsigned long)SXS_MEM_HUGE_SIZE - 1));
+        lead = p_aligned - p_data;
+        if (lead > 0) {
+            munmap(p_data, lead);
+        }
+        munmap((p_aligned + (*p_size)), (SXS_MEM_HUGE_SIZE - lead));
+    #if defined(MADV_HUGEPAGE)
+        madvise(p_aligned, (*p_size), MADV_HUGEPAGE);
+    #endif
+        return p_aligned;
+    }
+#endif
+
+    p_data = (char *)mmap(NULL, (*p_size), (PROT_READ | PROT_WRITE),
+        (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+    if (p_data == (char *)MAP_FAILED) {
+        return NULL;
+    }
+
+    return p_data;
+}
+
+static void sxs_mem_unmap(char *p_data, sxs_size_t size) {
+    munmap(p_data, size);
+}
+
+#endif
+
+sxs_error_t sxs_mem_alloc(sxs_size_t size, sxs_mem_t *p_mem) {
+    /* Without a policy buffers come from the heap as they always did. */
+    if (sxs_mem_policy_flags == 0) {
+        p_mem->p_data = (char *)malloc(size);
+        if (p_mem->p_data == NULL) {
+            return SXS_ENOMEM;
+        }
+        p_mem->size = size;
+        p_mem->mapped = 0;
+        return SXS_SUCCESS;
+    }
+
+    p_mem->size = size;
+    p_mem->p_data = sxs_mem_map(&p_mem->size);
+    if (p_mem->p_data == NULL) {
+        return SXS_ENOMEM;
+    }
+    p_mem->mapped = 1;
+
+    sxs_mem_apply(p_mem->p_data, p_mem->size);
+
+    return SXS_SUCCESS;
+}
+
+void sxs_mem_free(sxs_mem_t *p_mem) {
+    if (p_mem->p_data == NULL) {
+        return;
+    }
+
+    if (p_mem->mapped) {
+        sxs_mem_unmap(p_mem->p_data, p_mem->size);
+    } else {
+        free(p_mem->p_data);
+    }
+    p_mem->p_data = NULL;
+}
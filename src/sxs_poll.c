@@ -0,0 +1,607 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_poll.c
+ * @brief This is an implementation file for the lib_sxs readiness API.
+ *
+ * The sxs_poll.c file is an implementation file which contains all the
+ * definitions for the functions which compose the readiness (poller)
+ * API of lib_sxs.
+ */
+
+#include "sxs_poll.h"
+#include "sxs_config.h"
+
+#include <limits.h>
+
+/* Here we pick the backend used by the poller. On Linux epoll is used
+ * so that the cost of a wait is proportional to the number of ready
+ * sockets rather than the number of monitored sockets. Everywhere else
+ * we fall back to poll() (WSAPoll() on Windows) which at least does not
+ * suffer from the FD_SETSIZE limitation of select(). */
+#ifdef HAVE_SYS_EPOLL_H
+    #include <sys/epoll.h>
+    #define SXS_POLL_EPOLL 1
+#endif
+
+#ifdef WIN32
+    typedef WSAPOLLFD sxs_pollfd_t;
+    #define SXS_SYS_POLL(fds, nfds, timeout) WSAPoll((fds), (nfds), (timeout))
+#else
+    #include <poll.h>
+    typedef struct pollfd sxs_pollfd_t;
+    #define SXS_SYS_POLL(fds, nfds, timeout) poll((fds), (nfds), (timeout))
+#endif
+
+#ifdef SXS_POLL_EPOLL
+/* The epoll backend keeps a table indexed by socket descriptor so that
+ * both the descriptor and the users data pointer can be handed back for
+ * each ready socket while epoll itself only carries the descriptor. */
+struct sxs_poll_slot {
+    void *p_data;
+    int in_use;
+};
+#endif
+
+struct sxs_poller {
+#ifdef SXS_POLL_EPOLL
+    int epfd;
+    struct epoll_event *p_epevents;
+    struct sxs_poll_slot *p_slots;
+    int num_slots;
+#else
+    sxs_pollfd_t *p_pfds;
+    void **pp_data;
+    int *p_reqevents;
+    int num_pfds;
+    int max_pfds;
+#endif
+    sxs_poll_event_t *p_events;
+    int max_events;
+};
+
+static sxs_error_t sxs_poll_timeout_ms(const struct timeval *p_timeout,
+    int *p_ms) {
+
+    long ms;
+
+    if (p_timeout == NULL) {
+        *p_ms = -1;
+        return SXS_SUCCESS;
+    }
+
+    if ((p_timeout->tv_sec < 0) || (p_timeout->tv_usec < 0)) {
+        return SXS_EINVAL;
+    }
+
+    /* Round up so that a sub-millisecond timeout still waits rather
+     * than degrading into a busy poll. */
+    if (p_timeout->tv_sec >= (INT_MAX / 1000)) {
+        *p_ms = INT_MAX;
+    } else {
+        ms = (p_timeout->tv_sec * 1000) + ((p_timeout->tv_usec + 999) / 1000);
+        *p_ms = (ms > INT_MAX) ? INT_MAX : (int)ms;
+    }
+
+    return SXS_SUCCESS;
+}
+
+static short sxs_poll_to_sys(int events) {
+    short sysevents;
+
+    sysevents = 0;
+    if (events & SXS_POLLIN)
+        sysevents |= POLLIN;
+    if (events & SXS_POLLOUT)
+        sysevents |= POLLOUT;
+
+    return sysevents;
+}
+
+static int sxs_poll_from_sys(short sysevents) {
+    int events;
+
+    events = 0;
+    if (sysevents & POLLIN)
+        events |= SXS_POLLIN;
+    if (sysevents & POLLOUT)
+        events |= SXS_POLLOUT;
+    if (sysevents & POLLERR)
+        events |= SXS_POLLERR;
+    if (sysevents & POLLHUP)
+        events |= SXS_POLLHUP;
+
+    return events;
+}
+
+static sxs_error_t sxs_poll_sys_error(void) {
+    sxs_errno_t errsv;
+
+#ifdef WIN32
+    errsv = WSAGetLastError();
+    if (errsv == WSANOTINITIALISED) {
+        return SXS_WSANOTINITIALISED;
+    } else if (errsv == WSAENETDOWN) {
+        return SXS_ENETDOWN;
+    } else if (errsv == WSAEFAULT) {
+        return SXS_EFAULT;
+    } else if (errsv == WSAEINVAL) {
+        return SXS_EINVAL;
+    } else if (errsv == WSAENOBUFS) {
+        return SXS_ENOBUFS;
+    } else {
+        return SXS_UNKNOWN_ERROR;
+    }
+#else
+    errsv = errno;
+    if (errsv == EINTR) {
+        return SXS_EINTR;
+    } else if (errsv == EFAULT) {
+        return SXS_EFAULT;
+    } else if (errsv == EINVAL) {
+        return SXS_EINVAL;
+    } else if (errsv == ENOMEM) {
+        return SXS_ENOMEM;
+    #ifndef __APPLE__
+    } else if (errsv == EAGAIN) {
+        return SXS_ENOMEM;
+    #endif
+    } else {
+        return SXS_UNKNOWN_ERROR;
+    }
+#endif
+}
+
+#ifdef SXS_POLL_EPOLL
+static sxs_uint32_t sxs_poll_to_epoll(int events) {
+    sxs_uint32_t epevents;
+
+    epevents = 0;
+    if (events & SXS_POLLIN)
+        epevents |= EPOLLIN;
+    if (events & SXS_POLLOUT)
+        epevents |= EPOLLOUT;
+    if (events & SXS_POLLET)
+        epevents |= EPOLLET;
+    if (events & SXS_POLLONESHOT)
+        epevents |= EPOLLONESHOT;
+
+    return epevents;
+}
+
+static int sxs_poll_from_epoll(sxs_uint32_t epevents) {
+    int events;
+
+    events = 0;
+    if (epevents & EPOLLIN)
+        events |= SXS_POLLIN;
+    if (epevents & EPOLLOUT)
+        events |= SXS_POLLOUT;
+    if (epevents & EPOLLERR)
+        events |= SXS_POLLERR;
+    if (epevents & EPOLLHUP)
+        events |= SXS_POLLHUP;
+
+    return events;
+}
+
+static sxs_error_t sxs_poll_epoll_ctl_error(void) {
+    sxs_errno_t errsv;
+
+    errsv = errno;
+    if (errsv == EBADF) {
+        return SXS_EBADF;
+    } else if (errsv == EEXIST) {
+        return SXS_EEXIST;
+    } else if (errsv == EINVAL) {
+        return SXS_EINVAL;
+    } else if (errsv == ENOENT) {
+        return SXS_ENOENT;
+    } else if (errsv == ENOMEM) {
+        return SXS_ENOMEM;
+    } else if (errsv == ENOSPC) {
+        return SXS_ENOSPC;
+    } else if (errsv == EPERM) {
+        return SXS_EPERM;
+    } else {
+        return SXS_UNKNOWN_ERROR;
+    }
+}
+
+static sxs_error_t sxs_poll_grow_slots(sxs_poller_t *p_poller, int sd) {
+    struct sxs_poll_slot *p_slots;
+    int num_slots;
+
+    if (sd < p_poller->num_slots) {
+        return SXS_SUCCESS;
+    }
+
+    num_slots = (p_poller->num_slots > 0) ? p_poller->num_slots : 64;
+    while (num_slots <= sd) {
+        num_slots = num_slots * 2;
+    }
+
+    p_slots = realloc(p_poller->p_slots,
+        (num_slots * sizeof(struct sxs_poll_slot)));
+    if (p_slots == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    memset((p_slots + p_poller->num_slots), 0,
+        ((num_slots - p_poller->num_slots) * sizeof(struct sxs_poll_slot)));
+    p_poller->p_slots = p_slots;
+    p_poller->num_slots = num_slots;
+
+    return SXS_SUCCESS;
+}
+#else
+static int sxs_poll_find(sxs_poller_t *p_poller, sxs_socket_t sd) {
+    int i;
+
+    for (i = 0; i < p_poller->num_pfds; i++) {
+        if (p_poller->p_pfds[i].fd == sd) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+#endif
+
+sxs_error_t sxs_poller_create(int max_events, sxs_poller_t **pp_poller) {
+    sxs_poller_t *p_poller;
+#ifdef SXS_POLL_EPOLL
+    sxs_errno_t errsv;
+#endif
+
+    if (max_events <= 0) {
+        return SXS_EINVAL;
+    }
+
+    p_poller = calloc(1, sizeof(sxs_poller_t));
+    if (p_poller == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    p_poller->max_events = max_events;
+    p_poller->p_events = malloc(max_events * sizeof(sxs_poll_event_t));
+    if (p_poller->p_events == NULL) {
+        free(p_poller);
+        return SXS_ENOMEM;
+    }
+
+#ifdef SXS_POLL_EPOLL
+    p_poller->p_epevents = malloc(max_events * sizeof(struct epoll_event));
+    if (p_poller->p_epevents == NULL) {
+        free(p_poller->p_events);
+        free(p_poller);
+        return SXS_ENOMEM;
+    }
+
+    p_poller->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (p_poller->epfd == -1) {
+        errsv = errno;
+        free(p_poller->p_epevents);
+        free(p_poller->p_events);
+        free(p_poller);
+        if (errsv == EMFILE) {
+            return SXS_EMFILE;
+        } else if (errsv == ENFILE) {
+            return SXS_ENFILE;
+        } else if (errsv == ENOMEM) {
+            return SXS_ENOMEM;
+        } else if (errsv == EINVAL) {
+            return SXS_EINVAL;
+        } else {
+            return SXS_UNKNOWN_ERROR;
+        }
+    }
+#endif
+
+    *pp_poller = p_poller;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_poller_destroy(sxs_poller_t *p_poller) {
+    sxs_error_t reterr;
+
+    reterr = SXS_SUCCESS;
+
+#ifdef SXS_POLL_EPOLL
+    if (close(p_poller->epfd) == -1) {
+        reterr = SXS_ERRCLOSEFAIL;
+    }
+    free(p_poller->p_epevents);
+    free(p_poller->p_slots);
+#else
+    free(p_poller->p_pfds);
+    free(p_poller->pp_data);
+    free(p_poller->p_reqevents);
+#endif
+    free(p_poller->p_events);
+    free(p_poller);
+
+    return reterr;
+}
+
+sxs_error_t sxs_poller_add(sxs_poller_t *p_poller, sxs_socket_t sd,
+    int events, void *p_data) {
+
+#ifdef SXS_POLL_EPOLL
+    struct epoll_event epevent;
+    sxs_error_t reterr;
+
+    if (sd < 0) {
+        return SXS_EBADF;
+    }
+
+    reterr = sxs_poll_grow_slots(p_poller, sd);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    if (p_poller->p_slots[sd].in_use) {
+        return SXS_EEXIST;
+    }
+
+    memset(&epevent, 0, sizeof(epevent));
+    epevent.events = sxs_poll_to_epoll(events);
+    epevent.data.fd = sd;
+    if (epoll_ctl(p_poller->epfd, EPOLL_CTL_ADD, sd, &epevent) == -1) {
+        return sxs_poll_epoll_ctl_error();
+    }
+
+    p_poller->p_slots[sd].p_data = p_data;
+    p_poller->p_slots[sd].in_use = 1;
+#else
+    sxs_pollfd_t *p_pfds;
+    void **pp_data;
+    int *p_reqevents;
+    int max_pfds;
+
+    if (sxs_poll_find(p_poller, sd) >= 0) {
+        return SXS_EEXIST;
+    }
+
+    if (p_poller->num_pfds == p_poller->max_pfds) {
+        max_pfds = (p_poller->max_pfds > 0) ? (p_poller->max_pfds * 2) : 64;
+
+        p_pfds = realloc(p_poller->p_pfds, (max_pfds * sizeof(sxs_pollfd_t)));
+        if (p_pfds == NULL) {
+            return SXS_ENOMEM;
+        }
+        p_poller->p_pfds = p_pfds;
+
+        pp_data = realloc(p_poller->pp_data, (max_pfds * sizeof(void *)));
+        if (pp_data == NULL) {
+            return SXS_ENOMEM;
+        }
+        p_poller->pp_data = pp_data;
+
+        p_reqevents = realloc(p_poller->p_reqevents,
+            (max_pfds * sizeof(int)));
+        if (p_reqevents == NULL) {
+            return SXS_ENOMEM;
+        }
+        p_poller->p_reqevents = p_reqevents;
+
+        p_poller->max_pfds = max_pfds;
+    }
+
+    p_poller->p_pfds[p_poller->num_pfds].fd = sd;
+    p_poller->p_pfds[p_poller->num_pfds].events = sxs_poll_to_sys(events);
+    p_poller->p_pfds[p_poller->num_pfds].revents = 0;
+    p_poller->pp_data[p_poller->num_pfds] = p_data;
+    p_poller->p_reqevents[p_poller->num_pfds] = events;
+    p_poller->num_pfds++;
+#endif
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_poller_modify(sxs_poller_t *p_poller, sxs_socket_t sd,
+    int events, void *p_data) {
+
+#ifdef SXS_POLL_EPOLL
+    struct epoll_event epevent;
+
+    if ((sd < 0) || (sd >= p_poller->num_slots) ||
+        (!p_poller->p_slots[sd].in_use)) {
+        return SXS_ENOENT;
+    }
+
+    memset(&epevent, 0, sizeof(epevent));
+    epevent.events = sxs_poll_to_epoll(events);
+    epevent.data.fd = sd;
+    if (epoll_ctl(p_poller->epfd, EPOLL_CTL_MOD, sd, &epevent) == -1) {
+        return sxs_poll_epoll_ctl_error();
+    }
+
+    p_poller->p_slots[sd].p_data = p_data;
+#else
+    int i;
+
+    i = sxs_poll_find(p_poller, sd);
+    if (i < 0) {
+        return SXS_ENOENT;
+    }
+
+    p_poller->p_pfds[i].events = sxs_poll_to_sys(events);
+    p_poller->pp_data[i] = p_data;
+    p_poller->p_reqevents[i] = events;
+#endif
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_poller_remove(sxs_poller_t *p_poller, sxs_socket_t sd) {
+#ifdef SXS_POLL_EPOLL
+    struct epoll_event epevent;
+    sxs_error_t reterr;
+
+    if ((sd < 0) || (sd >= p_poller->num_slots) ||
+        (!p_poller->p_slots[sd].in_use)) {
+        return SXS_ENOENT;
+    }
+
+    p_poller->p_slots[sd].in_use = 0;
+    p_poller->p_slots[sd].p_data = NULL;
+
+    /* Kernels before 2.6.9 require a non-NULL event even for removal. */
+    memset(&epevent, 0, sizeof(epevent));
+    if (epoll_ctl(p_poller->epfd, EPOLL_CTL_DEL, sd, &epevent) == -1) {
+        reterr = sxs_poll_epoll_ctl_error();
+        /* A descriptor that was already closed has been dropped from
+         * the epoll set by the kernel, so it is no longer monitored. */
+        if (reterr == SXS_EBADF) {
+            return SXS_SUCCESS;
+        }
+        return reterr;
+    }
+#else
+    int i;
+    int last;
+
+    i = sxs_poll_find(p_poller, sd);
+    if (i < 0) {
+        return SXS_ENOENT;
+    }
+
+    /* Keep the array dense by moving the last entry into the hole. */
+    last = p_poller->num_pfds - 1;
+    p_poller->p_pfds[i] = p_poller->p_pfds[last];
+    p_poller->pp_data[i] = p_poller->pp_data[last];
+    p_poller->p_reqevents[i] = p_poller->p_reqevents[last];
+    p_poller->num_pfds--;
+#endif
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_poller_wait(sxs_poller_t *p_poller,
+    const struct timeval *p_timeout, sxs_poll_event_t **pp_events,
+    int *p_num_ready) {
+
+    sxs_error_t reterr;
+    int timeout_ms;
+    int retval;
+    int num_ready;
+    int i;
+#ifdef SXS_POLL_EPOLL
+    int sd;
+#endif
+
+    reterr = sxs_poll_timeout_ms(p_timeout, &timeout_ms);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    num_ready = 0;
+
+#ifdef SXS_POLL_EPOLL
+    retval = epoll_wait(p_poller->epfd, p_poller->p_epevents,
+        p_poller->max_events, timeout_ms);
+    if (retval == -1) {
+        if (errno == EBADF) {
+            return SXS_EBADF;
+        }
+        return sxs_poll_sys_error();
+    }
+
+    for (i = 0; i < retval; i++) {
+        sd = p_poller->p_epevents[i].data.fd;
+        p_poller->p_events[num_ready].sd = sd;
+        p_poller->p_events[num_ready].events =
+            sxs_poll_from_epoll(p_poller->p_epevents[i].events);
+        if (sd < p_poller->num_slots) {
+            p_poller->p_events[num_ready].p_data =
+                p_poller->p_slots[sd].p_data;
+        } else {
+            p_poller->p_events[num_ready].p_data = NULL;
+        }
+        num_ready++;
+    }
+#else
+    retval = SXS_SYS_POLL(p_poller->p_pfds, p_poller->num_pfds, timeout_ms);
+    if (retval == SXS_SOCKET_ERROR) {
+        return sxs_poll_sys_error();
+    }
+
+    for (i = 0; (i < p_poller->num_pfds) && (num_ready < retval) &&
+        (num_ready < p_poller->max_events); i++) {
+
+        if (p_poller->p_pfds[i].revents == 0) {
+            continue;
+        }
+
+        p_poller->p_events[num_ready].sd = p_poller->p_pfds[i].fd;
+        p_poller->p_events[num_ready].events =
+            sxs_poll_from_sys(p_poller->p_pfds[i].revents);
+        if (p_poller->p_pfds[i].revents & POLLNVAL) {
+            p_poller->p_events[num_ready].events |= SXS_POLLERR;
+        }
+        p_poller->p_events[num_ready].p_data = p_poller->pp_data[i];
+        num_ready++;
+
+        /* Emulate one-shot notification by disarming the entry until it
+         * is re-armed with sxs_poller_modify(). */
+        if (p_poller->p_reqevents[i] & SXS_POLLONESHOT) {
+            p_poller->p_pfds[i].events = 0;
+        }
+        p_poller->p_pfds[i].revents = 0;
+    }
+#endif
+
+    *pp_events = p_poller->p_events;
+    *p_num_ready = num_ready;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_poll_one(sxs_socket_t sd, int events,
+    const struct timeval *p_timeout, int *p_revents) {
+
+    sxs_pollfd_t pfd;
+    sxs_error_t reterr;
+    int timeout_ms;
+    int retval;
+
+    reterr = sxs_poll_timeout_ms(p_timeout, &timeout_ms);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    pfd.fd = sd;
+    pfd.events = sxs_poll_to_sys(events);
+    pfd.revents = 0;
+
+    retval = SXS_SYS_POLL(&pfd, 1, timeout_ms);
+    if (retval == SXS_SOCKET_ERROR) {
+        return sxs_poll_sys_error();
+    }
+
+    if (pfd.revents & POLLNVAL) {
+        return SXS_EBADF;
+    }
+
+    if (retval == 0) {
+        *p_revents = 0;
+    } else {
+        *p_revents = sxs_poll_from_sys(pfd.revents);
+    }
+
+    return SXS_SUCCESS;
+}
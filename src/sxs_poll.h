@@ -0,0 +1,275 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_poll.h
+ * @brief This is a specifications file for the lib_sxs readiness API.
+ *
+ * The sxs_poll.h file is a specifications file that defines the
+ * functions which compose the readiness (poller) API of lib_sxs. A
+ * poller is a persistent set of socket descriptors which can be waited
+ * on for I/O readiness without rebuilding the set on every call.
+ */
+
+#ifndef SXS_POLL_H
+#define SXS_POLL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+
+/**
+ * @def SXS_POLLIN
+ * @brief A macro used to identify readability of a socket.
+ *
+ * The SXS_POLLIN event is reported when data (or a pending connection
+ * on a listening socket) is available to be received without blocking.
+ */
+
+/**
+ * @def SXS_POLLOUT
+ * @brief A macro used to identify writability of a socket.
+ *
+ * The SXS_POLLOUT event is reported when data can be sent on the socket
+ * without blocking, or when a non-blocking connect has completed.
+ */
+
+/**
+ * @def SXS_POLLERR
+ * @brief A macro used to identify an error condition on a socket.
+ *
+ * The SXS_POLLERR event is always reported and need not be requested.
+ */
+
+/**
+ * @def SXS_POLLHUP
+ * @brief A macro used to identify a hang up on a socket.
+ *
+ * The SXS_POLLHUP event is always reported and need not be requested.
+ */
+
+/**
+ * @def SXS_POLLET
+ * @brief A macro used to request edge-triggered notification.
+ *
+ * When SXS_POLLET is OR'd into the requested events the socket is only
+ * reported when its readiness changes rather than for as long as it
+ * remains ready. It is ignored by backends that only support level
+ * triggered notification.
+ */
+
+/**
+ * @def SXS_POLLONESHOT
+ * @brief A macro used to request one-shot notification.
+ *
+ * When SXS_POLLONESHOT is OR'd into the requested events the socket is
+ * disabled after it has been reported once and must be re-armed with
+ * sxs_poller_modify().
+ */
+
+#define SXS_POLLIN 0x0001
+#define SXS_POLLOUT 0x0004
+#define SXS_POLLERR 0x0008
+#define SXS_POLLHUP 0x0010
+#define SXS_POLLET 0x1000
+#define SXS_POLLONESHOT 0x2000
+
+/**
+ * @typedef sxs_poll_event_t
+ * @brief A ready socket as reported by a poller.
+ *
+ * The sxs_poll_event_t type is a structure describing a single ready
+ * socket. The 'sd' member contains the ready socket descriptor, the
+ * 'events' member contains the OR'd SXS_POLL* readiness events and the
+ * 'p_data' member contains the user data pointer given when the socket
+ * was added to the poller.
+ */
+typedef struct sxs_poll_event {
+    sxs_socket_t sd;
+    int events;
+    void *p_data;
+} sxs_poll_event_t;
+
+/**
+ * @typedef sxs_poller_t
+ * @brief An opaque persistent readiness set.
+ *
+ * The sxs_poller_t type represents a persistent set of monitored socket
+ * descriptors. On Linux it is backed by epoll, hence the cost of
+ * waiting does not depend on the number of monitored descriptors nor
+ * is it limited by FD_SETSIZE. On other systems it is backed by poll()
+ * (WSAPoll() on Windows).
+ */
+typedef struct sxs_poller sxs_poller_t;
+
+/**
+ * Create a poller.
+ *
+ * The sxs_poller_create() function creates a new, empty, poller and
+ * passes it back via the 'pp_poller' parameter. The 'max_events'
+ * parameter specifies the maximum number of ready sockets reported by a
+ * single call to sxs_poller_wait().
+ * @param max_events Maximum number of events returned per wait.
+ * @param pp_poller Pointer to poller pointer to store new poller in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the poller.
+ * @retval SXS_EINVAL The 'max_events' parameter is not positive.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ * @retval SXS_EMFILE The per-process open file descriptor limit was hit.
+ * @retval SXS_ENFILE The system limit of open file descriptors was hit.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_poller_create(int max_events,
+    sxs_poller_t **pp_poller);
+
+/**
+ * Destroy a poller.
+ *
+ * The sxs_poller_destroy() function releases all resources associated
+ * with the given poller. The sockets which were added to the poller are
+ * not closed.
+ * @param p_poller Pointer to the poller to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the poller.
+ * @retval SXS_ERRCLOSEFAIL Failed to close the underlying descriptor.
+ */
+SXS_EXPORT sxs_error_t sxs_poller_destroy(sxs_poller_t *p_poller);
+
+/**
+ * Add a socket to a poller.
+ *
+ * The sxs_poller_add() function starts monitoring the socket 'sd' for
+ * the OR'd SXS_POLL* 'events'. The 'p_data' pointer is handed back in
+ * each sxs_poll_event_t reported for the socket.
+ * @param p_poller Pointer to the poller to add the socket to.
+ * @param sd The socket descriptor to monitor.
+ * @param events OR'd SXS_POLL* events to monitor the socket for.
+ * @param p_data User data pointer to associate with the socket.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully added the socket.
+ * @retval SXS_EEXIST The socket is already part of the poller.
+ * @retval SXS_EBADF The socket descriptor is invalid.
+ * @retval SXS_EINVAL The socket descriptor is invalid.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ * @retval SXS_ENOSPC The user limit on monitored descriptors was hit.
+ * @retval SXS_EPERM The descriptor does not support readiness polling.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_poller_add(sxs_poller_t *p_poller,
+    sxs_socket_t sd, int events, void *p_data);
+
+/**
+ * Change the monitored events of a socket in a poller.
+ *
+ * The sxs_poller_modify() function replaces the monitored events and the
+ * user data pointer of a socket which was previously added to the
+ * poller. It is also used to re-arm sockets added with SXS_POLLONESHOT.
+ * @param p_poller Pointer to the poller containing the socket.
+ * @param sd The socket descriptor to modify.
+ * @param events OR'd SXS_POLL* events to monitor the socket for.
+ * @param p_data User data pointer to associate with the socket.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully modified the socket.
+ * @retval SXS_ENOENT The socket is not part of the poller.
+ * @retval SXS_EBADF The socket descriptor is invalid.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_poller_modify(sxs_poller_t *p_poller,
+    sxs_socket_t sd, int events, void *p_data);
+
+/**
+ * Remove a socket from a poller.
+ *
+ * The sxs_poller_remove() function stops monitoring the socket 'sd'. A
+ * socket must be removed before it is closed if the socket descriptor
+ * may be reused while the poller is still in use.
+ * @param p_poller Pointer to the poller containing the socket.
+ * @param sd The socket descriptor to remove.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully removed the socket.
+ * @retval SXS_ENOENT The socket is not part of the poller.
+ * @retval SXS_EBADF The socket descriptor is invalid.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_poller_remove(sxs_poller_t *p_poller,
+    sxs_socket_t sd);
+
+/**
+ * Wait for sockets in a poller to become ready.
+ *
+ * The sxs_poller_wait() function waits until one or more of the sockets
+ * in the poller becomes ready or the timeout expires. On return
+ * 'pp_events' points at a dense array, owned by the poller, of
+ * 'p_num_ready' ready sockets. The array remains valid until the next
+ * call to sxs_poller_wait() or sxs_poller_destroy(). If 'p_timeout' is
+ * NULL it will block indefinitely. If 'p_timeout' points to a timeval
+ * structure containing all 0's it will return immediately.
+ * @param p_poller Pointer to the poller to wait on.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to wait for a socket to become ready.
+ * @param pp_events Pointer to an event array pointer to store the ready
+ * sockets array in.
+ * @param p_num_ready Pointer to var to store the num of ready sockets.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully waited, 'p_num_ready' may be 0 if the
+ * timeout was reached.
+ * @retval SXS_EINTR A signal was caught.
+ * @retval SXS_EBADF The poller is invalid.
+ * @retval SXS_EINVAL The poller or the timeout is invalid.
+ * @retval SXS_EFAULT The event array is not accessible.
+ * @retval SXS_ENOMEM Unable to allocate memory for internal tables.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_poller_wait(sxs_poller_t *p_poller,
+    const struct timeval *p_timeout, sxs_poll_event_t **pp_events,
+    int *p_num_ready);
+
+/**
+ * Wait for a single socket to become ready.
+ *
+ * The sxs_poll_one() function waits until the socket 'sd' becomes ready
+ * for one of the OR'd SXS_POLL* 'events' or the timeout expires, and
+ * passes back the ready events via 'p_revents' (0 if the timeout was
+ * reached). Unlike sxs_select() it is not limited by FD_SETSIZE and its
+ * cost does not depend on the socket descriptor's value. This is what
+ * the *_nb functions use to wait for readiness. If 'p_timeout' is NULL
+ * it will block indefinitely.
+ * @param sd The socket descriptor to wait on.
+ * @param events OR'd SXS_POLL* events to wait for.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to wait for the socket to become ready.
+ * @param p_revents Pointer to var to store the ready events in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully waited on the socket.
+ * @retval SXS_EBADF The socket descriptor is invalid.
+ * @retval SXS_EINTR A signal was caught.
+ * @retval SXS_EINVAL The timeout is invalid.
+ * @retval SXS_EFAULT An internal parameter was not a valid pointer.
+ * @retval SXS_ENOMEM Unable to allocate memory for internal tables.
+ * @retval SXS_WSANOTINITIALIZED The library was not initialized.
+ * @retval SXS_ENETDOWN The network subsystem has failed.
+ * @retval SXS_ENOBUFS No buffer space is available.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_poll_one(sxs_socket_t sd, int events,
+    const struct timeval *p_timeout, int *p_revents);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_POLL_H */
@@ -0,0 +1,411 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_rbuf.c
+ * @brief This is an implementation file for the lib_sxs read buffer API.
+ *
+ * The sxs_rbuf.c file is an implementation file which contains all the
+ * definitions for the functions which compose the read buffer API of
+ * lib_sxs.
+ */
+
+#include "sxs_rbuf.h"
+#include "sxs_ring.h"
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+/* A read buffer either owns a flat buffer, whose data is moved to its
+ * front to make room, or a mirrored ring, whose free space always
+ * follows its data. Only the helpers below tell them apart. */
+struct sxs_rbuf {
+    sxs_socket_t sd;
+    sxs_ring_t *p_ring;
+    sxs_mem_t mem;
+    char *p_data;
+    sxs_size_t size;
+    sxs_size_t start;   /* offset of the first unconsumed byte */
+    sxs_size_t end;     /* offset just past the last received byte */
+    const void *p_scan_delim;   /* delimiter of an unfinished search */
+    sxs_size_t scan_delim_len;
+    sxs_size_t scanned; /* bytes known not to start the delimiter */
+};
+
+/* Get the buffered data. */
+static char *sxs_rbuf_head(const sxs_rbuf_t *p_rbuf,
+    sxs_size_t *p_buffered) {
+
+    void *p_head;
+
+    if (p_rbuf->p_ring != NULL) {
+        sxs_ring_data(p_rbuf->p_ring, &p_head, p_buffered);
+        return (char *)p_head;
+    }
+
+    (*p_buffered) = p_rbuf->end - p_rbuf->start;
+
+    return (p_rbuf->p_data + p_rbuf->start);
+}
+
+/* Discard buffered data which is known to be there. */
+static void sxs_rbuf_advance(sxs_rbuf_t *p_rbuf, sxs_size_t len) {
+    p_rbuf->scanned = 0;
+
+    if (p_rbuf->p_ring != NULL) {
+        sxs_ring_consume(p_rbuf->p_ring, len);
+        return;
+    }
+
+    p_rbuf->start = p_rbuf->start + len;
+    if (p_rbuf->start == p_rbuf->end) {
+        p_rbuf->start = 0;
+        p_rbuf->end = 0;
+    }
+}
+
+/* Move the buffered data of a flat buffer to its front. */
+static void sxs_rbuf_compact(sxs_rbuf_t *p_rbuf) {
+    if ((p_rbuf->p_ring == NULL) && (p_rbuf->start > 0)) {
+        memmove(p_rbuf->p_data, (p_rbuf->p_data + p_rbuf->start),
+            (p_rbuf->end - p_rbuf->start));
+        p_rbuf->end = p_rbuf->end - p_rbuf->start;
+        p_rbuf->start = 0;
+    }
+}
+
+/* Receive once into the free space of the buffer. When 'wait' is zero
+ * the socket is received from as sxs_recv() does, otherwise as
+ * sxs_recv_dontwait() does with 'p_timeout'. */
+static sxs_error_t sxs_rbuf_fill_wait(sxs_rbuf_t *p_rbuf, int wait,
+    const struct timeval *p_timeout) {
+
+    sxs_error_t reterr;
+    sxs_ssize_t recvd;
+    sxs_size_t room;
+    void *p_space;
+
+    if (p_rbuf->p_ring != NULL) {
+        sxs_ring_space(p_rbuf->p_ring, &p_space, &room);
+    } else {
+        if (p_rbuf->end == p_rbuf->size) {
+            sxs_rbuf_compact(p_rbuf);
+        }
+        p_space = p_rbuf->p_data + p_rbuf->end;
+        room = p_rbuf->size - p_rbuf->end;
+    }
+    if (room == 0) {
+        return SXS_ENOBUFS;
+    }
+
+    if (wait) {
+        reterr = sxs_recv_dontwait(p_rbuf->sd, (sxs_buf_t)p_space, room,
+            0, p_timeout, &recvd);
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        }
+    } else {
+        reterr = sxs_recv(p_rbuf->sd, (sxs_buf_t)p_space, room, 0,
+            &recvd);
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        } else if (recvd == 0) {   /* peer cleanly disconnected */
+            return SXS_ERRCONNCLOSED;
+        }
+    }
+
+    if (p_rbuf->p_ring != NULL) {
+        sxs_ring_commit(p_rbuf->p_ring, recvd);
+    } else {
+        p_rbuf->end = p_rbuf->end + recvd;
+    }
+
+    return SXS_SUCCESS;
+}
+
+/* Receive until at least 'len' contiguous bytes are buffered. */
+static sxs_error_t sxs_rbuf_ensure(sxs_rbuf_t *p_rbuf, sxs_size_t len,
+    int wait, const struct timeval *p_timeout) {
+
+    sxs_error_t reterr;
+    sxs_size_t buffered;
+
+    if (len > p_rbuf->size) {
+        return SXS_ENOBUFS;
+    }
+
+    sxs_rbuf_head(p_rbuf, &buffered);
+    while (buffered < len) {
+        if ((p_rbuf->start + len) > p_rbuf->size) {
+            sxs_rbuf_compact(p_rbuf);
+        }
+
+        reterr = sxs_rbuf_fill_wait(p_rbuf, wait, p_timeout);
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        }
+        sxs_rbuf_head(p_rbuf, &buffered);
+    }
+
+    return SXS_SUCCESS;
+}
+
+static sxs_error_t sxs_rbuf_read_wait(sxs_rbuf_t *p_rbuf, sxs_buf_t buf,
+    sxs_size_t len, int wait, const struct timeval *p_timeout) {
+
+    sxs_error_t reterr;
+    sxs_size_t buffered;
+    char *p_head;
+
+    /* Data which does not fit in the buffer is received straight into
+     * the caller's buffer, as going through ours would only add a copy. */
+    if (len > p_rbuf->size) {
+        p_head = sxs_rbuf_head(p_rbuf, &buffered);
+        memcpy(buf, p_head, buffered);
+        sxs_rbuf_advance(p_rbuf, buffered);
+
+        if (wait) {
+            return sxs_recv_nbytes_dontwait(p_rbuf->sd,
+                ((char *)buf + buffered), (len - buffered), p_timeout);
+        }
+        return sxs_recv_nbytes(p_rbuf->sd, ((char *)buf + buffered),
+            (len - buffered));
+    }
+
+    reterr = sxs_rbuf_ensure(p_rbuf, len, wait, p_timeout);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    p_head = sxs_rbuf_head(p_rbuf, &buffered);
+    memcpy(buf, p_head, len);
+    sxs_rbuf_advance(p_rbuf, len);
+
+    return SXS_SUCCESS;
+}
+
+static sxs_error_t sxs_rbuf_read_until_wait(sxs_rbuf_t *p_rbuf,
+    const void *p_delim, sxs_size_t delim_len, int wait,
+    const struct timeval *p_timeout, const void **pp_data,
+    sxs_size_t *p_len) {
+
+    sxs_error_t reterr;
+    sxs_size_t buffered;
+    const char *p_found;
+    char *p_head;
+
+    if (delim_len == 0) {
+        return SXS_EINVAL;
+    }
+
+    /* Only the data received since the last search needs searching,
+     * along with the tail a delimiter straddling it could start in. The
+     * progress is kept in the read buffer, so a search resumed after a
+     * timeout does not scan the same bytes again either. */
+    if ((p_delim != p_rbuf->p_scan_delim) ||
+        (delim_len != p_rbuf->scan_delim_len)) {
+        p_rbuf->p_scan_delim = p_delim;
+        p_rbuf->scan_delim_len = delim_len;
+        p_rbuf->scanned = 0;
+    }
+
+    while (1) {
+        p_head = sxs_rbuf_head(p_rbuf, &buffered);
+
+        p_found = sxs_scan_delim((p_head + p_rbuf->scanned),
+            (buffered - p_rbuf->scanned), (const char *)p_delim,
+            delim_len);
+        if (p_found != NULL) {
+            (*pp_data) = p_head;
+            (*p_len) = (p_found + delim_len) - p_head;
+            sxs_rbuf_advance(p_rbuf, (*p_len));
+            return SXS_SUCCESS;
+        }
+
+        if (buffered >= delim_len) {
+            p_rbuf->scanned = buffered - (delim_len - 1);
+        }
+
+        reterr = sxs_rbuf_fill_wait(p_rbuf, wait, p_timeout);
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        }
+    }
+}
+
+sxs_error_t sxs_rbuf_create(sxs_socket_t sd, sxs_size_t size,
+    sxs_rbuf_t **pp_rbuf) {
+
+    sxs_rbuf_t *p_rbuf;
+
+    if (size == 0) {
+        size = SXS_RBUF_DEFAULT_SIZE;
+    }
+
+    p_rbuf = (sxs_rbuf_t *)malloc(sizeof(sxs_rbuf_t));
+    if (p_rbuf == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    if (sxs_mem_alloc(size, &p_rbuf->mem) != SXS_SUCCESS) {
+        free(p_rbuf);
+        return SXS_ENOMEM;
+    }
+
+    p_rbuf->sd = sd;
+    p_rbuf->p_data = p_rbuf->mem.p_data;
+    p_rbuf->p_ring = NULL;
+    p_rbuf->size = size;
+    p_rbuf->start = 0;
+    p_rbuf->end = 0;
+    p_rbuf->p_scan_delim = NULL;
+    p_rbuf->scan_delim_len = 0;
+    p_rbuf->scanned = 0;
+
+    (*pp_rbuf) = p_rbuf;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_rbuf_create_ring(sxs_socket_t sd, sxs_size_t size,
+    sxs_rbuf_t **pp_rbuf) {
+
+    sxs_rbuf_t *p_rbuf;
+    sxs_error_t reterr;
+
+    if (size == 0) {
+        size = SXS_RBUF_DEFAULT_SIZE;
+    }
+
+    p_rbuf = (sxs_rbuf_t *)malloc(sizeof(sxs_rbuf_t));
+    if (p_rbuf == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    reterr = sxs_ring_create(size, &p_rbuf->p_ring);
+    if (reterr != SXS_SUCCESS) {
+        free(p_rbuf);
+        return reterr;
+    }
+
+    p_rbuf->sd = sd;
+    p_rbuf->mem.p_data = NULL;
+    p_rbuf->p_data = NULL;
+    p_rbuf->size = sxs_ring_size(p_rbuf->p_ring);
+    p_rbuf->start = 0;
+    p_rbuf->end = 0;
+    p_rbuf->p_scan_delim = NULL;
+    p_rbuf->scan_delim_len = 0;
+    p_rbuf->scanned = 0;
+
+    (*pp_rbuf) = p_rbuf;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_rbuf_destroy(sxs_rbuf_t *p_rbuf) {
+    if (p_rbuf->p_ring != NULL) {
+        sxs_ring_destroy(p_rbuf->p_ring);
+    }
+    sxs_mem_free(&p_rbuf->mem);
+    free(p_rbuf);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_rbuf_fill(sxs_rbuf_t *p_rbuf) {
+    return sxs_rbuf_fill_wait(p_rbuf, 0, NULL);
+}
+
+sxs_error_t sxs_rbuf_fill_nb(sxs_rbuf_t *p_rbuf,
+    const struct timeval *p_timeout) {
+    return sxs_rbuf_fill_wait(p_rbuf, 1, p_timeout);
+}
+
+sxs_size_t sxs_rbuf_size(const sxs_rbuf_t *p_rbuf) {
+    return p_rbuf->size;
+}
+
+void sxs_rbuf_data(const sxs_rbuf_t *p_rbuf, const void **pp_data,
+    sxs_size_t *p_len) {
+    (*pp_data) = sxs_rbuf_head(p_rbuf, p_len);
+}
+
+sxs_error_t sxs_rbuf_consume(sxs_rbuf_t *p_rbuf, sxs_size_t len) {
+    sxs_size_t buffered;
+
+    sxs_rbuf_head(p_rbuf, &buffered);
+    if (len > buffered) {
+        return SXS_EINVAL;
+    }
+
+    sxs_rbuf_advance(p_rbuf, len);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_rbuf_peek(sxs_rbuf_t *p_rbuf, sxs_size_t len,
+    const void **pp_data) {
+
+    sxs_error_t reterr;
+    sxs_size_t buffered;
+
+    reterr = sxs_rbuf_ensure(p_rbuf, len, 0, NULL);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    (*pp_data) = sxs_rbuf_head(p_rbuf, &buffered);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_rbuf_peek_nb(sxs_rbuf_t *p_rbuf, sxs_size_t len,
+    const struct timeval *p_timeout, const void **pp_data) {
+
+    sxs_error_t reterr;
+    sxs_size_t buffered;
+
+    reterr = sxs_rbuf_ensure(p_rbuf, len, 1, p_timeout);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    (*pp_data) = sxs_rbuf_head(p_rbuf, &buffered);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_rbuf_read(sxs_rbuf_t *p_rbuf, sxs_buf_t buf,
+    sxs_size_t len) {
+    return sxs_rbuf_read_wait(p_rbuf, buf, len, 0, NULL);
+}
+
+sxs_error_t sxs_rbuf_read_nb(sxs_rbuf_t *p_rbuf, sxs_buf_t buf,
+    sxs_size_t len, const struct timeval *p_timeout) {
+    return sxs_rbuf_read_wait(p_rbuf, buf, len, 1, p_timeout);
+}
+
+sxs_error_t sxs_rbuf_read_until(sxs_rbuf_t *p_rbuf, const void *p_delim,
+    sxs_size_t delim_len, const void **pp_data, sxs_size_t *p_len) {
+    return sxs_rbuf_read_until_wait(p_rbuf, p_delim, delim_len, 0, NULL,
+        pp_data, p_len);
+}
+
+sxs_error_t sxs_rbuf_read_until_nb(sxs_rbuf_t *p_rbuf,
+    const void *p_delim, sxs_size_t delim_len,
+    const struct timeval *p_timeout, const void **pp_data,
+    sxs_size_t *p_len) {
+    return sxs_rbuf_read_until_wait(p_rbuf, p_delim, delim_len, 1,
+        p_timeout, pp_data, p_len);
+}
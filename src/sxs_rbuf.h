@@ -0,0 +1,317 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_rbuf.h
+ * @brief This is a specifications file for the lib_sxs read buffer API.
+ *
+ * The sxs_rbuf.h file is a specifications file that defines the
+ * functions which compose the read buffer API of lib_sxs. A read buffer
+ * receives from a socket with as few large receives as possible and
+ * serves the small reads of a protocol parser, such as a length prefix
+ * followed by a message body, from memory. Parsing a stream of small
+ * messages therefore costs roughly one system call per buffer full
+ * rather than one or more per message.
+ *
+ * Every function which may have to receive comes in a blocking flavor,
+ * which behaves like sxs_recv_nbytes(), and a flavor suffixed with _nb,
+ * which bounds each wait for data by a timeout like sxs_recv_nbytes_nb()
+ * but leaves the I/O mode of the socket alone, as sxs_recv_dontwait()
+ * does. Data received before a timeout stays in the buffer, so the call
+ * may simply be repeated.
+ *
+ * Once a socket is read through a read buffer it must only be read
+ * through it, since the buffer may hold data the socket has already
+ * delivered.
+ */
+
+#ifndef SXS_RBUF_H
+#define SXS_RBUF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+
+/**
+ * @def SXS_RBUF_DEFAULT_SIZE
+ * @brief The size of a read buffer created with a size of 0.
+ */
+#define SXS_RBUF_DEFAULT_SIZE 65536
+
+/**
+ * @typedef sxs_rbuf_t
+ * @brief An opaque read buffer of a socket.
+ *
+ * The sxs_rbuf_t type represents a buffer of data received from a
+ * socket but not yet consumed by the application.
+ */
+typedef struct sxs_rbuf sxs_rbuf_t;
+
+/**
+ * Create a read buffer.
+ *
+ * The sxs_rbuf_create() function creates a read buffer of 'size' bytes
+ * for the connected stream socket 'sd' and passes it back via
+ * 'pp_rbuf'. If 'size' is 0, SXS_RBUF_DEFAULT_SIZE is used. The size
+ * bounds how much may be peeked at once and how long a delimited
+ * record may be. The read buffer does not take ownership of the socket.
+ * @param sd The socket descriptor of the socket to read from.
+ * @param size The size of the buffer in bytes, or 0 for the default.
+ * @param pp_rbuf Pointer to read buffer pointer to store the new read
+ * buffer in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the read buffer.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_create(sxs_socket_t sd, sxs_size_t size,
+    sxs_rbuf_t **pp_rbuf);
+
+/**
+ * Create a read buffer backed by a mirrored ring.
+ *
+ * The sxs_rbuf_create_ring() function behaves like sxs_rbuf_create()
+ * except that the buffer is a mirrored ring created with
+ * sxs_ring_create(), so its size is rounded up as described there.
+ * Buffered data never has to be moved to the front of the buffer to
+ * make room, and the free space is received into in one piece wherever
+ * the data wraps, which suits streams of frames of varying size.
+ * @param sd The socket descriptor of the socket to read from.
+ * @param size The minimum size of the buffer in bytes, or 0 for the
+ * default.
+ * @param pp_rbuf Pointer to read buffer pointer to store the new read
+ * buffer in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_ring_create().
+ * @retval SXS_SUCCESS Successfully created the read buffer.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_create_ring(sxs_socket_t sd,
+    sxs_size_t size, sxs_rbuf_t **pp_rbuf);
+
+/**
+ * Destroy a read buffer.
+ *
+ * The sxs_rbuf_destroy() function releases all resources associated
+ * with the read buffer. Buffered data is discarded. The socket is not
+ * closed.
+ * @param p_rbuf Pointer to the read buffer to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the read buffer.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_destroy(sxs_rbuf_t *p_rbuf);
+
+/**
+ * Receive more data into a read buffer.
+ *
+ * The sxs_rbuf_fill() function receives once from the socket into the
+ * free space of the read buffer, blocking until some data arrives.
+ * Applications normally leave this to the read functions, but may call
+ * it after the socket has been reported readable to buffer what has
+ * arrived.
+ * @param p_rbuf Pointer to the read buffer to fill.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recv().
+ * @retval SXS_SUCCESS Successfully received data into the buffer.
+ * @retval SXS_ENOBUFS The buffer is full.
+ * @retval SXS_ERRCONNCLOSED Peer closed the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_fill(sxs_rbuf_t *p_rbuf);
+
+/**
+ * Receive more data into a read buffer with a timeout.
+ *
+ * The sxs_rbuf_fill_nb() function behaves like sxs_rbuf_fill() except
+ * that it waits at most 'p_timeout' for data to arrive. A zero timeout
+ * buffers what has already arrived without waiting.
+ * @param p_rbuf Pointer to the read buffer to fill.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for waiting for data to be available on the socket.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recv_dontwait().
+ * @retval SXS_SUCCESS Successfully received data into the buffer.
+ * @retval SXS_ENOBUFS The buffer is full.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_fill_nb(sxs_rbuf_t *p_rbuf,
+    const struct timeval *p_timeout);
+
+/**
+ * Get the size of a read buffer.
+ *
+ * The sxs_rbuf_size() function returns the number of bytes the read
+ * buffer can hold, which bounds how much may be peeked at once.
+ * @param p_rbuf Pointer to the read buffer.
+ * @return The size of the buffer in bytes.
+ */
+SXS_EXPORT sxs_size_t sxs_rbuf_size(const sxs_rbuf_t *p_rbuf);
+
+/**
+ * Get the data held by a read buffer.
+ *
+ * The sxs_rbuf_data() function passes back a pointer to the buffered
+ * data via 'pp_data' and its length via 'p_len' without receiving. The
+ * pointer stays valid until the next call which may receive.
+ * @param p_rbuf Pointer to the read buffer.
+ * @param pp_data Pointer to var to store the pointer to the data in.
+ * @param p_len Pointer to var to store the number of buffered bytes in.
+ */
+SXS_EXPORT void sxs_rbuf_data(const sxs_rbuf_t *p_rbuf,
+    const void **pp_data, sxs_size_t *p_len);
+
+/**
+ * Discard data from the front of a read buffer.
+ *
+ * The sxs_rbuf_consume() function discards the first 'len' bytes of
+ * the buffered data, typically after they were examined in place via
+ * sxs_rbuf_peek() or sxs_rbuf_data().
+ * @param p_rbuf Pointer to the read buffer.
+ * @param len The number of bytes to discard.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully discarded the data.
+ * @retval SXS_EINVAL Fewer than 'len' bytes are buffered.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_consume(sxs_rbuf_t *p_rbuf,
+    sxs_size_t len);
+
+/**
+ * Look at the next bytes of a read buffer.
+ *
+ * The sxs_rbuf_peek() function receives until at least 'len' bytes are
+ * buffered and passes back a pointer to them via 'pp_data' without
+ * consuming them. The pointer stays valid until the next call which may
+ * receive.
+ * @param p_rbuf Pointer to the read buffer.
+ * @param len The number of bytes to look at.
+ * @param pp_data Pointer to var to store the pointer to the data in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_rbuf_fill().
+ * @retval SXS_SUCCESS Successfully buffered the data.
+ * @retval SXS_ENOBUFS 'len' is larger than the buffer.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_peek(sxs_rbuf_t *p_rbuf, sxs_size_t len,
+    const void **pp_data);
+
+/**
+ * Look at the next bytes of a read buffer with a timeout.
+ *
+ * The sxs_rbuf_peek_nb() function behaves like sxs_rbuf_peek() except
+ * that each wait for data is bounded by 'p_timeout'.
+ * @param p_rbuf Pointer to the read buffer.
+ * @param len The number of bytes to look at.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for data to be available on the socket.
+ * @param pp_data Pointer to var to store the pointer to the data in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_rbuf_fill_nb().
+ * @retval SXS_SUCCESS Successfully buffered the data.
+ * @retval SXS_ENOBUFS 'len' is larger than the buffer.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_peek_nb(sxs_rbuf_t *p_rbuf,
+    sxs_size_t len, const struct timeval *p_timeout,
+    const void **pp_data);
+
+/**
+ * Read a specified number of bytes through a read buffer.
+ *
+ * The sxs_rbuf_read() function copies exactly 'len' bytes to 'buf',
+ * taking them from the buffered data first and receiving the rest.
+ * When more is still missing than the buffer holds, the remainder is
+ * received straight into 'buf' rather than through the buffer.
+ * @param p_rbuf Pointer to the read buffer.
+ * @param buf The pointer to the buffer to store the data in.
+ * @param len The number of bytes to read.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recv_nbytes().
+ * @retval SXS_SUCCESS Successfully read all the data.
+ * @retval SXS_ERRCONNCLOSED Peer closed connection before finished.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_read(sxs_rbuf_t *p_rbuf, sxs_buf_t buf,
+    sxs_size_t len);
+
+/**
+ * Read a specified number of bytes through a read buffer with a timeout.
+ *
+ * The sxs_rbuf_read_nb() function behaves like sxs_rbuf_read() except
+ * that each wait for data is bounded by 'p_timeout'. On a timeout the
+ * data received so far is kept by the read buffer, unless it was being
+ * received straight into 'buf', in which case the stream can not be
+ * resumed.
+ * @param p_rbuf Pointer to the read buffer.
+ * @param buf The pointer to the buffer to store the data in.
+ * @param len The number of bytes to read.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for data to be available on the socket.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recv_nbytes_dontwait().
+ * @retval SXS_SUCCESS Successfully read all the data.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_read_nb(sxs_rbuf_t *p_rbuf, sxs_buf_t buf,
+    sxs_size_t len, const struct timeval *p_timeout);
+
+/**
+ * Read up to and including a delimiter through a read buffer.
+ *
+ * The sxs_rbuf_read_until() function receives until the 'delim_len'
+ * byte delimiter 'p_delim' is buffered, consumes everything up to and
+ * including its first occurrence, and passes back a pointer to the
+ * consumed data via 'pp_data' and its length, delimiter included, via
+ * 'p_len'. The pointer stays valid until the next call which may
+ * receive. The buffered data is searched with vector instructions
+ * where the processor has them, and each byte is searched only once:
+ * when a search is repeated after an error such as a timeout, with the
+ * same 'p_delim' pointer and length, it resumes where it stopped.
+ * @param p_rbuf Pointer to the read buffer.
+ * @param p_delim Pointer to the delimiter to look for.
+ * @param delim_len The length of the delimiter in bytes.
+ * @param pp_data Pointer to var to store the pointer to the data in.
+ * @param p_len Pointer to var to store the length of the data in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_rbuf_fill().
+ * @retval SXS_SUCCESS Successfully read up to the delimiter.
+ * @retval SXS_EINVAL 'delim_len' is 0.
+ * @retval SXS_ENOBUFS The buffer filled up without the delimiter.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_read_until(sxs_rbuf_t *p_rbuf,
+    const void *p_delim, sxs_size_t delim_len, const void **pp_data,
+    sxs_size_t *p_len);
+
+/**
+ * Read up to and including a delimiter with a timeout.
+ *
+ * The sxs_rbuf_read_until_nb() function behaves like
+ * sxs_rbuf_read_until() except that each wait for data is bounded by
+ * 'p_timeout'.
+ * @param p_rbuf Pointer to the read buffer.
+ * @param p_delim Pointer to the delimiter to look for.
+ * @param delim_len The length of the delimiter in bytes.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for data to be available on the socket.
+ * @param pp_data Pointer to var to store the pointer to the data in.
+ * @param p_len Pointer to var to store the length of the data in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_rbuf_fill_nb().
+ * @retval SXS_SUCCESS Successfully read up to the delimiter.
+ * @retval SXS_EINVAL 'delim_len' is 0.
+ * @retval SXS_ENOBUFS The buffer filled up without the delimiter.
+ */
+SXS_EXPORT sxs_error_t sxs_rbuf_read_until_nb(sxs_rbuf_t *p_rbuf,
+    const void *p_delim, sxs_size_t delim_len,
+    const struct timeval *p_timeout, const void **pp_data,
+    sxs_size_t *p_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_RBUF_H */
@@ -0,0 +1,434 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_relay.c
+ * @brief This is an implementation file for the lib_sxs relay API.
+ *
+ * The sxs_relay.c file is an implementation file which contains all the
+ * definitions for the functions which compose the relay API of lib_sxs.
+ */
+
+/* splice() and pipe2() are only declared by glibc for GNU sources. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include "sxs_relay.h"
+#include "sxs_poll.h"
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+#if defined(__linux__) && defined(SPLICE_F_NONBLOCK)
+    #define SXS_RELAY_SPLICE 1
+#endif
+
+/* The size asked for the pipe of each direction, which bounds how much
+ * data a relay holds for a stalled side. The kernel's default pipe
+ * size is used if the request is refused. */
+#define SXS_RELAY_PIPE_SIZE 262144
+
+/* The size of the buffer of each direction without splice(). */
+#define SXS_RELAY_BUF_SIZE 65536
+
+struct sxs_relay_dir {
+    sxs_socket_t from;
+    sxs_socket_t to;
+#ifdef SXS_RELAY_SPLICE
+    int pipe_fds[2];
+    int full;           /* the pipe refused data, see sxs_relay_dir_pump */
+#else
+    char *p_buf;
+    sxs_size_t off;     /* offset of the data not yet sent in the buffer */
+#endif
+    sxs_size_t pending; /* bytes received but not yet sent */
+    sxs_size_t capacity;
+    int eof;            /* 'from' finished sending */
+    int shut;           /* sending direction of 'to' shut down */
+    sxs_uint64_t bytes;
+};
+
+struct sxs_relay {
+    struct sxs_relay_dir dirs[2];   /* A to B, then B to A */
+};
+
+/* Set up a direction of a relay, which owns no resources on failure. */
+static sxs_error_t sxs_relay_dir_init(struct sxs_relay_dir *p_dir,
+    sxs_socket_t from, sxs_socket_t to) {
+
+#ifdef SXS_RELAY_SPLICE
+    int size;
+#endif
+
+    p_dir->from = from;
+    p_dir->to = to;
+    p_dir->pending = 0;
+    p_dir->eof = 0;
+    p_dir->shut = 0;
+    p_dir->bytes = 0;
+
+#ifdef SXS_RELAY_SPLICE
+    p_dir->full = 0;
+    if (pipe2(p_dir->pipe_fds, (O_NONBLOCK | O_CLOEXEC)) == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    #ifdef F_SETPIPE_SZ
+    fcntl(p_dir->pipe_fds[1], F_SETPIPE_SZ, SXS_RELAY_PIPE_SIZE);
+    size = fcntl(p_dir->pipe_fds[1], F_GETPIPE_SZ);
+    #else
+    size = -1;
+    #endif
+    p_dir->capacity = (size > 0) ? (sxs_size_t)size : 65536;
+#else
+    p_dir->p_buf = (char *)malloc(SXS_RELAY_BUF_SIZE);
+    if (p_dir->p_buf == NULL) {
+        return SXS_ENOMEM;
+    }
+    p_dir->off = 0;
+    p_dir->capacity = SXS_RELAY_BUF_SIZE;
+#endif
+
+    return SXS_SUCCESS;
+}
+
+static void sxs_relay_dir_uninit(struct sxs_relay_dir *p_dir) {
+#ifdef SXS_RELAY_SPLICE
+    close(p_dir->pipe_fds[0]);
+    close(p_dir->pipe_fds[1]);
+#else
+    free(p_dir->p_buf);
+#endif
+}
+
+/* Whether a direction has room to receive more data. A pipe can fill up
+ * before 'capacity' bytes are in it, as it holds a page per segment
+ * spliced in whatever its size. The buffer used without splice() is
+ * only refilled once it has been emptied. */
+static int sxs_relay_dir_room(const struct sxs_relay_dir *p_dir) {
+#ifdef SXS_RELAY_SPLICE
+    return !p_dir->full && (p_dir->pending < p_dir->capacity);
+#else
+    return (p_dir->pending == 0);
+#endif
+}
+
+/* Move data from the sending socket of a direction into its pipe or
+ * buffer, passing back the number of bytes moved, 0 at the end of the
+ * stream. */
+static sxs_error_t sxs_relay_dir_fill(struct sxs_relay_dir *p_dir,
+    sxs_ssize_t *p_moved) {
+
+#ifdef SXS_RELAY_SPLICE
+    ssize_t r;
+
+    r = splice(p_dir->from, NULL, p_dir->pipe_fds[1], NULL,
+        (p_dir->capacity - p_dir->pending),
+        (SPLICE_F_MOVE | SPLICE_F_NONBLOCK));
+    if (r == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_moved) = r;
+
+    return SXS_SUCCESS;
+#else
+    p_dir->off = 0;
+
+    return sxs_recv(p_dir->from, p_dir->p_buf, p_dir->capacity, 0, p_moved);
+#endif
+}
+
+/* Move data from the pipe or buffer of a direction to its receiving
+ * socket, passing back the number of bytes moved. */
+static sxs_error_t sxs_relay_dir_drain(struct sxs_relay_dir *p_dir,
+    sxs_ssize_t *p_moved) {
+
+#ifdef SXS_RELAY_SPLICE
+    ssize_t r;
+
+    r = splice(p_dir->pipe_fds[0], NULL, p_dir->to, NULL, p_dir->pending,
+        (SPLICE_F_MOVE | SPLICE_F_NONBLOCK));
+    if (r == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_moved) = r;
+
+    return SXS_SUCCESS;
+#else
+    sxs_error_t reterr;
+
+    reterr = sxs_send(p_dir->to, (p_dir->p_buf + p_dir->off), p_dir->pending,
+        0, p_moved);
+    if (reterr == SXS_SUCCESS) {
+        p_dir->off = p_dir->off + (*p_moved);
+    }
+
+    return reterr;
+#endif
+}
+
+/* Make all the progress a direction can make without blocking. */
+static sxs_error_t sxs_relay_dir_pump(struct sxs_relay_dir *p_dir) {
+    sxs_ssize_t moved = 0;
+    sxs_error_t reterr;
+    int progress;
+
+    do {
+        progress = 0;
+
+        if (!p_dir->eof && sxs_relay_dir_room(p_dir)) {
+            reterr = sxs_relay_dir_fill(p_dir, &moved);
+            if (reterr == SXS_SUCCESS) {
+                if (moved == 0) {   /* the sending side finished */
+                    p_dir->eof = 1;
+                } else {
+                    p_dir->pending = p_dir->pending + moved;
+                }
+                progress = 1;
+            } else if (reterr != SXS_EWOULDBLOCK) {
+                return reterr;
+#ifdef SXS_RELAY_SPLICE
+            } else if (p_dir->pending > 0) {
+                /* splice() cannot tell a full pipe from an idle socket,
+                 * so with data in the pipe it is taken to be full until
+                 * some of it is sent, rather than waiting for input the
+                 * pipe may have no room for. */
+                p_dir->full = 1;
+#endif
+            }
+        }
+
+        if (p_dir->pending > 0) {
+            reterr = sxs_relay_dir_drain(p_dir, &moved);
+            if (reterr == SXS_SUCCESS) {
+                p_dir->pending = p_dir->pending - moved;
+                p_dir->bytes = p_dir->bytes + moved;
+                if (moved > 0) {
+#ifdef SXS_RELAY_SPLICE
+                    p_dir->full = 0;
+#endif
+                    progress = 1;
+                }
+            } else if (reterr != SXS_EWOULDBLOCK) {
+                return reterr;
+            }
+        }
+    } while (progress && !(p_dir->eof && (p_dir->pending == 0)));
+
+    /* Pass the end of the stream on once everything before it was. */
+    if (p_dir->eof && (p_dir->pending == 0) && !p_dir->shut) {
+        reterr = sxs_shutdown(p_dir->to, SXS_SHUT_WR);
+        if ((reterr != SXS_SUCCESS) && (reterr != SXS_ENOTCONN)) {
+            return reterr;
+        }
+        p_dir->shut = 1;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_relay_create(sxs_socket_t sd_a, sxs_socket_t sd_b,
+    sxs_relay_t **pp_relay) {
+
+    sxs_relay_t *p_relay;
+    sxs_error_t reterr;
+
+    reterr = sxs_set_nonblock(sd_a, 1);
+    if (reterr == SXS_SUCCESS) {
+        reterr = sxs_set_nonblock(sd_b, 1);
+    }
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_relay_create: sxs_set_nonblock:", reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    p_relay = (sxs_relay_t *)malloc(sizeof(sxs_relay_t));
+    if (p_relay == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    reterr = sxs_relay_dir_init(&p_relay->dirs[0], sd_a, sd_b);
+    if (reterr != SXS_SUCCESS) {
+        free(p_relay);
+        return reterr;
+    }
+
+    reterr = sxs_relay_dir_init(&p_relay->dirs[1], sd_b, sd_a);
+    if (reterr != SXS_SUCCESS) {
+        sxs_relay_dir_uninit(&p_relay->dirs[0]);
+        free(p_relay);
+        return reterr;
+    }
+
+    (*pp_relay) = p_relay;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_relay_destroy(sxs_relay_t *p_relay) {
+    sxs_relay_dir_uninit(&p_relay->dirs[0]);
+    sxs_relay_dir_uninit(&p_relay->dirs[1]);
+    free(p_relay);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_relay_pump(sxs_relay_t *p_relay) {
+    sxs_error_t reterr;
+
+    reterr = sxs_relay_dir_pump(&p_relay->dirs[0]);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    return sxs_relay_dir_pump(&p_relay->dirs[1]);
+}
+
+void sxs_relay_events(const sxs_relay_t *p_relay, int *p_events_a,
+    int *p_events_b) {
+
+    const struct sxs_relay_dir *p_ab;
+    const struct sxs_relay_dir *p_ba;
+
+    p_ab = &p_relay->dirs[0];
+    p_ba = &p_relay->dirs[1];
+
+    (*p_events_a) = 0;
+    (*p_events_b) = 0;
+
+    if (!p_ab->eof && sxs_relay_dir_room(p_ab)) {
+        (*p_events_a) |= SXS_POLLIN;
+    }
+    if (p_ab->pending > 0) {
+        (*p_events_b) |= SXS_POLLOUT;
+    }
+    if (!p_ba->eof && sxs_relay_dir_room(p_ba)) {
+        (*p_events_b) |= SXS_POLLIN;
+    }
+    if (p_ba->pending > 0) {
+        (*p_events_a) |= SXS_POLLOUT;
+    }
+}
+
+int sxs_relay_done(const sxs_relay_t *p_relay) {
+    return p_relay->dirs[0].shut && p_relay->dirs[1].shut;
+}
+
+void sxs_relay_stats(const sxs_relay_t *p_relay, sxs_relay_stats_t *p_stats) {
+    p_stats->a_to_b = p_relay->dirs[0].bytes;
+    p_stats->b_to_a = p_relay->dirs[1].bytes;
+}
+
+/* Bring the events a poller monitors a socket for up to date. A socket
+ * the relay is not waiting for is removed, as hang-ups and errors are
+ * reported regardless of the events and would otherwise wake every
+ * wait while the relay waits for the other socket. */
+static sxs_error_t sxs_relay_watch(sxs_poller_t *p_poller, sxs_socket_t sd,
+    int events, int *p_watched) {
+
+    sxs_error_t reterr;
+
+    if (events == 0) {
+        if (*p_watched) {
+            (*p_watched) = 0;
+            return sxs_poller_remove(p_poller, sd);
+        }
+        return SXS_SUCCESS;
+    }
+
+    if (*p_watched) {
+        return sxs_poller_modify(p_poller, sd, events, NULL);
+    }
+
+    reterr = sxs_poller_add(p_poller, sd, events, NULL);
+    if (reterr == SXS_SUCCESS) {
+        (*p_watched) = 1;
+    }
+
+    return reterr;
+}
+
+sxs_error_t sxs_relay_run(sxs_socket_t sd_a, sxs_socket_t sd_b,
+    const struct timeval *p_timeout, sxs_relay_stats_t *p_stats) {
+
+    sxs_relay_t *p_relay;
+    sxs_poller_t *p_poller;
+    sxs_poll_event_t *p_events;
+    sxs_error_t reterr;
+    int events_a, events_b;
+    int watched_a, watched_b;
+    int num_ready;
+
+    if (p_stats != NULL) {
+        p_stats->a_to_b = 0;
+        p_stats->b_to_a = 0;
+    }
+
+    reterr = sxs_relay_create(sd_a, sd_b, &p_relay);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    reterr = sxs_poller_create(2, &p_poller);
+    if (reterr != SXS_SUCCESS) {
+        sxs_relay_destroy(p_relay);
+        return reterr;
+    }
+
+    watched_a = 0;
+    watched_b = 0;
+
+    while (1) {
+        reterr = sxs_relay_pump(p_relay);
+        if ((reterr != SXS_SUCCESS) || sxs_relay_done(p_relay)) {
+            break;
+        }
+
+        sxs_relay_events(p_relay, &events_a, &events_b);
+        reterr = sxs_relay_watch(p_poller, sd_a, events_a, &watched_a);
+        if (reterr == SXS_SUCCESS) {
+            reterr = sxs_relay_watch(p_poller, sd_b, events_b, &watched_b);
+        }
+        if (reterr != SXS_SUCCESS) {
+            sxs_perror("sxs_relay_run: sxs_relay_watch:", reterr);
+            reterr = SXS_ERRSELECTFAIL;
+            break;
+        }
+
+        reterr = sxs_poller_wait(p_poller, p_timeout, &p_events, &num_ready);
+        if (reterr == SXS_EINTR) {
+            continue;
+        } else if (reterr != SXS_SUCCESS) {
+            sxs_perror("sxs_relay_run: sxs_poller_wait:", reterr);
+            reterr = SXS_ERRSELECTFAIL;
+            break;
+        }
+
+        if (num_ready == 0) {   /* reached the idle timeout */
+            reterr = SXS_ETIMEDOUT;
+            break;
+        }
+    }
+
+    if (p_stats != NULL) {
+        sxs_relay_stats(p_relay, p_stats);
+    }
+
+    sxs_poller_destroy(p_poller);
+    sxs_relay_destroy(p_relay);
+
+    return reterr;
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_relay.h
+ * @brief This is a specifications file for the lib_sxs relay API.
+ *
+ * The sxs_relay.h file is a specifications file that defines the
+ * functions which compose the relay API of lib_sxs. A relay forwards
+ * everything received on each of two sockets to the other one. On Linux
+ * the data is moved through a pipe with splice(), so it never enters
+ * userspace; elsewhere it is moved through a buffer of the relay. When
+ * one side stops reading, the relay stops reading from the other side
+ * once its pipe or buffer is full, so the backpressure reaches the peer
+ * through the TCP window rather than through memory growth. When one
+ * side finishes sending, the other side's sending direction is shut
+ * down once everything received before has been forwarded.
+ *
+ * A relay may be driven by sxs_relay_run(), which blocks until the
+ * relay finishes, or by an event loop which calls sxs_relay_pump()
+ * whenever one of the sockets is ready for the events given by
+ * sxs_relay_events().
+ */
+
+#ifndef SXS_RELAY_H
+#define SXS_RELAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+
+/**
+ * @typedef sxs_relay_t
+ * @brief An opaque relay between two sockets.
+ *
+ * The sxs_relay_t type represents the state of a bidirectional relay
+ * between two connected stream sockets, referred to as side A and B.
+ */
+typedef struct sxs_relay sxs_relay_t;
+
+/**
+ * @typedef sxs_relay_stats_t
+ * @brief Byte counters of a relay.
+ *
+ * The sxs_relay_stats_t type is a structure holding the number of bytes
+ * a relay has forwarded from side A to side B in 'a_to_b' and from side
+ * B to side A in 'b_to_a'.
+ */
+typedef struct sxs_relay_stats {
+    sxs_uint64_t a_to_b;
+    sxs_uint64_t b_to_a;
+} sxs_relay_stats_t;
+
+/**
+ * Create a relay.
+ *
+ * The sxs_relay_create() function creates a relay between the connected
+ * stream sockets 'sd_a' and 'sd_b' and passes it back via 'pp_relay'.
+ * Both sockets are set to non-blocking I/O mode, and must be left in it
+ * for the life of the relay. The relay does not take ownership of the
+ * sockets.
+ * @param sd_a The socket descriptor of side A.
+ * @param sd_b The socket descriptor of side B.
+ * @param pp_relay Pointer to relay pointer to store the new relay in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the relay.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets to non-blocking
+ * mode.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ * @retval SXS_EMFILE The per-process open file descriptor limit was hit.
+ * @retval SXS_ENFILE The system limit of open file descriptors was hit.
+ */
+SXS_EXPORT sxs_error_t sxs_relay_create(sxs_socket_t sd_a,
+    sxs_socket_t sd_b, sxs_relay_t **pp_relay);
+
+/**
+ * Destroy a relay.
+ *
+ * The sxs_relay_destroy() function releases all resources associated
+ * with the relay. Data received but not yet forwarded is discarded. The
+ * sockets are not closed.
+ * @param p_relay Pointer to the relay to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the relay.
+ */
+SXS_EXPORT sxs_error_t sxs_relay_destroy(sxs_relay_t *p_relay);
+
+/**
+ * Forward as much data as possible without blocking.
+ *
+ * The sxs_relay_pump() function forwards data in both directions until
+ * neither socket can make progress without blocking, and shuts down
+ * the sending direction of a side once the other side has finished
+ * sending and everything it sent was forwarded. An error on either
+ * socket, e.g. a reset by its peer, ends the relay; the caller should
+ * then destroy the relay and close both sockets. Sending on a socket
+ * whose peer is gone may raise SIGPIPE, as with sxs_send().
+ * @param p_relay Pointer to the relay to pump.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully forwarded the available data.
+ * @retval SXS_ECONNRESET A peer reset its connection.
+ * @retval SXS_EPIPE A peer is no longer accepting data.
+ */
+SXS_EXPORT sxs_error_t sxs_relay_pump(sxs_relay_t *p_relay);
+
+/**
+ * Get the events a relay is waiting for.
+ *
+ * The sxs_relay_events() function passes back the OR'd SXS_POLL* events
+ * each socket of the relay has to become ready for before calling
+ * sxs_relay_pump() can make progress, 0 if the relay is not waiting for
+ * the socket at all. A socket is not waited on for input while the
+ * data it sent is waiting for the other side, which is how
+ * backpressure is applied.
+ * @param p_relay Pointer to the relay.
+ * @param p_events_a Pointer to var to store the events of side A in.
+ * @param p_events_b Pointer to var to store the events of side B in.
+ */
+SXS_EXPORT void sxs_relay_events(const sxs_relay_t *p_relay,
+    int *p_events_a, int *p_events_b);
+
+/**
+ * Check whether a relay has finished.
+ *
+ * The sxs_relay_done() function checks whether both sides of the relay
+ * have finished sending and all the data was forwarded, i.e. the
+ * sending directions of both sockets have been shut down.
+ * @param p_relay Pointer to the relay.
+ * @return Non-zero if the relay has finished, 0 otherwise.
+ */
+SXS_EXPORT int sxs_relay_done(const sxs_relay_t *p_relay);
+
+/**
+ * Get the byte counters of a relay.
+ *
+ * The sxs_relay_stats() function passes back the number of bytes the
+ * relay has forwarded in each direction so far.
+ * @param p_relay Pointer to the relay.
+ * @param p_stats Pointer to the struct to store the counters in.
+ */
+SXS_EXPORT void sxs_relay_stats(const sxs_relay_t *p_relay,
+    sxs_relay_stats_t *p_stats);
+
+/**
+ * Relay between two sockets until both sides finish.
+ *
+ * The sxs_relay_run() function creates a relay between 'sd_a' and
+ * 'sd_b' and pumps it, waiting for the sockets as needed, until it has
+ * finished, an error occurs, or no data moved in either direction for
+ * the idle timeout 'p_timeout'. The byte counters are passed back via
+ * 'p_stats' in every case, which may be NULL. The sockets are left in
+ * non-blocking mode and are not closed.
+ * @param sd_a The socket descriptor of side A.
+ * @param sd_b The socket descriptor of side B.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to wait for either socket to become ready, or NULL to wait forever.
+ * @param p_stats Pointer to the struct to store the counters in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_relay_create() and sxs_relay_pump().
+ * @retval SXS_SUCCESS Both sides finished and all data was forwarded.
+ * @retval SXS_ETIMEDOUT The relay was idle for the timeout.
+ * @retval SXS_ERRSELECTFAIL Failed to wait for the sockets.
+ */
+SXS_EXPORT sxs_error_t sxs_relay_run(sxs_socket_t sd_a, sxs_socket_t sd_b,
+    const struct timeval *p_timeout, sxs_relay_stats_t *p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_RELAY_H */
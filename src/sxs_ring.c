@@ -0,0 +1,304 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_ring.c
+ * @brief This is an implementation file for the lib_sxs ring buffer API.
+ *
+ * The sxs_ring.c file is an implementation file which contains all the
+ * definitions for the functions which compose the mirrored ring buffer
+ * API of lib_sxs.
+ */
+
+/* memfd_create() is only declared by glibc for GNU sources. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include "sxs_ring.h"
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+#ifndef WIN32
+    #include <sys/mman.h>
+    #if defined(__linux__) && defined(MFD_CLOEXEC)
+        #define SXS_RING_MEMFD 1
+    #endif
+#endif
+
+/* The number of times Windows is asked for the two views of a ring at
+ * an address which another thread may have taken in the meantime. */
+#define SXS_RING_MAP_TRIES 16
+
+struct sxs_ring {
+    char *p_base;       /* first of the two mappings */
+    sxs_size_t size;
+    sxs_size_t rd;      /* offset of the oldest byte, below 'size' */
+    sxs_size_t len;     /* number of bytes held */
+#ifdef WIN32
+    HANDLE mapping;
+#endif
+};
+
+#ifdef WIN32
+
+static sxs_error_t sxs_ring_map(sxs_ring_t *p_ring) {
+    SYSTEM_INFO info;
+    ULARGE_INTEGER mapsize;
+    char *p_addr;
+    int i;
+
+    GetSystemInfo(&info);
+    p_ring->size = ((p_ring->size + info.dwAllocationGranularity - 1) /
+        info.dwAllocationGranularity) * info.dwAllocationGranularity;
+
+    mapsize.QuadPart = p_ring->size;
+    p_ring->mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL,
+        PAGE_READWRITE, mapsize.HighPart, mapsize.LowPart, NULL);
+    if (p_ring->mapping == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    /* Find a hole large enough for both views, then map them into it.
+     * The hole is released in between, so this is retried should
+     * another thread map something there first. */
+    for (i = 0; i < SXS_RING_MAP_TRIES; i++) {
+        p_addr = (char *)VirtualAlloc(NULL, (p_ring->size * 2),
+            MEM_RESERVE, PAGE_NOACCESS);
+        if (p_addr == NULL) {
+            break;
+        }
+        VirtualFree(p_addr, 0, MEM_RELEASE);
+
+        p_ring->p_base = (char *)MapViewOfFileEx(p_ring->mapping,
+            FILE_MAP_ALL_ACCESS, 0, 0, p_ring->size, p_addr);
+        if (p_ring->p_base == NULL) {
+            continue;
+        }
+        if (MapViewOfFileEx(p_ring->mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+            p_ring->size, (p_addr + p_ring->size)) != NULL) {
+            return SXS_SUCCESS;
+        }
+        UnmapViewOfFile(p_ring->p_base);
+    }
+
+    CloseHandle(p_ring->mapping);
+
+    return SXS_ENOMEM;
+}
+
+static void sxs_ring_unmap(sxs_ring_t *p_ring) {
+    UnmapViewOfFile(p_ring->p_base + p_ring->size);
+    UnmapViewOfFile(p_ring->p_base);
+    CloseHandle(p_ring->mapping);
+}
+
+#else
+
+/* Open an unlinked shared memory object to map twice. */
+static sxs_error_t sxs_ring_open_shm(int *p_fd) {
+#if defined(SXS_RING_MEMFD)
+    *p_fd = memfd_create("sxs_ring", MFD_CLOEXEC);
+#elif defined(SHM_ANON)
+    *p_fd = shm_open(SHM_ANON, (O_RDWR | O_CREAT), 0600);
+#else
+    static unsigned int next_id = 0;
+    char name[64];
+    int i;
+
+    /* The name only has to live until it is unlinked, and another one
+     * is tried should another ring happen to be using it. */
+    *p_fd = -1;
+    for (i = 0; i < 64; i++) {
+        snprintf(name, sizeof(name), "/sxs_ring.%ld.%u", (long)getpid(),
+            next_id++);
+        *p_fd = shm_open(name, (O_RDWR | O_CREAT | O_EXCL), 0600);
+        if (*p_fd != -1) {
+            shm_unlink(name);
+            break;
+        } else if (errno != EEXIST) {
+            break;
+        }
+    }
+#endif
+
+    if (*p_fd == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    return SXS_SUCCESS;
+}
+
+static sxs_error_t sxs_ring_map(sxs_ring_t *p_ring) {
+    sxs_error_t reterr;
+    char *p_addr;
+    long page;
+    int fd;
+
+    page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) {
+        page = 4096;
+    }
+    p_ring->size = ((p_ring->size + page - 1) / page) * page;
+
+    reterr = sxs_ring_open_shm(&fd);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    if (ftruncate(fd, (off_t)p_ring->size) == -1) {
+        reterr = sxs_map_errno(errno);
+        close(fd);
+        return reterr;
+    }
+
+    /* Reserve address space for both mappings, then replace each half
+     * of it with a mapping of the same memory. */
+    p_addr = (char *)mmap(NULL, (p_ring->size * 2), PROT_NONE,
+        (MAP_PRIVATE | MAP_ANON), -1, 0);
+    if (p_addr == (char *)MAP_FAILED) {
+        close(fd);
+        return SXS_ENOMEM;
+    }
+
+    if ((mmap(p_addr, p_ring->size, (PROT_READ | PROT_WRITE),
+        (MAP_SHARED | MAP_FIXED), fd, 0) == MAP_FAILED) ||
+        (mmap((p_addr + p_ring->size), p_ring->size,
+        (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_FIXED), fd, 0)
+        == MAP_FAILED)) {
+        reterr = sxs_map_errno(errno);
+        munmap(p_addr, (p_ring->size * 2));
+        close(fd);
+        return (reterr == SXS_EINVAL) ? SXS_EOPNOTSUPP : reterr;
+    }
+
+    /* The mappings keep the memory alive. */
+    close(fd);
+    p_ring->p_base = p_addr;
+
+    return SXS_SUCCESS;
+}
+
+static void sxs_ring_unmap(sxs_ring_t *p_ring) {
+    munmap(p_ring->p_base, (p_ring->size * 2));
+}
+
+#endif
+
+sxs_error_t sxs_ring_create(sxs_size_t size, sxs_ring_t **pp_ring) {
+    sxs_ring_t *p_ring;
+    sxs_error_t reterr;
+
+    /* Leave room for rounding up and for doubling the size. */
+    if ((size == 0) || (size > (((sxs_size_t)-1) / 4))) {
+        return SXS_EINVAL;
+    }
+
+    p_ring = (sxs_ring_t *)malloc(sizeof(sxs_ring_t));
+    if (p_ring == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    p_ring->size = size;
+    p_ring->rd = 0;
+    p_ring->len = 0;
+
+    reterr = sxs_ring_map(p_ring);
+    if (reterr != SXS_SUCCESS) {
+        free(p_ring);
+        return reterr;
+    }
+
+    /* Both views share the same pages, so one is enough. */
+    sxs_mem_apply(p_ring->p_base, p_ring->size);
+
+    (*pp_ring) = p_ring;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_ring_destroy(sxs_ring_t *p_ring) {
+    sxs_ring_unmap(p_ring);
+    free(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+sxs_size_t sxs_ring_size(const sxs_ring_t *p_ring) {
+    return p_ring->size;
+}
+
+void sxs_ring_data(const sxs_ring_t *p_ring, void **pp_data,
+    sxs_size_t *p_len) {
+    (*pp_data) = p_ring->p_base + p_ring->rd;
+    (*p_len) = p_ring->len;
+}
+
+sxs_error_t sxs_ring_consume(sxs_ring_t *p_ring, sxs_size_t len) {
+    if (len > p_ring->len) {
+        return SXS_EINVAL;
+    }
+
+    p_ring->rd = p_ring->rd + len;
+    if (p_ring->rd >= p_ring->size) {
+        p_ring->rd = p_ring->rd - p_ring->size;
+    }
+    p_ring->len = p_ring->len - len;
+
+    /* Restarting an empty ring at its base keeps small exchanges from
+     * walking the whole ring and touching every page of it. */
+    if (p_ring->len == 0) {
+        p_ring->rd = 0;
+    }
+
+    return SXS_SUCCESS;
+}
+
+void sxs_ring_space(const sxs_ring_t *p_ring, void **pp_space,
+    sxs_size_t *p_len) {
+    (*pp_space) = p_ring->p_base + p_ring->rd + p_ring->len;
+    (*p_len) = p_ring->size - p_ring->len;
+}
+
+sxs_error_t sxs_ring_commit(sxs_ring_t *p_ring, sxs_size_t len) {
+    if (len > (p_ring->size - p_ring->len)) {
+        return SXS_EINVAL;
+    }
+
+    p_ring->len = p_ring->len + len;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_ring_recv(sxs_ring_t *p_ring, sxs_socket_t sd, int flags,
+    sxs_ssize_t *p_recvd) {
+
+    sxs_error_t reterr;
+    void *p_space;
+    sxs_size_t len;
+
+    sxs_ring_space(p_ring, &p_space, &len);
+    if (len == 0) {
+        return SXS_ENOBUFS;
+    }
+
+    reterr = sxs_recv(sd, (sxs_buf_t)p_space, len, flags, p_recvd);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    p_ring->len = p_ring->len + (*p_recvd);
+
+    return SXS_SUCCESS;
+}
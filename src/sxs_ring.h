@@ -0,0 +1,172 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_ring.h
+ * @brief This is a specifications file for the lib_sxs ring buffer API.
+ *
+ * The sxs_ring.h file is a specifications file that defines the
+ * functions which compose the mirrored ring buffer API of lib_sxs. A
+ * mirrored ring maps the same memory twice, back to back, so the byte
+ * following the last byte of the ring is its first byte again. Both the
+ * data held by the ring and its free space are therefore always a
+ * single contiguous region, however they wrap: a frame straddling the
+ * end of the ring can be handed to a parser as is, and a receive can
+ * fill all the free space at once, without splitting or copying at the
+ * wrap point.
+ *
+ * A ring may be used directly, receiving into sxs_ring_space() and
+ * parsing sxs_ring_data(), or as the storage of a read buffer created
+ * with sxs_rbuf_create_ring().
+ */
+
+#ifndef SXS_RING_H
+#define SXS_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+
+/**
+ * @typedef sxs_ring_t
+ * @brief An opaque mirrored ring buffer.
+ *
+ * The sxs_ring_t type represents a ring buffer whose memory is mapped
+ * twice in a row.
+ */
+typedef struct sxs_ring sxs_ring_t;
+
+/**
+ * Create a mirrored ring buffer.
+ *
+ * The sxs_ring_create() function creates an empty ring buffer of at
+ * least 'size' bytes and passes it back via 'pp_ring'. The size is
+ * rounded up to a multiple of the granularity of memory mappings, the
+ * page size on POSIX systems and 64 KiB on Windows; sxs_ring_size()
+ * returns the actual size. The ring uses twice its size of address
+ * space but only its size of memory.
+ * @param size The minimum size of the ring in bytes.
+ * @param pp_ring Pointer to ring pointer to store the new ring in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the ring.
+ * @retval SXS_EINVAL 'size' is 0 or too large.
+ * @retval SXS_ENOMEM Insufficient memory or address space is available.
+ * @retval SXS_EMFILE The per-process open file descriptor limit was hit.
+ * @retval SXS_EOPNOTSUPP The system can not map memory twice.
+ */
+SXS_EXPORT sxs_error_t sxs_ring_create(sxs_size_t size,
+    sxs_ring_t **pp_ring);
+
+/**
+ * Destroy a mirrored ring buffer.
+ *
+ * The sxs_ring_destroy() function unmaps the memory of the ring and
+ * releases all resources associated with it.
+ * @param p_ring Pointer to the ring to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the ring.
+ */
+SXS_EXPORT sxs_error_t sxs_ring_destroy(sxs_ring_t *p_ring);
+
+/**
+ * Get the size of a ring buffer.
+ *
+ * The sxs_ring_size() function returns the number of bytes the ring
+ * can hold.
+ * @param p_ring Pointer to the ring.
+ * @return The size of the ring in bytes.
+ */
+SXS_EXPORT sxs_size_t sxs_ring_size(const sxs_ring_t *p_ring);
+
+/**
+ * Get the data held by a ring buffer.
+ *
+ * The sxs_ring_data() function passes back a pointer to the oldest
+ * byte held by the ring via 'pp_data' and the number of bytes held via
+ * 'p_len'. All of them may be accessed through the pointer.
+ * @param p_ring Pointer to the ring.
+ * @param pp_data Pointer to var to store the pointer to the data in.
+ * @param p_len Pointer to var to store the number of bytes held in.
+ */
+SXS_EXPORT void sxs_ring_data(const sxs_ring_t *p_ring, void **pp_data,
+    sxs_size_t *p_len);
+
+/**
+ * Discard data from a ring buffer.
+ *
+ * The sxs_ring_consume() function discards the oldest 'len' bytes held
+ * by the ring, making their space available again.
+ * @param p_ring Pointer to the ring.
+ * @param len The number of bytes to discard.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully discarded the data.
+ * @retval SXS_EINVAL Fewer than 'len' bytes are held.
+ */
+SXS_EXPORT sxs_error_t sxs_ring_consume(sxs_ring_t *p_ring,
+    sxs_size_t len);
+
+/**
+ * Get the free space of a ring buffer.
+ *
+ * The sxs_ring_space() function passes back a pointer to the free space
+ * of the ring, which follows the data it holds, via 'pp_space' and its
+ * length via 'p_len'. Data stored there becomes part of the ring once
+ * it is committed with sxs_ring_commit().
+ * @param p_ring Pointer to the ring.
+ * @param pp_space Pointer to var to store the pointer to the space in.
+ * @param p_len Pointer to var to store the number of free bytes in.
+ */
+SXS_EXPORT void sxs_ring_space(const sxs_ring_t *p_ring, void **pp_space,
+    sxs_size_t *p_len);
+
+/**
+ * Add data stored in the free space to a ring buffer.
+ *
+ * The sxs_ring_commit() function appends the first 'len' bytes of the
+ * free space passed back by sxs_ring_space() to the data of the ring.
+ * @param p_ring Pointer to the ring.
+ * @param len The number of bytes to append.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully appended the data.
+ * @retval SXS_EINVAL Fewer than 'len' bytes are free.
+ */
+SXS_EXPORT sxs_error_t sxs_ring_commit(sxs_ring_t *p_ring,
+    sxs_size_t len);
+
+/**
+ * Receive into the free space of a ring buffer.
+ *
+ * The sxs_ring_recv() function calls sxs_recv() once on 'sd' with all
+ * the free space of the ring and appends the received data to it.
+ * @param p_ring Pointer to the ring.
+ * @param sd The socket descriptor of the socket to receive bytes on.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_recvd Pointer to var to store resulting num of bytes
+ * received, 0 when the peer has closed the connection.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recv().
+ * @retval SXS_SUCCESS Successfully received data.
+ * @retval SXS_ENOBUFS The ring is full.
+ */
+SXS_EXPORT sxs_error_t sxs_ring_recv(sxs_ring_t *p_ring, sxs_socket_t sd,
+    int flags, sxs_ssize_t *p_recvd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_RING_H */
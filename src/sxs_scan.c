@@ -0,0 +1,201 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_scan.c
+ * @brief This is an implementation file for the lib_sxs delimiter
+ * scanner.
+ *
+ * The sxs_scan.c file is an implementation file which contains the
+ * delimiter search used by the record oriented functions of lib_sxs.
+ * The first and the last byte of the delimiter are compared against a
+ * whole vector of candidate positions at once, and only the positions
+ * where both match are compared in full, so text which rarely contains
+ * the delimiter is skipped 16 or 32 bytes at a time. SSE2 is used on
+ * every x86 processor which has it and AVX2 where the processor the
+ * library runs on supports it; other systems use memchr().
+ */
+
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || \
+    (defined(__i386__) && defined(__SSE2__)))
+    #include <immintrin.h>
+    #define SXS_SCAN_SSE2 1
+    #define SXS_SCAN_AVX2 1
+#elif defined(_MSC_VER) && (defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+    #include <emmintrin.h>
+    #define SXS_SCAN_SSE2 1
+#endif
+
+#if defined(__GNUC__)
+    #define SXS_SCAN_CTZ(mask) ((unsigned int)__builtin_ctz(mask))
+#elif defined(_MSC_VER)
+    #include <intrin.h>
+    static unsigned int sxs_scan_ctz(unsigned int mask) {
+        unsigned long index;
+
+        _BitScanForward(&index, mask);
+        return (unsigned int)index;
+    }
+    #define SXS_SCAN_CTZ(mask) sxs_scan_ctz(mask)
+#endif
+
+typedef const char *(*sxs_scan_fn_t)(const char *p_data, sxs_size_t len,
+    const char *p_delim, sxs_size_t delim_len);
+
+/* Search with memchr() for the first byte, confirming each candidate. */
+static const char *sxs_scan_scalar(const char *p_data, sxs_size_t len,
+    const char *p_delim, sxs_size_t delim_len) {
+
+    const char *p_cur;
+    const char *p_last;
+
+    if (len < delim_len) {
+        return NULL;
+    }
+
+    p_cur = p_data;
+    p_last = p_data + (len - delim_len);
+    while (p_cur <= p_last) {
+        p_cur = (const char *)memchr(p_cur, p_delim[0],
+            (p_last - p_cur) + 1);
+        if (p_cur == NULL) {
+            return NULL;
+        }
+        if (memcmp((p_cur + 1), (p_delim + 1), (delim_len - 1)) == 0) {
+            return p_cur;
+        }
+        p_cur++;
+    }
+
+    return NULL;
+}
+
+#ifdef SXS_SCAN_SSE2
+
+static const char *sxs_scan_sse2(const char *p_data, sxs_size_t len,
+    const char *p_delim, sxs_size_t delim_len) {
+
+    __m128i first;
+    __m128i last;
+    __m128i block_first;
+    __m128i block_last;
+    unsigned int mask;
+    unsigned int bit;
+    sxs_size_t i;
+
+    if (len < delim_len) {
+        return NULL;
+    }
+
+    first = _mm_set1_epi8(p_delim[0]);
+    last = _mm_set1_epi8(p_delim[delim_len - 1]);
+
+    /* 'i' is the candidate start of the delimiter; each block covers
+     * the 16 candidates from it on. */
+    for (i = 0; (i + (delim_len - 1) + 16) <= len; i += 16) {
+        block_first = _mm_loadu_si128((const __m128i *)(p_data + i));
+        block_last = _mm_loadu_si128((const __m128i *)(p_data + i +
+            (delim_len - 1)));
+        mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(block_first, first),
+            _mm_cmpeq_epi8(block_last, last)));
+        while (mask != 0) {
+            bit = SXS_SCAN_CTZ(mask);
+            if ((delim_len <= 2) || (memcmp((p_data + i + bit + 1),
+                (p_delim + 1), (delim_len - 2)) == 0)) {
+                return (p_data + i + bit);
+            }
+            mask = mask & (mask - 1);
+        }
+    }
+
+    return sxs_scan_scalar((p_data + i), (len - i), p_delim, delim_len);
+}
+
+#endif
+
+#if defined(SXS_SCAN_AVX2)
+
+__attribute__((target("avx2")))
+static const char *sxs_scan_avx2(const char *p_data, sxs_size_t len,
+    const char *p_delim, sxs_size_t delim_len) {
+
+    __m256i first;
+    __m256i last;
+    __m256i block_first;
+    __m256i block_last;
+    unsigned int mask;
+    unsigned int bit;
+    sxs_size_t i;
+
+    if (len < delim_len) {
+        return NULL;
+    }
+
+    first = _mm256_set1_epi8(p_delim[0]);
+    last = _mm256_set1_epi8(p_delim[delim_len - 1]);
+
+    for (i = 0; (i + (delim_len - 1) + 32) <= len; i += 32) {
+        block_first = _mm256_loadu_si256((const __m256i *)(p_data + i));
+        block_last = _mm256_loadu_si256((const __m256i *)(p_data + i +
+            (delim_len - 1)));
+        mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(block_first, first),
+            _mm256_cmpeq_epi8(block_last, last)));
+        while (mask != 0) {
+            bit = SXS_SCAN_CTZ(mask);
+            if ((delim_len <= 2) || (memcmp((p_data + i + bit + 1),
+                (p_delim + 1), (delim_len - 2)) == 0)) {
+                return (p_data + i + bit);
+            }
+            mask = mask & (mask - 1);
+        }
+    }
+
+    return sxs_scan_sse2((p_data + i), (len - i), p_delim, delim_len);
+}
+
+#endif
+
+/* Pick the widest implementation the processor supports. Racing
+ * threads all store the same choice. */
+static sxs_scan_fn_t sxs_scan_select(void) {
+#if defined(SXS_SCAN_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return sxs_scan_avx2;
+    }
+#endif
+#if defined(SXS_SCAN_SSE2)
+    return sxs_scan_sse2;
+#else
+    return sxs_scan_scalar;
+#endif
+}
+
+const char *sxs_scan_delim(const char *p_data, sxs_size_t len,
+    const char *p_delim, sxs_size_t delim_len) {
+
+    static sxs_scan_fn_t scan_fn = NULL;
+
+    if (scan_fn == NULL) {
+        scan_fn = sxs_scan_select();
+    }
+
+    return scan_fn(p_data, len, p_delim, delim_len);
+}
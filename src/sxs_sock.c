@@ -0,0 +1,354 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_sock.c
+ * @brief This is an implementation file for the lib_sxs socket handle API.
+ *
+ * The sxs_sock.c file is an implementation file which contains all the
+ * definitions for the functions which compose the socket handle API of
+ * lib_sxs.
+ */
+
+#include "sxs_sock.h"
+#include "sxs_poll.h"
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+/* Number of int valued socket options remembered per handle. Sockets
+ * rarely have more than a handful of options set, options set beyond
+ * this are simply not cached. */
+#define SXS_SOCK_MAX_OPTS 8
+
+struct sxs_sock_opt {
+    int level;
+    int optname;
+    int value;
+};
+
+struct sxs_sock {
+    sxs_socket_t sd;
+    int nonblock;
+#ifndef WIN32
+    int fl; /* file status flags, so a mode switch is a single F_SETFL */
+#endif
+    unsigned int num_opts;
+    struct sxs_sock_opt opts[SXS_SOCK_MAX_OPTS];
+};
+
+static struct sxs_sock_opt *sxs_sock_find_opt(sxs_sock_t *p_sock,
+    int level, int optname) {
+
+    unsigned int i;
+
+    for (i = 0; i < p_sock->num_opts; i++) {
+        if ((p_sock->opts[i].level == level) &&
+            (p_sock->opts[i].optname == optname)) {
+            return &p_sock->opts[i];
+        }
+    }
+
+    return NULL;
+}
+
+sxs_error_t sxs_sock_create(int domain, int type, int protocol,
+    sxs_sock_t **pp_sock) {
+
+    sxs_sock_t *p_sock;
+    sxs_error_t reterr;
+
+    p_sock = (sxs_sock_t *)calloc(1, sizeof(sxs_sock_t));
+    if (p_sock == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    reterr = sxs_socket(domain, type, protocol, &p_sock->sd);
+    if (reterr != SXS_SUCCESS) {
+        free(p_sock);
+        return reterr;
+    }
+
+    p_sock->nonblock = ((type & SXS_SOCK_NONBLOCK) != 0);
+#ifndef WIN32
+    p_sock->fl = p_sock->nonblock ? (O_RDWR | O_NONBLOCK) : O_RDWR;
+#endif
+    (*pp_sock) = p_sock;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_sock_wrap(sxs_socket_t sd, sxs_sock_t **pp_sock) {
+    sxs_sock_t *p_sock;
+#ifndef WIN32
+    int fl;
+
+    fl = fcntl(sd, F_GETFL, 0);
+    if (fl == -1) {
+        if (errno == EBADF) {
+            return SXS_EBADF;
+        } else {
+            return SXS_UNKNOWN_ERROR;
+        }
+    }
+#endif
+
+    p_sock = (sxs_sock_t *)calloc(1, sizeof(sxs_sock_t));
+    if (p_sock == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    p_sock->sd = sd;
+#ifndef WIN32
+    p_sock->fl = fl;
+    p_sock->nonblock = ((fl & O_NONBLOCK) == O_NONBLOCK);
+#endif
+    (*pp_sock) = p_sock;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_sock_destroy(sxs_sock_t *p_sock) {
+    free(p_sock);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_sock_close(sxs_sock_t *p_sock) {
+    sxs_error_t reterr;
+
+    reterr = sxs_close(p_sock->sd);
+    free(p_sock);
+
+    return reterr;
+}
+
+sxs_socket_t sxs_sock_sd(const sxs_sock_t *p_sock) {
+    return p_sock->sd;
+}
+
+sxs_error_t sxs_sock_set_nonblock(sxs_sock_t *p_sock, int flag) {
+#ifdef WIN32
+    u_long mode;
+#else
+    int fl;
+#endif
+
+    flag = (flag != 0);
+    if (p_sock->nonblock == flag) {
+        return SXS_SUCCESS;
+    }
+
+#ifdef WIN32
+    mode = (u_long)flag;
+    if (ioctlsocket(p_sock->sd, FIONBIO, &mode) == SXS_SOCKET_ERROR) {
+        return sxs_map_errno(WSAGetLastError());
+    }
+#else
+    fl = flag ? (p_sock->fl | O_NONBLOCK) : (p_sock->fl & (~O_NONBLOCK));
+    if (fcntl(p_sock->sd, F_SETFL, fl) == -1) {
+        if (errno == EBADF) {
+            return SXS_EBADF;
+        } else {
+            return SXS_UNKNOWN_ERROR;
+        }
+    }
+    p_sock->fl = fl;
+#endif
+    p_sock->nonblock = flag;
+
+    return SXS_SUCCESS;
+}
+
+int sxs_sock_nonblock(const sxs_sock_t *p_sock) {
+    return p_sock->nonblock;
+}
+
+sxs_error_t sxs_sock_setsockopt(sxs_sock_t *p_sock, int level, int optname,
+    const sxs_buf_t optval, sxs_socklen_t optlen) {
+
+    struct sxs_sock_opt *p_opt;
+    sxs_error_t reterr;
+    int value;
+
+    p_opt = sxs_sock_find_opt(p_sock, level, optname);
+
+    if (optlen == sizeof(int)) {
+        memcpy(&value, optval, sizeof(int));
+        if ((p_opt != NULL) && (p_opt->value == value)) {
+            return SXS_SUCCESS;
+        }
+    }
+
+    reterr = sxs_setsockopt(p_sock->sd, level, optname, optval, optlen);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    if (optlen != sizeof(int)) {
+        /* Not an int valued option, forget any value cached for it. */
+        if (p_opt != NULL) {
+            p_sock->num_opts--;
+            (*p_opt) = p_sock->opts[p_sock->num_opts];
+        }
+    } else if (p_opt != NULL) {
+        p_opt->value = value;
+    } else if (p_sock->num_opts < SXS_SOCK_MAX_OPTS) {
+        p_opt = &p_sock->opts[p_sock->num_opts++];
+        p_opt->level = level;
+        p_opt->optname = optname;
+        p_opt->value = value;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_sock_getsockopt(sxs_sock_t *p_sock, int level, int optname,
+    sxs_buf_t optval, sxs_socklen_t *optlen) {
+
+    /* The cache holds the values given to the kernel, not the ones it
+     * keeps, which it may normalize or clamp, so it is not used here. */
+    return sxs_getsockopt(p_sock->sd, level, optname, optval, optlen);
+}
+
+sxs_error_t sxs_sock_send_nb(sxs_sock_t *p_sock, const sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    sxs_ssize_t *p_sent) {
+
+    sxs_error_t reterr;
+    int revents;
+
+    reterr = sxs_sock_set_nonblock(p_sock, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sock_send_nb: sxs_sock_set_nonblock:", reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    reterr = sxs_poll_one(p_sock->sd, SXS_POLLOUT, p_timeout, &revents);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sock_send_nb: sxs_poll_one:", reterr);
+        return SXS_ERRSELECTFAIL;
+    }
+
+    if (revents == 0) {   /* reached the timeout */
+        return SXS_ERRSENDTIMEDOUT;
+    }
+
+    reterr = sxs_send(p_sock->sd, buf, len, flags, p_sent);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sock_send_nb: sxs_send:", reterr);
+        return SXS_ERRSENDFAIL;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_sock_recv_nb(sxs_sock_t *p_sock, sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    sxs_ssize_t *p_recvd) {
+
+    sxs_error_t reterr;
+    int revents;
+
+    reterr = sxs_sock_set_nonblock(p_sock, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sock_recv_nb: sxs_sock_set_nonblock:", reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    reterr = sxs_poll_one(p_sock->sd, SXS_POLLIN, p_timeout, &revents);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sock_recv_nb: sxs_poll_one:", reterr);
+        return SXS_ERRSELECTFAIL;
+    }
+
+    if (revents == 0) {   /* reached the timeout */
+        return SXS_ERRRECVTIMEDOUT;
+    }
+
+    reterr = sxs_recv(p_sock->sd, buf, len, flags, p_recvd);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sock_recv_nb: sxs_recv:", reterr);
+        return SXS_ERRRECVFAIL;
+    }
+
+    if (*p_recvd == 0) { /* peer cleanly disconnected */
+        return SXS_ERRCONNCLOSED;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_sock_send_nbytes_nb(sxs_sock_t *p_sock, const sxs_buf_t buf,
+    sxs_size_t len, const struct timeval *p_timeout) {
+
+    sxs_error_t reterr;
+
+    reterr = sxs_sock_set_nonblock(p_sock, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sock_send_nbytes_nb: sxs_sock_set_nonblock:",
+            reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return sxs_send_nbytes_wait(p_sock->sd, buf, len, 0, p_timeout,
+        NULL);
+}
+
+sxs_error_t sxs_sock_recv_nbytes_nb(sxs_sock_t *p_sock, sxs_buf_t buf,
+    sxs_size_t len, const struct timeval *p_timeout) {
+
+    sxs_error_t reterr;
+
+    reterr = sxs_sock_set_nonblock(p_sock, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sock_recv_nbytes_nb: sxs_sock_set_nonblock:",
+            reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return sxs_recv_nbytes_wait(p_sock->sd, buf, len, 0, p_timeout,
+        NULL);
+}
+
+sxs_error_t sxs_sock_send_nbytes_dl(sxs_sock_t *p_sock, const sxs_buf_t buf,
+    sxs_size_t len, sxs_uint64_t deadline_ms) {
+
+    sxs_error_t reterr;
+
+    reterr = sxs_sock_set_nonblock(p_sock, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sock_send_nbytes_dl: sxs_sock_set_nonblock:",
+            reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return sxs_send_nbytes_wait(p_sock->sd, buf, len, 0, NULL,
+        &deadline_ms);
+}
+
+sxs_error_t sxs_sock_recv_nbytes_dl(sxs_sock_t *p_sock, sxs_buf_t buf,
+    sxs_size_t len, sxs_uint64_t deadline_ms) {
+
+    sxs_error_t reterr;
+
+    reterr = sxs_sock_set_nonblock(p_sock, 1);
+    if (reterr != SXS_SUCCESS) {
+        sxs_perror("sxs_sock_recv_nbytes_dl: sxs_sock_set_nonblock:",
+            reterr);
+        return SXS_ERRSETNONBLOCK;
+    }
+
+    return sxs_recv_nbytes_wait(p_sock->sd, buf, len, 0, NULL,
+        &deadline_ms);
+}
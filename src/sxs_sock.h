@@ -0,0 +1,342 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_sock.h
+ * @brief This is a specifications file for the lib_sxs socket handle API.
+ *
+ * The sxs_sock.h file is a specifications file that defines the
+ * functions which compose the socket handle API of lib_sxs. A socket
+ * handle wraps a socket descriptor and remembers its I/O mode and the
+ * socket options applied through it, so that switching to a mode the
+ * socket is already in, or re-applying an option to the same value,
+ * costs no system call.
+ */
+
+#ifndef SXS_SOCK_H
+#define SXS_SOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+
+/**
+ * @typedef sxs_sock_t
+ * @brief An opaque socket handle.
+ *
+ * The sxs_sock_t type represents a socket descriptor along with the
+ * cached state of its I/O mode and applied socket options. The cache is
+ * only accurate as long as the descriptor is manipulated exclusively
+ * through the handle.
+ */
+typedef struct sxs_sock sxs_sock_t;
+
+/**
+ * Create a socket and a handle for it.
+ *
+ * The sxs_sock_create() function creates a new socket exactly as
+ * sxs_socket() does and passes back a handle wrapping it via the
+ * 'pp_sock' parameter. The I/O mode of a new socket is known from
+ * whether SXS_SOCK_NONBLOCK is in 'type', so no further system call is
+ * made.
+ * @param domain The communication domain, e.g. SXS_AF_INET.
+ * @param type The communication semantics, e.g. SXS_SOCK_STREAM.
+ * @param protocol The protocol to use with the socket, generally 0.
+ * @param pp_sock Pointer to handle pointer to store the new handle in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_socket().
+ * @retval SXS_SUCCESS Successfully created the socket and handle.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_create(int domain, int type, int protocol,
+    sxs_sock_t **pp_sock);
+
+/**
+ * Create a handle for an existing socket.
+ *
+ * The sxs_sock_wrap() function creates a handle for the already open
+ * socket descriptor 'sd', for example one returned by sxs_accept(), and
+ * passes it back via the 'pp_sock' parameter. The current I/O mode of
+ * the socket is read once. On Windows, where the mode can not be
+ * queried, the socket is assumed to be in blocking mode.
+ * @param sd The socket descriptor to wrap.
+ * @param pp_sock Pointer to handle pointer to store the new handle in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the handle.
+ * @retval SXS_EBADF The 'sd' parameter is not a valid descriptor.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_wrap(sxs_socket_t sd, sxs_sock_t **pp_sock);
+
+/**
+ * Destroy a socket handle.
+ *
+ * The sxs_sock_destroy() function releases the handle without closing
+ * the socket descriptor it wraps, which is left in its current I/O
+ * mode.
+ * @param p_sock Pointer to the handle to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the handle.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_destroy(sxs_sock_t *p_sock);
+
+/**
+ * Close a socket and destroy its handle.
+ *
+ * The sxs_sock_close() function closes the socket descriptor wrapped by
+ * the handle with sxs_close() and releases the handle. The handle is
+ * released even if closing the descriptor fails.
+ * @param p_sock Pointer to the handle of the socket to close.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_close().
+ * @retval SXS_SUCCESS Successfully closed the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_close(sxs_sock_t *p_sock);
+
+/**
+ * Get the socket descriptor of a socket handle.
+ *
+ * The sxs_sock_sd() function returns the socket descriptor wrapped by
+ * the handle, for use with the rest of the lib_sxs API.
+ * @param p_sock Pointer to the handle.
+ * @return The socket descriptor wrapped by the handle.
+ */
+SXS_EXPORT sxs_socket_t sxs_sock_sd(const sxs_sock_t *p_sock);
+
+/**
+ * Set the I/O mode of a socket handle.
+ *
+ * The sxs_sock_set_nonblock() function enables (non-zero 'flag') or
+ * disables (zero 'flag') non-blocking mode on the socket. Unlike
+ * sxs_set_nonblock() it is not an error for the socket to already be in
+ * the requested mode, in which case no system call is made.
+ * @param p_sock Pointer to the handle of the socket.
+ * @param flag Non-zero to enable non-blocking mode, zero to disable it.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS The socket is in the requested mode.
+ * @retval SXS_EBADF The socket descriptor is not valid.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_set_nonblock(sxs_sock_t *p_sock, int flag);
+
+/**
+ * Get the I/O mode of a socket handle.
+ *
+ * The sxs_sock_nonblock() function returns the cached I/O mode of the
+ * socket without making any system call.
+ * @param p_sock Pointer to the handle of the socket.
+ * @return Non-zero if the socket is in non-blocking mode, 0 otherwise.
+ */
+SXS_EXPORT int sxs_sock_nonblock(const sxs_sock_t *p_sock);
+
+/**
+ * Set an option of a socket handle.
+ *
+ * The sxs_sock_setsockopt() function sets a socket option as
+ * sxs_setsockopt() does. Options whose value is an int are remembered
+ * by the handle, and setting one of those to the value it already has
+ * makes no system call.
+ * @param p_sock Pointer to the handle of the socket.
+ * @param level The level at which the option resides.
+ * @param optname The name of the option to set.
+ * @param optval Pointer to buffer containing value to set option to.
+ * @param optlen The size of the value in the buffer pointed to by
+ * 'optval'.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_setsockopt().
+ * @retval SXS_SUCCESS Successfully set the socket option.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_setsockopt(sxs_sock_t *p_sock, int level,
+    int optname, const sxs_buf_t optval, sxs_socklen_t optlen);
+
+/**
+ * Get an option of a socket handle.
+ *
+ * The sxs_sock_getsockopt() function obtains a socket option as
+ * sxs_getsockopt() does. The value is always read from the socket, as
+ * the system may store another value than the one it was set to, e.g.
+ * 1 for any non-zero flag or a clamped SO_RCVLOWAT.
+ * @param p_sock Pointer to the handle of the socket.
+ * @param level The level at which the option resides.
+ * @param optname The name of the option to get.
+ * @param optval Pointer to buffer to store the option value in.
+ * @param optlen A value-result parameter, initialized to the size of
+ * the buffer pointed to by 'optval', and modified on return to indicate
+ * the size of the value stored there.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_getsockopt().
+ * @retval SXS_SUCCESS Successfully obtained the socket option.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_getsockopt(sxs_sock_t *p_sock, int level,
+    int optname, sxs_buf_t optval, sxs_socklen_t *optlen);
+
+/**
+ * Send data on a socket handle waiting up to a timeout.
+ *
+ * The sxs_sock_send_nb() function behaves like sxs_send_nb() except
+ * that the socket is only switched to non-blocking mode if it is not in
+ * it already, and is left in it on return. A sequence of calls on the
+ * same handle therefore costs no mode switching system calls after the
+ * first.
+ * @param p_sock Pointer to the handle of the socket to send on.
+ * @param buf The pointer to the buffer containing data to send.
+ * @param len The number of bytes to attempt to send over the socket.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for waiting for the socket to be ready to send data on.
+ * @param p_sent Pointer to var to store resulting num of bytes sent.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully sent the data on the socket.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets non-blocking
+ * state.
+ * @retval SXS_ERRSELECTFAIL Failed to monitor socket descriptor for
+ * being ready for sending.
+ * @retval SXS_ERRSENDTIMEDOUT Timed out waiting for the socket to be
+ * ready for sending.
+ * @retval SXS_ERRSENDFAIL Failed to send data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_send_nb(sxs_sock_t *p_sock,
+    const sxs_buf_t buf, sxs_size_t len, int flags,
+    const struct timeval *p_timeout, sxs_ssize_t *p_sent);
+
+/**
+ * Receive data from a socket handle waiting up to a timeout.
+ *
+ * The sxs_sock_recv_nb() function behaves like sxs_recv_nb() except
+ * that the socket is only switched to non-blocking mode if it is not in
+ * it already, and is left in it on return.
+ * @param p_sock Pointer to the handle of the socket to receive on.
+ * @param buf The pointer to the buffer to store received data in.
+ * @param len The size of the buffer in bytes.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for waiting for data to be available on the socket.
+ * @param p_recvd Pointer to var to store resulting num of bytes
+ * received.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully received data from the socket.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets non-blocking
+ * state.
+ * @retval SXS_ERRSELECTFAIL Failed to monitor socket descriptor for
+ * available data.
+ * @retval SXS_ERRRECVTIMEDOUT Timed out waiting for data to become
+ * available on the socket descriptor.
+ * @retval SXS_ERRRECVFAIL Failed to receive data from the socket.
+ * @retval SXS_ERRCONNCLOSED Peer closed the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_recv_nb(sxs_sock_t *p_sock, sxs_buf_t buf,
+    sxs_size_t len, int flags, const struct timeval *p_timeout,
+    sxs_ssize_t *p_recvd);
+
+/**
+ * Send a specified number of bytes on a socket handle.
+ *
+ * The sxs_sock_send_nbytes_nb() function behaves like
+ * sxs_send_nbytes_nb() except that the socket is only switched to
+ * non-blocking mode if it is not in it already, and is left in it on
+ * return.
+ * @param p_sock Pointer to the handle of the socket to send on.
+ * @param buf The pointer to the buffer containing the data to send.
+ * @param len The number of bytes to send over the socket.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for the socket to be ready for sending.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully sent all the data on the socket.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets non-blocking
+ * state.
+ * @retval SXS_ERRSELECTFAIL Failed to monitor socket descriptor for
+ * being ready for sending.
+ * @retval SXS_ERRSENDTIMEDOUT Timed out waiting for the socket to be
+ * ready for sending.
+ * @retval SXS_ERRSENDFAIL Failed to send data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_send_nbytes_nb(sxs_sock_t *p_sock,
+    const sxs_buf_t buf, sxs_size_t len, const struct timeval *p_timeout);
+
+/**
+ * Receive a specified number of bytes from a socket handle.
+ *
+ * The sxs_sock_recv_nbytes_nb() function behaves like
+ * sxs_recv_nbytes_nb() except that the socket is only switched to
+ * non-blocking mode if it is not in it already, and is left in it on
+ * return.
+ * @param p_sock Pointer to the handle of the socket to receive on.
+ * @param buf The pointer to the buffer to store received data in.
+ * @param len The number of bytes to receive over the socket.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for each wait for data to be available on the socket.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully received all the data on the socket.
+ * @retval SXS_ERRSETNONBLOCK Failed to set the sockets non-blocking
+ * state.
+ * @retval SXS_ERRSELECTFAIL Failed to monitor socket descriptor for
+ * available data.
+ * @retval SXS_ERRRECVTIMEDOUT Timed out waiting for data to become
+ * available on the socket descriptor.
+ * @retval SXS_ERRRECVFAIL Failed to receive data from the socket.
+ * @retval SXS_ERRCONNCLOSED Peer closed socket before finished
+ * receiving all the data.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_recv_nbytes_nb(sxs_sock_t *p_sock,
+    sxs_buf_t buf, sxs_size_t len, const struct timeval *p_timeout);
+
+/**
+ * Send a specified number of bytes on a socket handle before a deadline.
+ *
+ * The sxs_sock_send_nbytes_dl() function behaves like
+ * sxs_send_nbytes_dl() except that the socket is only switched to
+ * non-blocking mode if it is not in it already, and is left in it on
+ * return.
+ * @param p_sock Pointer to the handle of the socket to send on.
+ * @param buf The pointer to the buffer containing the data to send.
+ * @param len The number of bytes to send over the socket.
+ * @param deadline_ms The monotonic time, in milliseconds, by which all
+ * the bytes must have been sent.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_sock_send_nbytes_nb().
+ * @retval SXS_SUCCESS Successfully sent all the data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_send_nbytes_dl(sxs_sock_t *p_sock,
+    const sxs_buf_t buf, sxs_size_t len, sxs_uint64_t deadline_ms);
+
+/**
+ * Receive a specified number of bytes from a socket handle before a
+ * deadline.
+ *
+ * The sxs_sock_recv_nbytes_dl() function behaves like
+ * sxs_recv_nbytes_dl() except that the socket is only switched to
+ * non-blocking mode if it is not in it already, and is left in it on
+ * return.
+ * @param p_sock Pointer to the handle of the socket to receive on.
+ * @param buf The pointer to the buffer to store received data in.
+ * @param len The number of bytes to receive over the socket.
+ * @param deadline_ms The monotonic time, in milliseconds, by which all
+ * the bytes must have been received.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_sock_recv_nbytes_nb().
+ * @retval SXS_SUCCESS Successfully received all the data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_sock_recv_nbytes_dl(sxs_sock_t *p_sock,
+    sxs_buf_t buf, sxs_size_t len, sxs_uint64_t deadline_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_SOCK_H */
@@ -0,0 +1,360 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_timer.c
+ * @brief This is an implementation file for the lib_sxs timer API.
+ *
+ * The sxs_timer.c file is an implementation file which contains all the
+ * definitions for the functions which compose the timer API of lib_sxs.
+ */
+
+#include "sxs_timer.h"
+#include "sxs_config.h"
+
+#include <limits.h>
+
+#if defined(WIN32)
+#elif defined(HAVE_CLOCK_GETTIME)
+    #include <time.h>
+#else
+    #ifdef __APPLE__
+        #include <mach/mach_time.h>
+    #else
+        #include <sys/time.h>
+    #endif
+#endif
+
+/* The wheel has SXS_TIMER_LEVELS levels of SXS_TIMER_SLOTS slots each.
+ * A slot of level 0 holds the timers due in one tick, a slot of level 1
+ * those due in a block of 256 ticks, and so on. When the current tick
+ * crosses into a new block the matching slot of the next level up is
+ * cascaded, i.e. its timers are re-inserted one level lower. */
+#define SXS_TIMER_LEVELS 4
+#define SXS_TIMER_BITS 8
+#define SXS_TIMER_SLOTS (1 << SXS_TIMER_BITS)
+#define SXS_TIMER_MASK (SXS_TIMER_SLOTS - 1)
+#define SXS_TIMER_MAX_TICKS 0xffffffffULL
+
+struct sxs_timer_wheel {
+    sxs_timer_t slots[SXS_TIMER_LEVELS][SXS_TIMER_SLOTS];
+    size_t counts[SXS_TIMER_LEVELS];
+    size_t count;
+    sxs_uint64_t start_ms;
+    sxs_uint64_t now_ms;
+    sxs_uint64_t cur;
+    unsigned int tick_ms;
+};
+
+sxs_uint64_t sxs_monotonic_ms(void) {
+#ifdef WIN32
+    return (sxs_uint64_t)GetTickCount64();
+#elif defined(HAVE_CLOCK_GETTIME)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((sxs_uint64_t)ts.tv_sec * 1000) +
+        ((sxs_uint64_t)ts.tv_nsec / 1000000);
+#elif defined(__APPLE__)
+    static mach_timebase_info_data_t tb;
+
+    if (tb.denom == 0) {
+        mach_timebase_info(&tb);
+    }
+    return ((mach_absolute_time() * tb.numer) / tb.denom) / 1000000;
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return ((sxs_uint64_t)tv.tv_sec * 1000) +
+        ((sxs_uint64_t)tv.tv_usec / 1000);
+#endif
+}
+
+static void sxs_timer_list_init(sxs_timer_t *p_head) {
+    p_head->p_next = p_head;
+    p_head->p_prev = p_head;
+}
+
+static void sxs_timer_unlink(sxs_timer_t *p_timer) {
+    p_timer->p_prev->p_next = p_timer->p_next;
+    p_timer->p_next->p_prev = p_timer->p_prev;
+    p_timer->p_wheel->counts[p_timer->level]--;
+    p_timer->p_wheel->count--;
+    p_timer->p_next = NULL;
+    p_timer->p_prev = NULL;
+}
+
+/* Move all the timers of the given slot onto the list 'p_head'. */
+static void sxs_timer_list_splice(sxs_timer_t *p_slot, sxs_timer_t *p_head) {
+    sxs_timer_list_init(p_head);
+    if (p_slot->p_next != p_slot) {
+        p_head->p_next = p_slot->p_next;
+        p_head->p_prev = p_slot->p_prev;
+        p_head->p_next->p_prev = p_head;
+        p_head->p_prev->p_next = p_head;
+        sxs_timer_list_init(p_slot);
+    }
+}
+
+/* Link the timer into the slot matching its expiry tick, which must not
+ * be before the current tick. */
+static void sxs_timer_insert(sxs_timer_wheel_t *p_wheel,
+    sxs_timer_t *p_timer) {
+
+    sxs_timer_t *p_slot;
+    sxs_uint64_t delta;
+    unsigned int level;
+
+    delta = p_timer->expires - p_wheel->cur;
+    if (delta > SXS_TIMER_MAX_TICKS) {
+        p_timer->expires = p_wheel->cur + SXS_TIMER_MAX_TICKS;
+        delta = SXS_TIMER_MAX_TICKS;
+    }
+
+    for (level = 0; level < (SXS_TIMER_LEVELS - 1); level++) {
+        if (delta < (1ULL << (SXS_TIMER_BITS * (level + 1)))) {
+            break;
+        }
+    }
+
+    p_slot = &p_wheel->slots[level][(p_timer->expires >>
+        (SXS_TIMER_BITS * level)) & SXS_TIMER_MASK];
+    p_timer->level = level;
+    p_timer->p_wheel = p_wheel;
+    p_timer->p_next = p_slot;
+    p_timer->p_prev = p_slot->p_prev;
+    p_slot->p_prev->p_next = p_timer;
+    p_slot->p_prev = p_timer;
+    p_wheel->counts[level]++;
+    p_wheel->count++;
+}
+
+/* Re-insert the timers of the slot of 'level' which covers the current
+ * tick, moving them one or more levels down. */
+static void sxs_timer_cascade(sxs_timer_wheel_t *p_wheel,
+    unsigned int level) {
+
+    sxs_timer_t head;
+    sxs_timer_t *p_timer;
+
+    sxs_timer_list_splice(&p_wheel->slots[level][(p_wheel->cur >>
+        (SXS_TIMER_BITS * level)) & SXS_TIMER_MASK], &head);
+
+    while (head.p_next != &head) {
+        p_timer = head.p_next;
+        sxs_timer_unlink(p_timer);
+        sxs_timer_insert(p_wheel, p_timer);
+    }
+}
+
+sxs_error_t sxs_timer_wheel_create(unsigned int tick_ms,
+    sxs_timer_wheel_t **pp_wheel) {
+
+    sxs_timer_wheel_t *p_wheel;
+    unsigned int level;
+    unsigned int slot;
+
+    if (tick_ms == 0) {
+        return SXS_EINVAL;
+    }
+
+    p_wheel = (sxs_timer_wheel_t *)calloc(1, sizeof(sxs_timer_wheel_t));
+    if (p_wheel == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    for (level = 0; level < SXS_TIMER_LEVELS; level++) {
+        for (slot = 0; slot < SXS_TIMER_SLOTS; slot++) {
+            sxs_timer_list_init(&p_wheel->slots[level][slot]);
+        }
+    }
+
+    p_wheel->tick_ms = tick_ms;
+    p_wheel->start_ms = sxs_monotonic_ms();
+    p_wheel->now_ms = p_wheel->start_ms;
+    (*pp_wheel) = p_wheel;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_timer_wheel_destroy(sxs_timer_wheel_t *p_wheel) {
+    free(p_wheel);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_timer_wheel_advance(sxs_timer_wheel_t *p_wheel,
+    sxs_uint64_t now_ms, int *p_num_expired) {
+
+    sxs_timer_t head;
+    sxs_timer_t *p_timer;
+    sxs_uint64_t target;
+    sxs_uint64_t next;
+    unsigned int level;
+    int num_expired;
+
+    num_expired = 0;
+
+    if (now_ms > p_wheel->now_ms) {
+        p_wheel->now_ms = now_ms;
+    }
+    target = (p_wheel->now_ms - p_wheel->start_ms) / p_wheel->tick_ms;
+
+    while (p_wheel->cur <= target) {
+        if (p_wheel->count == 0) {
+            p_wheel->cur = target + 1;
+            break;
+        }
+
+        /* Cascade from the top so that a timer can drop several levels
+         * in one go when several blocks start on the same tick. */
+        for (level = (SXS_TIMER_LEVELS - 1); level > 0; level--) {
+            if ((p_wheel->cur &
+                ((1ULL << (SXS_TIMER_BITS * level)) - 1)) == 0) {
+                sxs_timer_cascade(p_wheel, level);
+            }
+        }
+
+        /* Nothing is due before the next block, skip straight to it. */
+        if (p_wheel->counts[0] == 0) {
+            next = (p_wheel->cur | SXS_TIMER_MASK) + 1;
+            p_wheel->cur = (next <= target) ? next : (target + 1);
+            continue;
+        }
+
+        /* The due timers are taken off the wheel as a batch before any
+         * callback runs, and the current tick is moved past them, so
+         * that callbacks may freely stop or restart any timer. */
+        sxs_timer_list_splice(
+            &p_wheel->slots[0][p_wheel->cur & SXS_TIMER_MASK], &head);
+        p_wheel->cur++;
+
+        while (head.p_next != &head) {
+            p_timer = head.p_next;
+            sxs_timer_unlink(p_timer);
+            p_timer->p_wheel = NULL;
+            num_expired++;
+            p_timer->cb(p_timer, p_timer->p_data);
+        }
+    }
+
+    if (p_num_expired != NULL) {
+        *p_num_expired = num_expired;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_uint64_t sxs_timer_wheel_now(const sxs_timer_wheel_t *p_wheel) {
+    return p_wheel->now_ms;
+}
+
+sxs_error_t sxs_timer_wheel_next(const sxs_timer_wheel_t *p_wheel,
+    long *p_ms) {
+
+    sxs_uint64_t next;
+    sxs_uint64_t tick;
+    sxs_uint64_t block;
+    sxs_uint64_t ms;
+    unsigned int level;
+    unsigned int pos;
+    unsigned int dist;
+    unsigned int shift;
+
+    if (p_wheel->count == 0) {
+        *p_ms = -1;
+        return SXS_SUCCESS;
+    }
+
+    next = p_wheel->cur + SXS_TIMER_MAX_TICKS;
+
+    for (level = 0; level < SXS_TIMER_LEVELS; level++) {
+        if (p_wheel->counts[level] == 0) {
+            continue;
+        }
+
+        /* Level 0 slots are exact ticks, higher level slots have to be
+         * visited when they are cascaded, at the start of their block.
+         * The slot of the current block has already been cascaded unless
+         * the current tick is the very start of it. */
+        shift = SXS_TIMER_BITS * level;
+        block = p_wheel->cur >> shift;
+        pos = (unsigned int)(block & SXS_TIMER_MASK);
+        for (dist = 0; dist <= SXS_TIMER_SLOTS; dist++) {
+            if ((dist == 0) && (level > 0) &&
+                ((p_wheel->cur & ((1ULL << shift) - 1)) != 0)) {
+                continue;
+            }
+            if (p_wheel->slots[level][(pos + dist) & SXS_TIMER_MASK].p_next !=
+                &p_wheel->slots[level][(pos + dist) & SXS_TIMER_MASK]) {
+                break;
+            }
+        }
+
+        tick = (level == 0) ? (p_wheel->cur + dist) : ((block + dist) << shift);
+        if (tick < next) {
+            next = tick;
+        }
+    }
+
+    ms = p_wheel->start_ms + (next * p_wheel->tick_ms);
+    if (ms <= p_wheel->now_ms) {
+        *p_ms = 0;
+    } else if ((ms - p_wheel->now_ms) > LONG_MAX) {
+        *p_ms = LONG_MAX;
+    } else {
+        *p_ms = (long)(ms - p_wheel->now_ms);
+    }
+
+    return SXS_SUCCESS;
+}
+
+void sxs_timer_init(sxs_timer_t *p_timer, sxs_timer_cb_t cb, void *p_data) {
+    memset(p_timer, 0, sizeof(sxs_timer_t));
+    p_timer->cb = cb;
+    p_timer->p_data = p_data;
+}
+
+sxs_error_t sxs_timer_start(sxs_timer_wheel_t *p_wheel,
+    sxs_timer_t *p_timer, sxs_uint64_t timeout_ms) {
+
+    sxs_uint64_t ticks;
+
+    sxs_timer_stop(p_timer);
+
+    /* Round up so that the timer never fires early. The clamp only keeps
+     * the sum from overflowing, insertion clamps to the wheel's range. */
+    if (timeout_ms > (SXS_TIMER_MAX_TICKS * p_wheel->tick_ms)) {
+        timeout_ms = SXS_TIMER_MAX_TICKS * p_wheel->tick_ms;
+    }
+    ticks = ((p_wheel->now_ms - p_wheel->start_ms) + timeout_ms +
+        (p_wheel->tick_ms - 1)) / p_wheel->tick_ms;
+
+    p_timer->expires = (ticks < p_wheel->cur) ? p_wheel->cur : ticks;
+    sxs_timer_insert(p_wheel, p_timer);
+
+    return SXS_SUCCESS;
+}
+
+void sxs_timer_stop(sxs_timer_t *p_timer) {
+    if (p_timer->p_wheel != NULL) {
+        sxs_timer_unlink(p_timer);
+        p_timer->p_wheel = NULL;
+    }
+}
+
+int sxs_timer_pending(const sxs_timer_t *p_timer) {
+    return (p_timer->p_wheel != NULL);
+}
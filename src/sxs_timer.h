@@ -0,0 +1,218 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_timer.h
+ * @brief This is a specifications file for the lib_sxs timer API.
+ *
+ * The sxs_timer.h file is a specifications file that defines the
+ * functions which compose the timer API of lib_sxs. Timers are kept in
+ * a hierarchical timer wheel, so starting, re-starting and stopping a
+ * timer are constant time operations regardless of the number of
+ * pending timers, which makes it practical to give every connection
+ * its own idle or keepalive timer.
+ */
+
+#ifndef SXS_TIMER_H
+#define SXS_TIMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+
+/**
+ * @typedef sxs_timer_wheel_t
+ * @brief An opaque timer wheel.
+ *
+ * The sxs_timer_wheel_t type represents a set of pending timers and the
+ * wheel's notion of the current time, which only moves forward when
+ * sxs_timer_wheel_advance() is called.
+ */
+typedef struct sxs_timer_wheel sxs_timer_wheel_t;
+
+typedef struct sxs_timer sxs_timer_t;
+
+/**
+ * @typedef sxs_timer_cb_t
+ * @brief A timer expiry callback.
+ *
+ * The sxs_timer_cb_t type is the type of the callback called when a
+ * timer expires. The callback is passed the timer and the user data
+ * pointer given to sxs_timer_init(). The timer is no longer pending
+ * when the callback is called, so the callback may restart it.
+ */
+typedef void (*sxs_timer_cb_t)(sxs_timer_t *p_timer, void *p_data);
+
+/**
+ * @typedef sxs_timer_t
+ * @brief A timer.
+ *
+ * The sxs_timer_t type is a timer. It is allocated by the application,
+ * usually as a member of its per-connection structure, so that starting
+ * and stopping it never allocates memory. Its members are private and
+ * must only be accessed through the sxs_timer_*() functions.
+ */
+struct sxs_timer {
+    sxs_timer_t *p_next;
+    sxs_timer_t *p_prev;
+    sxs_timer_wheel_t *p_wheel;
+    sxs_uint64_t expires;
+    unsigned int level;
+    sxs_timer_cb_t cb;
+    void *p_data;
+};
+
+/**
+ * Get the value of the monotonic clock.
+ *
+ * The sxs_monotonic_ms() function returns the number of milliseconds
+ * elapsed since an arbitrary fixed point in the past. Unlike the time
+ * of day it never jumps backwards or forwards when the system clock is
+ * set, which makes it suitable for measuring timeouts.
+ * @return The monotonic clock in milliseconds.
+ */
+SXS_EXPORT sxs_uint64_t sxs_monotonic_ms(void);
+
+/**
+ * Create a timer wheel.
+ *
+ * The sxs_timer_wheel_create() function creates a new timer wheel with
+ * no pending timers and passes it back via the 'pp_wheel' parameter.
+ * Expiry times are rounded up to a multiple of 'tick_ms'
+ * milliseconds, so timers never expire early but may expire up to one
+ * tick late. The wheel's current time is set to sxs_monotonic_ms().
+ * Timeouts longer than 2^32 ticks are clamped.
+ * @param tick_ms The resolution of the wheel in milliseconds.
+ * @param pp_wheel Pointer to wheel pointer to store the new wheel in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the wheel.
+ * @retval SXS_EINVAL The 'tick_ms' parameter is 0.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_timer_wheel_create(unsigned int tick_ms,
+    sxs_timer_wheel_t **pp_wheel);
+
+/**
+ * Destroy a timer wheel.
+ *
+ * The sxs_timer_wheel_destroy() function releases all resources
+ * associated with the given wheel. Timers still pending are dropped
+ * without their callbacks being called and must not be stopped
+ * afterwards.
+ * @param p_wheel Pointer to the wheel to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the wheel.
+ */
+SXS_EXPORT sxs_error_t sxs_timer_wheel_destroy(sxs_timer_wheel_t *p_wheel);
+
+/**
+ * Advance the current time of a timer wheel.
+ *
+ * The sxs_timer_wheel_advance() function moves the current time of the
+ * wheel forward to 'now_ms', normally the value of sxs_monotonic_ms(),
+ * and calls the callbacks of all timers that expired in the meantime.
+ * Timers due in the same tick are expired as a batch. A 'now_ms' in the
+ * past of the wheel is ignored.
+ * @param p_wheel Pointer to the wheel to advance.
+ * @param now_ms The new current time in milliseconds.
+ * @param p_num_expired Pointer to var to store the number of expired
+ * timers in, may be NULL.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully advanced the wheel.
+ */
+SXS_EXPORT sxs_error_t sxs_timer_wheel_advance(sxs_timer_wheel_t *p_wheel,
+    sxs_uint64_t now_ms, int *p_num_expired);
+
+/**
+ * Get the current time of a timer wheel.
+ *
+ * The sxs_timer_wheel_now() function returns the current time of the
+ * wheel, which is the 'now_ms' of the latest sxs_timer_wheel_advance().
+ * @param p_wheel Pointer to the wheel.
+ * @return The current time of the wheel in milliseconds.
+ */
+SXS_EXPORT sxs_uint64_t sxs_timer_wheel_now(const sxs_timer_wheel_t *p_wheel);
+
+/**
+ * Get the time until the next timer of a timer wheel expires.
+ *
+ * The sxs_timer_wheel_next() function passes back via 'p_ms' the number
+ * of milliseconds from the current time of the wheel until it next has
+ * to be advanced, or -1 if no timer is pending. The value is suitable
+ * as the upper bound of a wait for socket readiness. It may be shorter
+ * than the time until the earliest expiry, as long timers are moved
+ * closer to expiry in steps.
+ * @param p_wheel Pointer to the wheel.
+ * @param p_ms Pointer to var to store the number of milliseconds in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully computed the time.
+ */
+SXS_EXPORT sxs_error_t sxs_timer_wheel_next(const sxs_timer_wheel_t *p_wheel,
+    long *p_ms);
+
+/**
+ * Initialize a timer.
+ *
+ * The sxs_timer_init() function initializes the timer with the callback
+ * to call when it expires and the user data pointer to pass to it. A
+ * timer must be initialized once before it is first started.
+ * @param p_timer Pointer to the timer to initialize.
+ * @param cb The callback to call when the timer expires.
+ * @param p_data User data pointer passed to the callback.
+ */
+SXS_EXPORT void sxs_timer_init(sxs_timer_t *p_timer, sxs_timer_cb_t cb,
+    void *p_data);
+
+/**
+ * Start a timer.
+ *
+ * The sxs_timer_start() function arms the timer to expire 'timeout_ms'
+ * milliseconds after the current time of the wheel. If the timer is
+ * already pending it is re-armed, which makes pushing back an idle
+ * timeout whenever traffic arrives a constant time operation.
+ * @param p_wheel Pointer to the wheel to start the timer on.
+ * @param p_timer Pointer to the timer to start.
+ * @param timeout_ms The timeout in milliseconds.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully started the timer.
+ */
+SXS_EXPORT sxs_error_t sxs_timer_start(sxs_timer_wheel_t *p_wheel,
+    sxs_timer_t *p_timer, sxs_uint64_t timeout_ms);
+
+/**
+ * Stop a timer.
+ *
+ * The sxs_timer_stop() function disarms the timer so that its callback
+ * is not called. Stopping a timer that is not pending has no effect.
+ * @param p_timer Pointer to the timer to stop.
+ */
+SXS_EXPORT void sxs_timer_stop(sxs_timer_t *p_timer);
+
+/**
+ * Check whether a timer is pending.
+ *
+ * The sxs_timer_pending() function checks whether the timer has been
+ * started and has neither expired nor been stopped since.
+ * @param p_timer Pointer to the timer to check.
+ * @return Non-zero if the timer is pending, 0 otherwise.
+ */
+SXS_EXPORT int sxs_timer_pending(const sxs_timer_t *p_timer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_TIMER_H */
@@ -38,6 +38,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <unistd.h>
@@ -45,6 +46,7 @@
 #include <errno.h>
 #endif
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -135,6 +137,9 @@
     typedef int64_t sxs_int64_t;
     typedef socklen_t sxs_socklen_t;
     typedef in_addr_t sxs_in_addr_t;
+    typedef struct iovec sxs_iovec_t;
+    #define SXS_IOV_BASE(iov) ((iov).iov_base)
+    #define SXS_IOV_LEN(iov) ((iov).iov_len)
 #else
     #define SXS_SOCKET_ERROR SOCKET_ERROR
     #define SXS_INVALID_SOCKET INVALID_SOCKET
@@ -155,8 +160,32 @@
     typedef __int64 sxs_int64_t;
     typedef int sxs_socklen_t;
     typedef sxs_uint32_t sxs_in_addr_t;
+    typedef WSABUF sxs_iovec_t;
+    #define SXS_IOV_BASE(iov) ((iov).buf)
+    #define SXS_IOV_LEN(iov) ((iov).len)
 #endif
 
+/**
+ * @typedef sxs_iovec_t
+ * @brief A buffer of a scatter/gather array.
+ *
+ * The sxs_iovec_t is a cross-platform type which describes one buffer of
+ * an array given to the vectored I/O functions such as sxs_sendv(). It
+ * is a struct iovec on Unix and a WSABUF on Windows, so the order of its
+ * members differs and they should be accessed with SXS_IOV_BASE() and
+ * SXS_IOV_LEN().
+ */
+
+/**
+ * @def SXS_IOV_MAX
+ * @brief The maximum number of buffers passed to the system at once.
+ *
+ * The SXS_IOV_MAX macro is the number of buffers of a scatter/gather
+ * array that the vectored I/O functions hand to a single system call.
+ * The *_nbytes variants accept longer arrays and send or receive them in
+ * several calls.
+ */
+
 /**
  * @typedef sxs_sockaddr_in_t
  * @brief A type representing an internet socket address.
@@ -261,6 +290,27 @@
  * not implemented on Mac OS X systems.
  */
 
+/**
+ * @def SXS_SOCK_NONBLOCK
+ * @brief A flag used to create a socket in non-blocking mode.
+ *
+ * The SXS_SOCK_NONBLOCK flag may be OR'd into the type given to
+ * sxs_socket(), or given to sxs_accept4(), to put the new socket in
+ * non-blocking mode as part of creating it. Where the system supports it
+ * this costs no additional system call.
+ */
+
+/**
+ * @def SXS_SOCK_CLOEXEC
+ * @brief A flag used to create a socket with close-on-exec set.
+ *
+ * The SXS_SOCK_CLOEXEC flag may be OR'd into the type given to
+ * sxs_socket(), or given to sxs_accept4(), to set the close-on-exec flag
+ * of the new socket as part of creating it. Where the system supports
+ * it this also closes the window in which another thread could fork
+ * and exec with the socket inherited. It has no effect on Windows.
+ */
+
 typedef struct sockaddr_in sxs_sockaddr_in_t;
 typedef struct sockaddr sxs_sockaddr_t;
 
@@ -280,4 +330,21 @@ typedef int sxs_errno_t;
 #define SXS_SOCK_SEQPACKET SOCK_SEQPACKET
 #define SXS_SOCK_RDM SOCK_RDM
 
+/* socket type flags, emulated where the system does not have them */
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+    #define SXS_SOCK_NONBLOCK SOCK_NONBLOCK
+    #define SXS_SOCK_CLOEXEC SOCK_CLOEXEC
+#else
+    #define SXS_SOCK_NONBLOCK 0x10000000
+    #define SXS_SOCK_CLOEXEC 0x20000000
+    #define SXS_SOCK_FLAGS_EMULATED 1
+#endif
+
+/* scatter/gather arrays */
+#if defined(IOV_MAX)
+    #define SXS_IOV_MAX IOV_MAX
+#else
+    #define SXS_IOV_MAX 1024
+#endif
+
 #endif /* SXS_TYPES_H */
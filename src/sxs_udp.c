@@ -0,0 +1,245 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_udp.c
+ * @brief This is an implementation file for the lib_sxs UDP offload API.
+ *
+ * The sxs_udp.c file is an implementation file which contains all the
+ * definitions for the functions which compose the UDP segmentation
+ * offload API of lib_sxs.
+ */
+
+#include "sxs_udp.h"
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+/* Older C libraries lack the offload options even where the kernel
+ * supports them, in which case the kernel's values are used. */
+#ifdef __linux__
+    #include <netinet/udp.h>
+    #ifndef SOL_UDP
+        #define SOL_UDP 17
+    #endif
+    #ifndef UDP_SEGMENT
+        #define UDP_SEGMENT 103
+    #endif
+    #ifndef UDP_GRO
+        #define UDP_GRO 104
+    #endif
+    #define SXS_UDP_OFFLOAD 1
+#endif
+
+/* The largest UDP payload that fits an IPv4 datagram, which bounds the
+ * datagrams of a single segmented send together. */
+#define SXS_UDP_MAX_PAYLOAD 65507
+
+sxs_error_t sxs_udp_set_gro(sxs_socket_t sd, int on) {
+#ifdef SXS_UDP_OFFLOAD
+    on = (on != 0);
+    if (setsockopt(sd, SOL_UDP, UDP_GRO, &on, sizeof(int)) == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    return SXS_SUCCESS;
+#else
+    return SXS_EOPNOTSUPP;
+#endif
+}
+
+sxs_error_t sxs_udp_sendto_gso(sxs_socket_t sd, const sxs_buf_t buf,
+    sxs_size_t len, sxs_size_t seg_size, int flags,
+    const sxs_sockaddr_t *to, sxs_socklen_t tolen, sxs_ssize_t *p_sent) {
+
+#ifdef SXS_UDP_OFFLOAD
+    union {
+        char buf[CMSG_SPACE(sizeof(sxs_uint16_t))];
+        struct cmsghdr align;
+    } control;
+    struct cmsghdr *p_cmsg;
+    struct msghdr msg;
+    struct iovec iov;
+    sxs_size_t max_chunk;
+    sxs_size_t chunk;
+    sxs_ssize_t r;
+#else
+    sxs_ssize_t r;
+    sxs_size_t chunk;
+#endif
+    sxs_size_t tot_bytes_sent;
+    sxs_error_t reterr;
+
+    if ((seg_size == 0) || (seg_size > SXS_UDP_MAX_PAYLOAD)) {
+        return SXS_EINVAL;
+    }
+
+    tot_bytes_sent = 0;
+    reterr = SXS_SUCCESS;
+
+#ifdef SXS_UDP_OFFLOAD
+    max_chunk = SXS_UDP_MAX_PAYLOAD / seg_size;
+    if (max_chunk > SXS_UDP_MAX_SEGMENTS) {
+        max_chunk = SXS_UDP_MAX_SEGMENTS;
+    }
+    max_chunk = max_chunk * seg_size;
+
+    while (tot_bytes_sent < len) {
+        chunk = len - tot_bytes_sent;
+        if (chunk > max_chunk) {
+            chunk = max_chunk;
+        }
+
+        iov.iov_base = (char *)buf + tot_bytes_sent;
+        iov.iov_len = chunk;
+        memset(&msg, 0, sizeof(struct msghdr));
+        msg.msg_name = (void *)to;
+        msg.msg_namelen = (to != NULL) ? tolen : 0;
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        /* A run of a single datagram is sent as an ordinary one. */
+        if (chunk > seg_size) {
+            memset(&control, 0, sizeof(control));
+            msg.msg_control = control.buf;
+            msg.msg_controllen = sizeof(control.buf);
+            p_cmsg = CMSG_FIRSTHDR(&msg);
+            p_cmsg->cmsg_level = SOL_UDP;
+            p_cmsg->cmsg_type = UDP_SEGMENT;
+            p_cmsg->cmsg_len = CMSG_LEN(sizeof(sxs_uint16_t));
+            *(sxs_uint16_t *)CMSG_DATA(p_cmsg) = (sxs_uint16_t)seg_size;
+        }
+
+        r = sendmsg(sd, &msg, flags);
+        if (r == SXS_SOCKET_ERROR) {
+            reterr = sxs_map_errno(errno);
+            break;
+        }
+        tot_bytes_sent = tot_bytes_sent + r;
+    }
+#else
+    while (tot_bytes_sent < len) {
+        chunk = len - tot_bytes_sent;
+        if (chunk > seg_size) {
+            chunk = seg_size;
+        }
+
+        reterr = sxs_sendto(sd, (char *)buf + tot_bytes_sent, chunk, flags,
+            to, tolen, &r);
+        if (reterr != SXS_SUCCESS) {
+            break;
+        }
+        tot_bytes_sent = tot_bytes_sent + r;
+    }
+#endif
+
+    if ((reterr != SXS_SUCCESS) && (tot_bytes_sent == 0)) {
+        return reterr;
+    }
+
+    (*p_sent) = (sxs_ssize_t)tot_bytes_sent;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_udp_recvfrom_gro(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, int flags, sxs_sockaddr_t *from,
+    sxs_socklen_t *fromlen, sxs_ssize_t *p_recvd, sxs_size_t *p_seg_size) {
+
+#ifdef SXS_UDP_OFFLOAD
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct cmsghdr *p_cmsg;
+    struct msghdr msg;
+    struct iovec iov;
+    sxs_ssize_t r;
+    int gso_size;
+
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    memset(&msg, 0, sizeof(struct msghdr));
+    if ((from != NULL) && (fromlen != NULL)) {
+        msg.msg_name = from;
+        msg.msg_namelen = *fromlen;
+    }
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    r = recvmsg(sd, &msg, flags);
+    if (r == SXS_SOCKET_ERROR) {
+        return sxs_map_errno(errno);
+    }
+
+    gso_size = 0;
+    for (p_cmsg = CMSG_FIRSTHDR(&msg); p_cmsg != NULL;
+        p_cmsg = CMSG_NXTHDR(&msg, p_cmsg)) {
+        if ((p_cmsg->cmsg_level == SOL_UDP) &&
+            (p_cmsg->cmsg_type == UDP_GRO)) {
+            memcpy(&gso_size, CMSG_DATA(p_cmsg), sizeof(int));
+        }
+    }
+
+    if ((from != NULL) && (fromlen != NULL)) {
+        (*fromlen) = msg.msg_namelen;
+    }
+    (*p_recvd) = r;
+    (*p_seg_size) = (gso_size > 0) ? (sxs_size_t)gso_size : (sxs_size_t)r;
+
+    return SXS_SUCCESS;
+#else
+    sxs_error_t reterr;
+
+    reterr = sxs_recvfrom(sd, buf, len, flags, from, fromlen, p_recvd);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    (*p_seg_size) = (sxs_size_t)(*p_recvd);
+
+    return SXS_SUCCESS;
+#endif
+}
+
+sxs_error_t sxs_udp_segments(const sxs_buf_t buf, sxs_size_t len,
+    sxs_size_t seg_size, sxs_iovec_t *p_segs, int max_segs,
+    int *p_num_segs) {
+
+    sxs_size_t off;
+    sxs_size_t seg_len;
+    int num_segs;
+
+    if (seg_size == 0) {
+        seg_size = len;
+    }
+
+    off = 0;
+    num_segs = 0;
+    while ((off < len) && (num_segs < max_segs)) {
+        seg_len = len - off;
+        if (seg_len > seg_size) {
+            seg_len = seg_size;
+        }
+        SXS_IOV_BASE(p_segs[num_segs]) = (char *)buf + off;
+        SXS_IOV_LEN(p_segs[num_segs]) = seg_len;
+        off = off + seg_len;
+        num_segs++;
+    }
+
+    (*p_num_segs) = num_segs;
+
+    return (off < len) ? SXS_ENOBUFS : SXS_SUCCESS;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_udp.h
+ * @brief This is a specifications file for the lib_sxs UDP offload API.
+ *
+ * The sxs_udp.h file is a specifications file that defines the
+ * functions which compose the UDP segmentation offload API of lib_sxs.
+ * With segmentation offload (GSO) a single send hands the kernel a run
+ * of equally sized datagrams in one buffer, and with receive offload
+ * (GRO) a single receive may return several datagrams of a flow
+ * coalesced into one buffer, so that the network stack is traversed
+ * once per buffer rather than once per datagram. Offload is only
+ * available on Linux 4.18 (GSO) and 5.0 (GRO) or newer; elsewhere the
+ * functions fall back to a datagram per system call.
+ */
+
+#ifndef SXS_UDP_H
+#define SXS_UDP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+
+/**
+ * @def SXS_UDP_MAX_SEGMENTS
+ * @brief The maximum number of datagrams in one offloaded buffer.
+ *
+ * The SXS_UDP_MAX_SEGMENTS macro is the largest number of datagrams the
+ * kernel puts in a single segmented send or coalesces into a single
+ * receive. An array of this many sxs_iovec_t is always large enough for
+ * sxs_udp_segments() to split a buffer received with
+ * sxs_udp_recvfrom_gro().
+ */
+#define SXS_UDP_MAX_SEGMENTS 64
+
+/**
+ * Enable or disable receive offload on a UDP socket.
+ *
+ * The sxs_udp_set_gro() function sets whether the kernel may coalesce
+ * consecutive datagrams of a flow received on the UDP socket 'sd' into
+ * a single buffer. A socket with receive offload enabled must only be
+ * read with sxs_udp_recvfrom_gro(), as other receive functions can not
+ * tell where the coalesced datagrams begin and end.
+ * @param sd The socket descriptor of the UDP socket.
+ * @param on Non-zero to enable receive offload, 0 to disable it.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully set receive offload.
+ * @retval SXS_EOPNOTSUPP Receive offload is not supported on this system.
+ * @retval SXS_ENOPROTOOPT Receive offload is not supported by the kernel.
+ * @retval SXS_EBADF The argument 'sd' is not a valid descriptor.
+ * @retval SXS_ENOTSOCK The argument 'sd' is a file, not a socket.
+ */
+SXS_EXPORT sxs_error_t sxs_udp_set_gro(sxs_socket_t sd, int on);
+
+/**
+ * Transmit a run of datagrams held in one buffer.
+ *
+ * The sxs_udp_sendto_gso() function sends the 'len' bytes of 'buf' on
+ * the UDP socket 'sd' as consecutive datagrams of 'seg_size' bytes
+ * each, the last of which may be shorter. Where segmentation offload is
+ * available the buffer is handed to the kernel whole, in as few system
+ * calls as the limits of a single send allow, and the kernel or the NIC
+ * splits it into datagrams. Elsewhere each datagram is sent with
+ * sxs_sendto(). If an error occurs after some datagrams were sent the
+ * number of bytes sent so far is passed back and the error is left for
+ * the next call to report.
+ * @param sd The socket descriptor of the UDP socket to send on.
+ * @param buf The pointer to the buffer containing the datagrams.
+ * @param len The total size of the datagrams in bytes.
+ * @param seg_size The size of each datagram in bytes.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param to The address to send the datagrams to, or NULL for a
+ * connected socket.
+ * @param tolen The size of the address structure.
+ * @param p_sent Pointer to var to store resulting num of bytes sent.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_sendto().
+ * @retval SXS_SUCCESS Successfully sent some or all of the datagrams.
+ * @retval SXS_EINVAL The 'seg_size' is 0 or larger than a datagram can
+ * be, or the kernel does not support segmentation offload for 'sd'.
+ * @retval SXS_EIO The network device can not offload segmentation.
+ */
+SXS_EXPORT sxs_error_t sxs_udp_sendto_gso(sxs_socket_t sd,
+    const sxs_buf_t buf, sxs_size_t len, sxs_size_t seg_size, int flags,
+    const sxs_sockaddr_t *to, sxs_socklen_t tolen, sxs_ssize_t *p_sent);
+
+/**
+ * Receive a datagram or a run of coalesced datagrams.
+ *
+ * The sxs_udp_recvfrom_gro() function behaves like sxs_recvfrom() but
+ * also passes back via 'p_seg_size' the size of the datagrams the
+ * received buffer is made of. When receive offload has been enabled
+ * with sxs_udp_set_gro() the buffer may hold several datagrams from the
+ * same sender, each 'seg_size' bytes except for a possibly shorter last
+ * one, which sxs_udp_segments() splits apart. Otherwise 'seg_size' is
+ * the size of the single datagram received. To avoid truncation 'buf'
+ * should be able to hold 65535 bytes when receive offload is enabled.
+ * @param sd The socket descriptor of the UDP socket to receive on.
+ * @param buf The pointer to the buffer to store received data in.
+ * @param len The size of the buffer in bytes.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param from Pointer to the address structure to store the sender's
+ * address in, or NULL.
+ * @param fromlen Pointer to the size of the address structure, which is
+ * updated to the size of the sender's address.
+ * @param p_recvd Pointer to var to store resulting num of bytes recv'd.
+ * @param p_seg_size Pointer to var to store the datagram size in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_recvfrom().
+ * @retval SXS_SUCCESS Successfully received data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_udp_recvfrom_gro(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, int flags, sxs_sockaddr_t *from,
+    sxs_socklen_t *fromlen, sxs_ssize_t *p_recvd, sxs_size_t *p_seg_size);
+
+/**
+ * Split a buffer of coalesced datagrams into its datagrams.
+ *
+ * The sxs_udp_segments() function fills the array 'p_segs' with views
+ * of the consecutive 'seg_size' byte datagrams making up the first
+ * 'len' bytes of 'buf', the last of which may be shorter, without
+ * copying any data. At most 'max_segs' views are filled in and their
+ * number is passed back via 'p_num_segs'. A 'seg_size' of 0 yields a
+ * single view of the whole buffer.
+ * @param buf The pointer to the buffer holding the datagrams.
+ * @param len The total size of the datagrams in bytes.
+ * @param seg_size The size of each datagram in bytes.
+ * @param p_segs Pointer to the array to store the views in.
+ * @param max_segs The number of elements of the array.
+ * @param p_num_segs Pointer to var to store the number of views in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully split the whole buffer.
+ * @retval SXS_ENOBUFS The array is too small to hold a view of every
+ * datagram, the first 'max_segs' views were filled in.
+ */
+SXS_EXPORT sxs_error_t sxs_udp_segments(const sxs_buf_t buf, sxs_size_t len,
+    sxs_size_t seg_size, sxs_iovec_t *p_segs, int max_segs,
+    int *p_num_segs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_UDP_H */
@@ -0,0 +1,1603 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_uring.c
+ * @brief This is an implementation file for the lib_sxs io_uring API.
+ *
+ * The sxs_uring.c file is an implementation file which contains all the
+ * definitions for the functions which compose the completion based
+ * (io_uring) API of lib_sxs, as well as the io_uring engine used by the
+ * general API when it is selected with sxs_init_ex().
+ */
+
+#include "sxs_uring.h"
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+/* The io_uring interface is driven through the raw system calls rather
+ * than liburing so that lib_sxs does not grow a dependency that most
+ * distributions do not install by default. */
+#if defined(HAVE_LINUX_IO_URING_H) && HAVE_DECL_IORING_OP_SEND
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+    #include <pthread.h>
+    #include <fcntl.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <unistd.h>
+    #define SXS_URING_LINUX 1
+#endif
+
+#ifdef SXS_URING_LINUX
+
+/* The user_data of the SQEs lib_sxs queues for its own purposes, whose
+ * completions are never handed back to the user. */
+#define SXS_URING_INTERNAL_UD (~(sxs_uint64_t)0)
+
+/* The kernel and lib_sxs share the ring heads and tails, a tail must be
+ * published with release semantics after the entries it covers have
+ * been written, and read with acquire semantics before the entries it
+ * covers are read. */
+#define SXS_URING_LOAD_ACQ(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SXS_URING_STORE_REL(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/* Multishot operations and provided buffer rings need Linux 6.0 headers,
+ * older headers only get the single shot operations. */
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT)
+    #define SXS_URING_MULTISHOT 1
+#endif
+
+/* Each operation in flight owns one of these. The message header and
+ * io vector back the sendto and recvfrom operations, which are issued as
+ * sendmsg and recvmsg since io_uring has no address taking send or
+ * recv. A multishot operation keeps its slot until its final completion
+ * has been reaped. */
+struct sxs_uring_op {
+    sxs_uint64_t user_data;
+    struct msghdr msg;
+    struct iovec iov;
+    sxs_socklen_t *p_fromlen;
+    sxs_uring_bufring_t *p_bufring;
+    int in_use;
+    int next_free;
+};
+
+#ifdef SXS_URING_MULTISHOT
+struct sxs_uring_bufring {
+    struct io_uring_buf_ring *p_br;
+    size_t br_len;
+    char *p_bufs;
+    size_t bufs_len;
+    unsigned int buf_size;
+    unsigned int mask;
+    unsigned short tail;
+    sxs_uint16_t group_id;
+};
+#endif
+
+struct sxs_uring {
+    int fd;
+    void *p_sq_map;
+    size_t sq_map_len;
+    void *p_cq_map;
+    size_t cq_map_len;
+    struct io_uring_sqe *p_sqes;
+    size_t sqes_len;
+    unsigned int *p_sq_head;
+    unsigned int *p_sq_tail;
+    unsigned int *p_sq_array;
+    unsigned int sq_mask;
+    unsigned int sq_entries;
+    unsigned int *p_cq_head;
+    unsigned int *p_cq_tail;
+    struct io_uring_cqe *p_cqes;
+    unsigned int cq_mask;
+    unsigned int to_submit;
+    struct sxs_uring_op *p_ops;
+    unsigned int num_ops;
+    int free_op;
+    unsigned int num_sockets;
+    char *p_fixed_bufs;
+    size_t fixed_bufs_len;
+    sxs_size_t fixed_buf_size;
+    unsigned int num_fixed_bufs;
+};
+
+static int sxs_uring_setup(unsigned int entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sxs_uring_enter(int fd, unsigned int to_submit,
+    unsigned int min_complete, unsigned int flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+        flags, NULL, 0);
+}
+
+static int sxs_uring_register(int fd, unsigned int opcode, void *arg,
+    unsigned int nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* Check that the kernel supports every operation lib_sxs issues. The
+ * probe itself only exists since Linux 5.6, which is also the first
+ * version supporting all of them. */
+static int sxs_uring_probe(int fd) {
+    static const int ops[] = { IORING_OP_ACCEPT, IORING_OP_CONNECT,
+        IORING_OP_SEND, IORING_OP_RECV, IORING_OP_SENDMSG,
+        IORING_OP_RECVMSG, IORING_OP_ASYNC_CANCEL };
+    struct io_uring_probe *p_probe;
+    size_t i;
+    int supported;
+
+    p_probe = calloc(1, sizeof(struct io_uring_probe) +
+        (256 * sizeof(struct io_uring_probe_op)));
+    if (p_probe == NULL) {
+        return 0;
+    }
+
+    supported = 0;
+    if (sxs_uring_register(fd, IORING_REGISTER_PROBE, p_probe, 256) == 0) {
+        supported = 1;
+        for (i = 0; i < (sizeof(ops) / sizeof(ops[0])); i++) {
+            if ((ops[i] > p_probe->last_op) ||
+                !(p_probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED)) {
+                supported = 0;
+            }
+        }
+    }
+
+    free(p_probe);
+    return supported;
+}
+
+static void sxs_uring_unmap(sxs_uring_t *p_ring) {
+    if (p_ring->p_sqes != MAP_FAILED) {
+        munmap(p_ring->p_sqes, p_ring->sqes_len);
+    }
+    if ((p_ring->p_cq_map != MAP_FAILED) &&
+        (p_ring->p_cq_map != p_ring->p_sq_map)) {
+        munmap(p_ring->p_cq_map, p_ring->cq_map_len);
+    }
+    if (p_ring->p_sq_map != MAP_FAILED) {
+        munmap(p_ring->p_sq_map, p_ring->sq_map_len);
+    }
+}
+
+sxs_error_t sxs_uring_create(unsigned int entries, sxs_uring_t **pp_ring) {
+    sxs_uring_t *p_ring;
+    struct io_uring_params params;
+    unsigned int i;
+    sxs_errno_t errsv;
+
+    if (entries == 0) {
+        return SXS_EINVAL;
+    }
+
+    p_ring = (sxs_uring_t *)calloc(1, sizeof(sxs_uring_t));
+    if (p_ring == NULL) {
+        return SXS_ENOMEM;
+    }
+    p_ring->p_sq_map = MAP_FAILED;
+    p_ring->p_cq_map = MAP_FAILED;
+    p_ring->p_sqes = MAP_FAILED;
+
+    memset(&params, 0, sizeof(params));
+    p_ring->fd = sxs_uring_setup(entries, &params);
+    if (p_ring->fd == -1) {
+        errsv = errno;
+        free(p_ring);
+        if (errsv == ENOSYS) {
+            return SXS_EOPNOTSUPP;
+        } else if (errsv == EINVAL) {
+            return SXS_EINVAL;
+        } else if (errsv == ENOMEM) {
+            return SXS_ENOMEM;
+        } else if (errsv == EMFILE) {
+            return SXS_EMFILE;
+        } else if (errsv == ENFILE) {
+            return SXS_ENFILE;
+        } else if (errsv == EPERM) {
+            return SXS_EPERM;
+        } else {
+            return SXS_UNKNOWN_ERROR;
+        }
+    }
+
+    if (!sxs_uring_probe(p_ring->fd)) {
+        close(p_ring->fd);
+        free(p_ring);
+        return SXS_EOPNOTSUPP;
+    }
+
+    p_ring->sq_map_len = params.sq_off.array +
+        (params.sq_entries * sizeof(unsigned int));
+    p_ring->cq_map_len = params.cq_off.cqes +
+        (params.cq_entries * sizeof(struct io_uring_cqe));
+    p_ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    /* Since Linux 5.4 both rings live in a single mapping. */
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (p_ring->cq_map_len > p_ring->sq_map_len) {
+            p_ring->sq_map_len = p_ring->cq_map_len;
+        }
+        p_ring->cq_map_len = p_ring->sq_map_len;
+    }
+
+    p_ring->p_sq_map = mmap(NULL, p_ring->sq_map_len,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, p_ring->fd,
+        IORING_OFF_SQ_RING);
+    if (p_ring->p_sq_map != MAP_FAILED) {
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            p_ring->p_cq_map = p_ring->p_sq_map;
+        } else {
+            p_ring->p_cq_map = mmap(NULL, p_ring->cq_map_len,
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                p_ring->fd, IORING_OFF_CQ_RING);
+        }
+    }
+    if (p_ring->p_cq_map != MAP_FAILED) {
+        p_ring->p_sqes = (struct io_uring_sqe *)mmap(NULL, p_ring->sqes_len,
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, p_ring->fd,
+            IORING_OFF_SQES);
+    }
+
+    /* One operation slot per CQE guarantees the completion queue can
+     * never overflow. */
+    if (p_ring->p_sqes != MAP_FAILED) {
+        p_ring->p_ops = (struct sxs_uring_op *)calloc(params.cq_entries,
+            sizeof(struct sxs_uring_op));
+    }
+
+    if (p_ring->p_ops == NULL) {
+        sxs_uring_unmap(p_ring);
+        close(p_ring->fd);
+        free(p_ring);
+        return SXS_ENOMEM;
+    }
+
+    p_ring->p_sq_head = (unsigned int *)((char *)p_ring->p_sq_map +
+        params.sq_off.head);
+    p_ring->p_sq_tail = (unsigned int *)((char *)p_ring->p_sq_map +
+        params.sq_off.tail);
+    p_ring->p_sq_array = (unsigned int *)((char *)p_ring->p_sq_map +
+        params.sq_off.array);
+    p_ring->sq_mask = *(unsigned int *)((char *)p_ring->p_sq_map +
+        params.sq_off.ring_mask);
+    p_ring->sq_entries = params.sq_entries;
+
+    p_ring->p_cq_head = (unsigned int *)((char *)p_ring->p_cq_map +
+        params.cq_off.head);
+    p_ring->p_cq_tail = (unsigned int *)((char *)p_ring->p_cq_map +
+        params.cq_off.tail);
+    p_ring->p_cqes = (struct io_uring_cqe *)((char *)p_ring->p_cq_map +
+        params.cq_off.cqes);
+    p_ring->cq_mask = *(unsigned int *)((char *)p_ring->p_cq_map +
+        params.cq_off.ring_mask);
+
+    for (i = 0; i < params.cq_entries; i++) {
+        p_ring->p_ops[i].next_free = (int)i + 1;
+    }
+    p_ring->p_ops[params.cq_entries - 1].next_free = -1;
+    p_ring->num_ops = params.cq_entries;
+    p_ring->free_op = 0;
+
+    (*pp_ring) = p_ring;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_destroy(sxs_uring_t *p_ring) {
+    int r;
+
+    sxs_uring_unmap(p_ring);
+    r = close(p_ring->fd);
+    if (p_ring->p_fixed_bufs != NULL) {
+        munmap(p_ring->p_fixed_bufs, p_ring->fixed_bufs_len);
+    }
+    free(p_ring->p_ops);
+    free(p_ring);
+
+    if (r == -1) {
+        return SXS_ERRCLOSEFAIL;
+    }
+
+    return SXS_SUCCESS;
+}
+
+/* Grab a free SQE and, unless it is for internal use, an operation slot
+ * to go with it. If the submission queue is full the queued entries are
+ * submitted to make room. */
+static sxs_error_t sxs_uring_get_sqe(sxs_uring_t *p_ring,
+    sxs_uint64_t user_data, int internal, struct io_uring_sqe **pp_sqe,
+    struct sxs_uring_op **pp_op) {
+
+    struct io_uring_sqe *p_sqe;
+    struct sxs_uring_op *p_op;
+    unsigned int tail;
+    int op_idx;
+    sxs_error_t err;
+
+    if (!internal && (p_ring->free_op == -1)) {
+        return SXS_EBUSY;
+    }
+
+    tail = *p_ring->p_sq_tail;
+    if ((tail - SXS_URING_LOAD_ACQ(p_ring->p_sq_head)) == p_ring->sq_entries) {
+        err = sxs_uring_submit(p_ring, 0, NULL);
+        if ((err != SXS_SUCCESS) ||
+            ((tail - SXS_URING_LOAD_ACQ(p_ring->p_sq_head)) ==
+             p_ring->sq_entries)) {
+            return SXS_EBUSY;
+        }
+    }
+
+    p_sqe = &p_ring->p_sqes[tail & p_ring->sq_mask];
+    memset(p_sqe, 0, sizeof(struct io_uring_sqe));
+
+    if (internal) {
+        p_sqe->user_data = SXS_URING_INTERNAL_UD;
+        p_op = NULL;
+    } else {
+        op_idx = p_ring->free_op;
+        p_op = &p_ring->p_ops[op_idx];
+        p_ring->free_op = p_op->next_free;
+        p_op->user_data = user_data;
+        p_op->p_fromlen = NULL;
+        p_op->p_bufring = NULL;
+        p_op->in_use = 1;
+        p_sqe->user_data = (sxs_uint64_t)op_idx;
+    }
+
+    (*pp_sqe) = p_sqe;
+    if (pp_op != NULL) {
+        (*pp_op) = p_op;
+    }
+
+    return SXS_SUCCESS;
+}
+
+/* Make the most recently filled SQE visible to the kernel. */
+static void sxs_uring_push_sqe(sxs_uring_t *p_ring) {
+    unsigned int tail;
+
+    tail = *p_ring->p_sq_tail;
+    p_ring->p_sq_array[tail & p_ring->sq_mask] = tail & p_ring->sq_mask;
+    SXS_URING_STORE_REL(p_ring->p_sq_tail, tail + 1);
+    p_ring->to_submit++;
+}
+
+/* Take back the SQEs which have been queued but not yet consumed by the
+ * kernel, releasing their operation slots. */
+static void sxs_uring_unqueue(sxs_uring_t *p_ring) {
+    struct io_uring_sqe *p_sqe;
+    unsigned int tail;
+    int op_idx;
+
+    tail = *p_ring->p_sq_tail;
+    while (p_ring->to_submit > 0) {
+        tail--;
+        p_sqe = &p_ring->p_sqes[tail & p_ring->sq_mask];
+        if (p_sqe->user_data != SXS_URING_INTERNAL_UD) {
+            op_idx = (int)p_sqe->user_data;
+            p_ring->p_ops[op_idx].in_use = 0;
+            p_ring->p_ops[op_idx].next_free = p_ring->free_op;
+            p_ring->free_op = op_idx;
+        }
+        p_ring->to_submit--;
+    }
+    SXS_URING_STORE_REL(p_ring->p_sq_tail, tail);
+}
+
+sxs_error_t sxs_uring_prep_accept(sxs_uring_t *p_ring, sxs_socket_t sd,
+    sxs_sockaddr_t *addr, sxs_socklen_t *addrlen, sxs_uint64_t user_data) {
+
+    struct io_uring_sqe *p_sqe;
+    sxs_error_t err;
+
+    err = sxs_uring_get_sqe(p_ring, user_data, 0, &p_sqe, NULL);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    p_sqe->opcode = IORING_OP_ACCEPT;
+    p_sqe->fd = sd;
+    p_sqe->addr = (sxs_uint64_t)(uintptr_t)addr;
+    p_sqe->addr2 = (sxs_uint64_t)(uintptr_t)addrlen;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_prep_connect(sxs_uring_t *p_ring, sxs_socket_t sd,
+    const sxs_sockaddr_t *serv_addr, sxs_socklen_t addrlen,
+    sxs_uint64_t user_data) {
+
+    struct io_uring_sqe *p_sqe;
+    sxs_error_t err;
+
+    err = sxs_uring_get_sqe(p_ring, user_data, 0, &p_sqe, NULL);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    p_sqe->opcode = IORING_OP_CONNECT;
+    p_sqe->fd = sd;
+    p_sqe->addr = (sxs_uint64_t)(uintptr_t)serv_addr;
+    p_sqe->off = addrlen;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_prep_send(sxs_uring_t *p_ring, sxs_socket_t sd,
+    const sxs_buf_t buf, sxs_size_t len, int flags, sxs_uint64_t user_data) {
+
+    struct io_uring_sqe *p_sqe;
+    sxs_error_t err;
+
+    err = sxs_uring_get_sqe(p_ring, user_data, 0, &p_sqe, NULL);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    p_sqe->opcode = IORING_OP_SEND;
+    p_sqe->fd = sd;
+    p_sqe->addr = (sxs_uint64_t)(uintptr_t)buf;
+    p_sqe->len = (sxs_uint32_t)len;
+    p_sqe->msg_flags = (sxs_uint32_t)flags;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_prep_recv(sxs_uring_t *p_ring, sxs_socket_t sd,
+    sxs_buf_t buf, sxs_size_t len, int flags, sxs_uint64_t user_data) {
+
+    struct io_uring_sqe *p_sqe;
+    sxs_error_t err;
+
+    err = sxs_uring_get_sqe(p_ring, user_data, 0, &p_sqe, NULL);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    p_sqe->opcode = IORING_OP_RECV;
+    p_sqe->fd = sd;
+    p_sqe->addr = (sxs_uint64_t)(uintptr_t)buf;
+    p_sqe->len = (sxs_uint32_t)len;
+    p_sqe->msg_flags = (sxs_uint32_t)flags;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_prep_sendto(sxs_uring_t *p_ring, sxs_socket_t sd,
+    const sxs_buf_t msg, sxs_size_t len, int flags, const sxs_sockaddr_t *to,
+    sxs_socklen_t tolen, sxs_uint64_t user_data) {
+
+    struct io_uring_sqe *p_sqe;
+    struct sxs_uring_op *p_op;
+    sxs_error_t err;
+
+    err = sxs_uring_get_sqe(p_ring, user_data, 0, &p_sqe, &p_op);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    p_op->iov.iov_base = msg;
+    p_op->iov.iov_len = len;
+    memset(&p_op->msg, 0, sizeof(struct msghdr));
+    p_op->msg.msg_name = (void *)to;
+    p_op->msg.msg_namelen = (to != NULL) ? tolen : 0;
+    p_op->msg.msg_iov = &p_op->iov;
+    p_op->msg.msg_iovlen = 1;
+
+    p_sqe->opcode = IORING_OP_SENDMSG;
+    p_sqe->fd = sd;
+    p_sqe->addr = (sxs_uint64_t)(uintptr_t)&p_op->msg;
+    p_sqe->len = 1;
+    p_sqe->msg_flags = (sxs_uint32_t)flags;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_prep_recvfrom(sxs_uring_t *p_ring, sxs_socket_t sd,
+    sxs_buf_t buf, sxs_size_t len, int flags, sxs_sockaddr_t *from,
+    sxs_socklen_t *fromlen, sxs_uint64_t user_data) {
+
+    struct io_uring_sqe *p_sqe;
+    struct sxs_uring_op *p_op;
+    sxs_error_t err;
+
+    err = sxs_uring_get_sqe(p_ring, user_data, 0, &p_sqe, &p_op);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    p_op->iov.iov_base = buf;
+    p_op->iov.iov_len = len;
+    memset(&p_op->msg, 0, sizeof(struct msghdr));
+    if ((from != NULL) && (fromlen != NULL)) {
+        p_op->msg.msg_name = from;
+        p_op->msg.msg_namelen = *fromlen;
+        p_op->p_fromlen = fromlen;
+    }
+    p_op->msg.msg_iov = &p_op->iov;
+    p_op->msg.msg_iovlen = 1;
+
+    p_sqe->opcode = IORING_OP_RECVMSG;
+    p_sqe->fd = sd;
+    p_sqe->addr = (sxs_uint64_t)(uintptr_t)&p_op->msg;
+    p_sqe->len = 1;
+    p_sqe->msg_flags = (sxs_uint32_t)flags;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+static sxs_error_t sxs_uring_register_error(sxs_errno_t errsv) {
+    if (errsv == EBUSY) {
+        return SXS_EBUSY;
+    } else if (errsv == EBADF) {
+        return SXS_EBADF;
+    } else if (errsv == EINVAL) {
+        return SXS_EINVAL;
+    } else if (errsv == EMFILE) {
+        return SXS_EMFILE;
+    } else if (errsv == ENOMEM) {
+        return SXS_ENOMEM;
+    } else if (errsv == ENXIO) {
+        return SXS_ENOENT;
+    } else if (errsv == EFAULT) {
+        return SXS_EFAULT;
+    } else if (errsv == EOPNOTSUPP) {
+        return SXS_EOPNOTSUPP;
+    } else {
+        return SXS_UNKNOWN_ERROR;
+    }
+}
+
+sxs_error_t sxs_uring_register_sockets(sxs_uring_t *p_ring,
+    const sxs_socket_t *p_sds, unsigned int num_sds) {
+
+    int *p_fds;
+    unsigned int i;
+    sxs_errno_t errsv;
+
+    if (num_sds == 0) {
+        return SXS_EINVAL;
+    }
+
+    p_fds = (int *)malloc(num_sds * sizeof(int));
+    if (p_fds == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    for (i = 0; i < num_sds; i++) {
+        p_fds[i] = (p_sds != NULL) ? p_sds[i] : -1;
+    }
+
+    if (sxs_uring_register(p_ring->fd, IORING_REGISTER_FILES, p_fds,
+        num_sds) == -1) {
+
+        errsv = errno;
+        free(p_fds);
+        return sxs_uring_register_error(errsv);
+    }
+
+    free(p_fds);
+    p_ring->num_sockets = num_sds;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_update_socket(sxs_uring_t *p_ring,
+    unsigned int sock_index, sxs_socket_t sd) {
+
+    struct io_uring_files_update update;
+    int fd;
+
+    if (sock_index >= p_ring->num_sockets) {
+        return SXS_EINVAL;
+    }
+
+    fd = sd;
+    memset(&update, 0, sizeof(update));
+    update.offset = sock_index;
+    update.fds = (sxs_uint64_t)(uintptr_t)&fd;
+    if (sxs_uring_register(p_ring->fd, IORING_REGISTER_FILES_UPDATE,
+        &update, 1) == -1) {
+
+        return sxs_uring_register_error(errno);
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_unregister_sockets(sxs_uring_t *p_ring) {
+    if (sxs_uring_register(p_ring->fd, IORING_UNREGISTER_FILES, NULL,
+        0) == -1) {
+
+        return sxs_uring_register_error(errno);
+    }
+
+    p_ring->num_sockets = 0;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_register_buffers(sxs_uring_t *p_ring,
+    unsigned int num_bufs, sxs_size_t buf_size) {
+
+    struct iovec *p_iovs;
+    unsigned int i;
+    sxs_errno_t errsv;
+
+    if ((num_bufs == 0) || (buf_size == 0)) {
+        return SXS_EINVAL;
+    }
+
+    if (p_ring->p_fixed_bufs != NULL) {
+        return SXS_EBUSY;
+    }
+
+    p_iovs = (struct iovec *)malloc(num_bufs * sizeof(struct iovec));
+    if (p_iovs == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    p_ring->fixed_bufs_len = (size_t)num_bufs * buf_size;
+    p_ring->p_fixed_bufs = (char *)mmap(NULL, p_ring->fixed_bufs_len,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p_ring->p_fixed_bufs == MAP_FAILED) {
+        p_ring->p_fixed_bufs = NULL;
+        free(p_iovs);
+        return SXS_ENOMEM;
+    }
+
+    for (i = 0; i < num_bufs; i++) {
+        p_iovs[i].iov_base = p_ring->p_fixed_bufs + ((size_t)i * buf_size);
+        p_iovs[i].iov_len = buf_size;
+    }
+
+    /* Registering pins the pages once, instead of on every operation. */
+    if (sxs_uring_register(p_ring->fd, IORING_REGISTER_BUFFERS, p_iovs,
+        num_bufs) == -1) {
+
+        errsv = errno;
+        free(p_iovs);
+        munmap(p_ring->p_fixed_bufs, p_ring->fixed_bufs_len);
+        p_ring->p_fixed_bufs = NULL;
+        return sxs_uring_register_error(errsv);
+    }
+
+    free(p_iovs);
+    p_ring->num_fixed_bufs = num_bufs;
+    p_ring->fixed_buf_size = buf_size;
+
+    return SXS_SUCCESS;
+}
+
+sxs_buf_t sxs_uring_buffer(sxs_uring_t *p_ring, unsigned int buf_index) {
+    if (buf_index >= p_ring->num_fixed_bufs) {
+        return NULL;
+    }
+
+    return p_ring->p_fixed_bufs + ((size_t)buf_index * p_ring->fixed_buf_size);
+}
+
+sxs_error_t sxs_uring_unregister_buffers(sxs_uring_t *p_ring) {
+    if (p_ring->p_fixed_bufs == NULL) {
+        return SXS_ENOENT;
+    }
+
+    if (sxs_uring_register(p_ring->fd, IORING_UNREGISTER_BUFFERS, NULL,
+        0) == -1) {
+
+        return sxs_uring_register_error(errno);
+    }
+
+    munmap(p_ring->p_fixed_bufs, p_ring->fixed_bufs_len);
+    p_ring->p_fixed_bufs = NULL;
+    p_ring->num_fixed_bufs = 0;
+
+    return SXS_SUCCESS;
+}
+
+/* Queue a send or receive on a registered socket. With a registered
+ * buffer the operation is issued as a fixed write or read, which is
+ * what lets the kernel skip pinning the pages, and those do not take
+ * message flags. */
+static sxs_error_t sxs_uring_prep_registered(sxs_uring_t *p_ring,
+    int send, unsigned int sock_index, sxs_buf_t buf, sxs_size_t len,
+    int flags, int buf_index, sxs_uint64_t user_data) {
+
+    struct io_uring_sqe *p_sqe;
+    char *p_start;
+    sxs_error_t err;
+
+    if (sock_index >= p_ring->num_sockets) {
+        return SXS_EINVAL;
+    }
+
+    if (buf_index >= 0) {
+        p_start = sxs_uring_buffer(p_ring, (unsigned int)buf_index);
+        if ((p_start == NULL) || (flags != 0) || ((char *)buf < p_start) ||
+            (((char *)buf + len) > (p_start + p_ring->fixed_buf_size))) {
+            return SXS_EINVAL;
+        }
+    }
+
+    err = sxs_uring_get_sqe(p_ring, user_data, 0, &p_sqe, NULL);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    if (buf_index >= 0) {
+        p_sqe->opcode = send ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        p_sqe->buf_index = (sxs_uint16_t)buf_index;
+        p_sqe->off = (sxs_uint64_t)-1;
+    } else {
+        p_sqe->opcode = send ? IORING_OP_SEND : IORING_OP_RECV;
+        p_sqe->msg_flags = (sxs_uint32_t)flags;
+    }
+    p_sqe->flags = IOSQE_FIXED_FILE;
+    p_sqe->fd = (int)sock_index;
+    p_sqe->addr = (sxs_uint64_t)(uintptr_t)buf;
+    p_sqe->len = (sxs_uint32_t)len;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_prep_send_registered(sxs_uring_t *p_ring,
+    unsigned int sock_index, const sxs_buf_t buf, sxs_size_t len, int flags,
+    int buf_index, sxs_uint64_t user_data) {
+
+    return sxs_uring_prep_registered(p_ring, 1, sock_index, buf, len, flags,
+        buf_index, user_data);
+}
+
+sxs_error_t sxs_uring_prep_recv_registered(sxs_uring_t *p_ring,
+    unsigned int sock_index, sxs_buf_t buf, sxs_size_t len, int flags,
+    int buf_index, sxs_uint64_t user_data) {
+
+    return sxs_uring_prep_registered(p_ring, 0, sock_index, buf, len, flags,
+        buf_index, user_data);
+}
+
+sxs_error_t sxs_uring_prep_cancel(sxs_uring_t *p_ring,
+    sxs_uint64_t target_user_data, sxs_uint64_t user_data) {
+
+    struct io_uring_sqe *p_sqe;
+    unsigned int i;
+    sxs_error_t err;
+
+    for (i = 0; i < p_ring->num_ops; i++) {
+        if (p_ring->p_ops[i].in_use &&
+            (p_ring->p_ops[i].user_data == target_user_data)) {
+            break;
+        }
+    }
+    if (i == p_ring->num_ops) {
+        return SXS_ENOENT;
+    }
+
+    err = sxs_uring_get_sqe(p_ring, user_data, 0, &p_sqe, NULL);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    p_sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    p_sqe->fd = -1;
+    p_sqe->addr = (sxs_uint64_t)i;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+#ifdef SXS_URING_MULTISHOT
+
+sxs_error_t sxs_uring_prep_accept_multishot(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_uint64_t user_data) {
+
+    struct io_uring_sqe *p_sqe;
+    sxs_error_t err;
+
+    err = sxs_uring_get_sqe(p_ring, user_data, 0, &p_sqe, NULL);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    p_sqe->opcode = IORING_OP_ACCEPT;
+    p_sqe->fd = sd;
+    p_sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_prep_recv_multishot(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_uring_bufring_t *p_bufring, int flags,
+    sxs_uint64_t user_data) {
+
+    struct io_uring_sqe *p_sqe;
+    struct sxs_uring_op *p_op;
+    sxs_error_t err;
+
+    err = sxs_uring_get_sqe(p_ring, user_data, 0, &p_sqe, &p_op);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    p_op->p_bufring = p_bufring;
+
+    p_sqe->opcode = IORING_OP_RECV;
+    p_sqe->fd = sd;
+    p_sqe->ioprio = IORING_RECV_MULTISHOT;
+    p_sqe->flags = IOSQE_BUFFER_SELECT;
+    p_sqe->buf_group = p_bufring->group_id;
+    p_sqe->msg_flags = (sxs_uint32_t)flags;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_bufring_create(sxs_uring_t *p_ring,
+    sxs_uint16_t group_id, unsigned int num_bufs, unsigned int buf_size,
+    sxs_uring_bufring_t **pp_bufring) {
+
+    sxs_uring_bufring_t *p_bufring;
+    struct io_uring_buf_reg reg;
+    unsigned int i;
+    sxs_errno_t errsv;
+
+    /* The kernel requires a power of 2 number of entries. */
+    if ((num_bufs == 0) || (num_bufs > 32768) ||
+        ((num_bufs & (num_bufs - 1)) != 0) || (buf_size == 0)) {
+        return SXS_EINVAL;
+    }
+
+    p_bufring = (sxs_uring_bufring_t *)calloc(1,
+        sizeof(sxs_uring_bufring_t));
+    if (p_bufring == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    p_bufring->br_len = num_bufs * sizeof(struct io_uring_buf);
+    p_bufring->bufs_len = (size_t)num_bufs * buf_size;
+    p_bufring->buf_size = buf_size;
+    p_bufring->mask = num_bufs - 1;
+    p_bufring->group_id = group_id;
+
+    /* The ring shared with the kernel must be page aligned. */
+    p_bufring->p_br = (struct io_uring_buf_ring *)mmap(NULL,
+        p_bufring->br_len, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p_bufring->p_br == MAP_FAILED) {
+        free(p_bufring);
+        return SXS_ENOMEM;
+    }
+
+    p_bufring->p_bufs = (char *)mmap(NULL, p_bufring->bufs_len,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p_bufring->p_bufs == MAP_FAILED) {
+        munmap(p_bufring->p_br, p_bufring->br_len);
+        free(p_bufring);
+        return SXS_ENOMEM;
+    }
+
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (sxs_uint64_t)(uintptr_t)p_bufring->p_br;
+    reg.ring_entries = num_bufs;
+    reg.bgid = group_id;
+    if (sxs_uring_register(p_ring->fd, IORING_REGISTER_PBUF_RING, &reg,
+        1) == -1) {
+
+        errsv = errno;
+        munmap(p_bufring->p_bufs, p_bufring->bufs_len);
+        munmap(p_bufring->p_br, p_bufring->br_len);
+        free(p_bufring);
+        if (errsv == EEXIST) {
+            return SXS_EEXIST;
+        } else if (errsv == ENOMEM) {
+            return SXS_ENOMEM;
+        } else if (errsv == EINVAL) {
+            return SXS_EOPNOTSUPP;
+        } else {
+            return SXS_UNKNOWN_ERROR;
+        }
+    }
+
+    for (i = 0; i < num_bufs; i++) {
+        sxs_uring_bufring_recycle(p_bufring, (int)i);
+    }
+
+    (*pp_bufring) = p_bufring;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_bufring_destroy(sxs_uring_t *p_ring,
+    sxs_uring_bufring_t *p_bufring) {
+
+    struct io_uring_buf_reg reg;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = p_bufring->group_id;
+    sxs_uring_register(p_ring->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+
+    munmap(p_bufring->p_bufs, p_bufring->bufs_len);
+    munmap(p_bufring->p_br, p_bufring->br_len);
+    free(p_bufring);
+
+    return SXS_SUCCESS;
+}
+
+void sxs_uring_bufring_recycle(sxs_uring_bufring_t *p_bufring,
+    int buf_id) {
+
+    struct io_uring_buf *p_buf;
+
+    p_buf = &p_bufring->p_br->bufs[p_bufring->tail & p_bufring->mask];
+    p_buf->addr = (sxs_uint64_t)(uintptr_t)(p_bufring->p_bufs +
+        ((size_t)buf_id * p_bufring->buf_size));
+    p_buf->len = p_bufring->buf_size;
+    p_buf->bid = (sxs_uint16_t)buf_id;
+    p_bufring->tail++;
+    SXS_URING_STORE_REL(&p_bufring->p_br->tail, p_bufring->tail);
+}
+
+#else /* SXS_URING_MULTISHOT */
+
+sxs_error_t sxs_uring_prep_accept_multishot(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_recv_multishot(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_uring_bufring_t *p_bufring, int flags,
+    sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_bufring_create(sxs_uring_t *p_ring,
+    sxs_uint16_t group_id, unsigned int num_bufs, unsigned int buf_size,
+    sxs_uring_bufring_t **pp_bufring) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_bufring_destroy(sxs_uring_t *p_ring,
+    sxs_uring_bufring_t *p_bufring) {
+    return SXS_EOPNOTSUPP;
+}
+
+void sxs_uring_bufring_recycle(sxs_uring_bufring_t *p_bufring,
+    int buf_id) {
+}
+
+#endif /* SXS_URING_MULTISHOT */
+
+sxs_error_t sxs_uring_submit(sxs_uring_t *p_ring, unsigned int wait_nr,
+    int *p_submitted) {
+
+    int r;
+    sxs_errno_t errsv;
+
+    if (p_submitted != NULL) {
+        (*p_submitted) = 0;
+    }
+
+    if ((p_ring->to_submit == 0) && (wait_nr == 0)) {
+        return SXS_SUCCESS;
+    }
+
+    r = sxs_uring_enter(p_ring->fd, p_ring->to_submit, wait_nr,
+        (wait_nr > 0) ? IORING_ENTER_GETEVENTS : 0);
+    if (r == -1) {
+        errsv = errno;
+        if (errsv == EINTR) {
+            return SXS_EINTR;
+        } else if (errsv == EAGAIN) {
+            return SXS_EWOULDBLOCK;
+        } else if (errsv == EBUSY) {
+            return SXS_EBUSY;
+        } else if (errsv == EBADF) {
+            return SXS_EBADF;
+        } else if (errsv == EFAULT) {
+            return SXS_EFAULT;
+        } else if (errsv == EINVAL) {
+            return SXS_EINVAL;
+        } else {
+            return SXS_UNKNOWN_ERROR;
+        }
+    }
+
+    p_ring->to_submit -= (unsigned int)r;
+    if (p_submitted != NULL) {
+        (*p_submitted) = r;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_reap(sxs_uring_t *p_ring, sxs_uring_cqe_t *p_cqes,
+    int max_cqes, int *p_num_reaped) {
+
+    struct io_uring_cqe *p_cqe;
+    struct sxs_uring_op *p_op;
+    unsigned int head, tail;
+    int op_idx, n;
+
+    n = 0;
+    head = *p_ring->p_cq_head;
+    tail = SXS_URING_LOAD_ACQ(p_ring->p_cq_tail);
+    while ((head != tail) && (n < max_cqes)) {
+        p_cqe = &p_ring->p_cqes[head & p_ring->cq_mask];
+        head++;
+
+        if (p_cqe->user_data == SXS_URING_INTERNAL_UD) {
+            continue;
+        }
+
+        op_idx = (int)p_cqe->user_data;
+        p_op = &p_ring->p_ops[op_idx];
+
+        p_cqes[n].user_data = p_op->user_data;
+        p_cqes[n].flags = 0;
+        p_cqes[n].buf_id = -1;
+        p_cqes[n].p_buf = NULL;
+        if (p_cqe->res < 0) {
+            p_cqes[n].err = sxs_map_errno(-p_cqe->res);
+            p_cqes[n].res = 0;
+        } else {
+            p_cqes[n].err = SXS_SUCCESS;
+            p_cqes[n].res = p_cqe->res;
+            if (p_op->p_fromlen != NULL) {
+                *p_op->p_fromlen = p_op->msg.msg_namelen;
+            }
+        }
+#ifdef SXS_URING_MULTISHOT
+        if ((p_cqe->flags & IORING_CQE_F_BUFFER) && (p_op->p_bufring != NULL)) {
+            p_cqes[n].flags |= SXS_URING_CQE_F_BUFFER;
+            p_cqes[n].buf_id = (int)(p_cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+            p_cqes[n].p_buf = p_op->p_bufring->p_bufs +
+                ((size_t)p_cqes[n].buf_id * p_op->p_bufring->buf_size);
+        }
+        if (p_cqe->flags & IORING_CQE_F_MORE) {
+            p_cqes[n].flags |= SXS_URING_CQE_F_MORE;
+            n++;
+            continue;
+        }
+#endif
+        p_op->in_use = 0;
+        p_op->next_free = p_ring->free_op;
+        p_ring->free_op = op_idx;
+        n++;
+    }
+    SXS_URING_STORE_REL(p_ring->p_cq_head, head);
+
+    (*p_num_reaped) = n;
+
+    return SXS_SUCCESS;
+}
+
+/* The engine keeps one ring per thread, created on first use and
+ * destroyed when the thread exits, so the sxs entry points stay safe
+ * to call from any number of threads without locking. */
+static int sxs_uring_engine_on = 0;
+static unsigned int sxs_uring_engine_entries = 0;
+static pthread_key_t sxs_uring_engine_key;
+static pthread_once_t sxs_uring_engine_key_once = PTHREAD_ONCE_INIT;
+static int sxs_uring_engine_key_ok = 0;
+
+static void sxs_uring_engine_ring_free(void *p_ring) {
+    sxs_uring_destroy((sxs_uring_t *)p_ring);
+}
+
+static void sxs_uring_engine_key_create(void) {
+    if (pthread_key_create(&sxs_uring_engine_key,
+        sxs_uring_engine_ring_free) == 0) {
+        sxs_uring_engine_key_ok = 1;
+    }
+}
+
+static sxs_uring_t *sxs_uring_engine_ring(void) {
+    sxs_uring_t *p_ring;
+
+    p_ring = (sxs_uring_t *)pthread_getspecific(sxs_uring_engine_key);
+    if (p_ring == NULL) {
+        if (sxs_uring_create(sxs_uring_engine_entries, &p_ring) !=
+            SXS_SUCCESS) {
+            return NULL;
+        }
+        if (pthread_setspecific(sxs_uring_engine_key, p_ring) != 0) {
+            sxs_uring_destroy(p_ring);
+            return NULL;
+        }
+    }
+
+    return p_ring;
+}
+
+sxs_error_t sxs_uring_engine_init(unsigned int entries) {
+    sxs_uring_t *p_ring;
+    sxs_error_t err;
+
+    pthread_once(&sxs_uring_engine_key_once, sxs_uring_engine_key_create);
+    if (!sxs_uring_engine_key_ok) {
+        return SXS_ENOMEM;
+    }
+
+    /* Create the ring of the initializing thread up front so that an
+     * unusable io_uring is detected here and the caller can fall back. */
+    sxs_uring_engine_entries = entries;
+    p_ring = (sxs_uring_t *)pthread_getspecific(sxs_uring_engine_key);
+    if (p_ring == NULL) {
+        err = sxs_uring_create(entries, &p_ring);
+        if (err != SXS_SUCCESS) {
+            return err;
+        }
+        if (pthread_setspecific(sxs_uring_engine_key, p_ring) != 0) {
+            sxs_uring_destroy(p_ring);
+            return SXS_ENOMEM;
+        }
+    }
+
+    sxs_uring_engine_on = 1;
+
+    return SXS_SUCCESS;
+}
+
+void sxs_uring_engine_uninit(void) {
+    sxs_uring_t *p_ring;
+
+    if (!sxs_uring_engine_key_ok) {
+        return;
+    }
+
+    sxs_uring_engine_on = 0;
+    p_ring = (sxs_uring_t *)pthread_getspecific(sxs_uring_engine_key);
+    if (p_ring != NULL) {
+        pthread_setspecific(sxs_uring_engine_key, NULL);
+        sxs_uring_destroy(p_ring);
+    }
+}
+
+int sxs_uring_engine_enabled(void) {
+    /* A thread which cannot get a ring of its own, for example because
+     * it is out of descriptors, quietly uses the system calls. */
+    return sxs_uring_engine_on && (sxs_uring_engine_ring() != NULL);
+}
+
+/* Submit the single operation queued on the ring of the calling thread
+ * and wait for its completion. If the wait is interrupted by a signal
+ * the operation is cancelled, because it references memory owned by the
+ * caller, and SXS_EINTR is reported unless it completed regardless. */
+static sxs_error_t sxs_uring_engine_wait(sxs_uring_t *p_ring,
+    sxs_ssize_t *p_res) {
+
+    struct io_uring_sqe *p_sqe;
+    sxs_uring_cqe_t cqe;
+    sxs_uint64_t op_ud;
+    int num_reaped, cancelled;
+    sxs_error_t err;
+
+    op_ud = p_ring->p_sqes[(*p_ring->p_sq_tail - 1) & p_ring->sq_mask].user_data;
+
+    err = sxs_uring_submit(p_ring, 1, NULL);
+    if (err != SXS_SUCCESS) {
+        sxs_uring_unqueue(p_ring);
+        return err;
+    }
+
+    /* A wait only returns without a completion when interrupted. */
+    cancelled = 0;
+    while (1) {
+        sxs_uring_reap(p_ring, &cqe, 1, &num_reaped);
+        if (num_reaped == 1) {
+            break;
+        }
+
+        if (!cancelled &&
+            (sxs_uring_get_sqe(p_ring, 0, 1, &p_sqe, NULL) == SXS_SUCCESS)) {
+            p_sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            p_sqe->fd = -1;
+            p_sqe->addr = op_ud;
+            sxs_uring_push_sqe(p_ring);
+            cancelled = 1;
+        }
+
+        err = sxs_uring_submit(p_ring, 1, NULL);
+        if ((err != SXS_SUCCESS) && (err != SXS_EINTR)) {
+            return err;
+        }
+    }
+
+    /* A cancel that is still queued must not be submitted later, as by
+     * then the slot it targets may belong to another operation. */
+    sxs_uring_unqueue(p_ring);
+
+    if (cancelled && (cqe.err == SXS_ECANCELED)) {
+        return SXS_EINTR;
+    } else if (cqe.err != SXS_SUCCESS) {
+        return cqe.err;
+    }
+
+    (*p_res) = cqe.res;
+
+    return SXS_SUCCESS;
+}
+
+/* Whether a call on 'sd' which would block is to wait on the ring. The
+ * socket must be in blocking mode, and must not have the 'timeo_opt'
+ * timeout, SO_RCVTIMEO or SO_SNDTIMEO, set as io_uring ignores it. Both
+ * are read from the socket, as descriptors may be reused or have their
+ * mode changed by code outside lib_sxs. */
+static int sxs_uring_engine_may_wait(sxs_socket_t sd, int timeo_opt) {
+    struct timeval timeo;
+    socklen_t timeo_len;
+    int flags;
+
+    flags = fcntl(sd, F_GETFL);
+    if ((flags == -1) || (flags & O_NONBLOCK)) {
+        return 0;
+    }
+
+    timeo_len = sizeof(timeo);
+    if (getsockopt(sd, SOL_SOCKET, timeo_opt, &timeo, &timeo_len) == -1) {
+        return 0;
+    }
+
+    return (timeo.tv_sec == 0) && (timeo.tv_usec == 0);
+}
+
+/* io_uring waits for readiness on behalf of the caller even when the
+ * socket is in non-blocking mode, and a wait on the ring costs the
+ * same single system call as a blocking send or receive. So sends and
+ * receives are first made directly without waiting, which is the common
+ * case when driven by a poller and costs no more than the default
+ * engine, and only those which would block are looked at further. They
+ * wait on the ring if sxs_uring_engine_may_wait() allows it, otherwise
+ * they are made again as asked, so that a non-blocking socket reports
+ * SXS_EWOULDBLOCK and timeouts are honoured. */
+
+sxs_error_t sxs_uring_engine_send(sxs_socket_t sd, const sxs_buf_t buf,
+    sxs_size_t len, int flags, const sxs_sockaddr_t *to,
+    sxs_socklen_t tolen, sxs_ssize_t *p_sent) {
+
+    sxs_uring_t *p_ring;
+    sxs_ssize_t r;
+    sxs_error_t err;
+
+    r = sendto(sd, buf, len, (flags | MSG_DONTWAIT), to, tolen);
+    if ((r == -1) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)) &&
+        !(flags & MSG_DONTWAIT)) {
+        if (!sxs_uring_engine_may_wait(sd, SO_SNDTIMEO)) {
+            r = sendto(sd, buf, len, flags, to, tolen);
+        } else {
+            p_ring = sxs_uring_engine_ring();
+            if (to != NULL) {
+                err = sxs_uring_prep_sendto(p_ring, sd, buf, len, flags, to,
+                    tolen, 0);
+            } else {
+                err = sxs_uring_prep_send(p_ring, sd, buf, len, flags, 0);
+            }
+            if (err == SXS_SUCCESS) {
+                err = sxs_uring_engine_wait(p_ring, p_sent);
+            }
+            return err;
+        }
+    }
+    if (r == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_sent) = r;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_engine_recv(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, int flags, sxs_sockaddr_t *from,
+    sxs_socklen_t *fromlen, sxs_ssize_t *p_recvd) {
+
+    sxs_uring_t *p_ring;
+    sxs_ssize_t r;
+    sxs_error_t err;
+
+    r = recvfrom(sd, buf, len, (flags | MSG_DONTWAIT), from, fromlen);
+    if ((r == -1) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)) &&
+        !(flags & MSG_DONTWAIT)) {
+        if (!sxs_uring_engine_may_wait(sd, SO_RCVTIMEO)) {
+            r = recvfrom(sd, buf, len, flags, from, fromlen);
+        } else {
+            p_ring = sxs_uring_engine_ring();
+            if (from != NULL) {
+                err = sxs_uring_prep_recvfrom(p_ring, sd, buf, len, flags,
+                    from, fromlen, 0);
+            } else {
+                err = sxs_uring_prep_recv(p_ring, sd, buf, len, flags, 0);
+            }
+            if (err == SXS_SUCCESS) {
+                err = sxs_uring_engine_wait(p_ring, p_recvd);
+            }
+            return err;
+        }
+    }
+    if (r == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_recvd) = r;
+
+    return SXS_SUCCESS;
+}
+
+/* Queue a sendmsg or recvmsg of a scatter/gather array owned by the
+ * caller, which must stay valid until the operation completes. */
+static sxs_error_t sxs_uring_engine_prep_msgv(sxs_uring_t *p_ring,
+    sxs_uint8_t opcode, sxs_socket_t sd, const sxs_iovec_t *p_iov,
+    int iovcnt, int flags) {
+
+    struct io_uring_sqe *p_sqe;
+    struct sxs_uring_op *p_op;
+    sxs_error_t err;
+
+    err = sxs_uring_get_sqe(p_ring, 0, 0, &p_sqe, &p_op);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+
+    memset(&p_op->msg, 0, sizeof(struct msghdr));
+    p_op->msg.msg_iov = (struct iovec *)p_iov;
+    p_op->msg.msg_iovlen = iovcnt;
+
+    p_sqe->opcode = opcode;
+    p_sqe->fd = sd;
+    p_sqe->addr = (sxs_uint64_t)(uintptr_t)&p_op->msg;
+    p_sqe->len = 1;
+    p_sqe->msg_flags = (sxs_uint32_t)flags;
+    sxs_uring_push_sqe(p_ring);
+
+    return SXS_SUCCESS;
+}
+
+/* Perform a vectored send or receive, first without waiting and then,
+ * as sxs_uring_engine_send() and sxs_uring_engine_recv() do, waiting on
+ * the ring or making it again as asked. */
+static sxs_error_t sxs_uring_engine_msgv(sxs_uint8_t opcode,
+    sxs_socket_t sd, const sxs_iovec_t *p_iov, int iovcnt, int flags,
+    sxs_ssize_t *p_res) {
+
+    struct msghdr msg;
+    sxs_uring_t *p_ring;
+    sxs_ssize_t r;
+    sxs_error_t err;
+    int timeo_opt;
+
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov = (struct iovec *)p_iov;
+    msg.msg_iovlen = iovcnt;
+
+    if (opcode == IORING_OP_SENDMSG) {
+        r = sendmsg(sd, &msg, (flags | MSG_DONTWAIT));
+        timeo_opt = SO_SNDTIMEO;
+    } else {
+        r = recvmsg(sd, &msg, (flags | MSG_DONTWAIT));
+        timeo_opt = SO_RCVTIMEO;
+    }
+    if ((r == -1) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)) &&
+        !(flags & MSG_DONTWAIT)) {
+        if (!sxs_uring_engine_may_wait(sd, timeo_opt)) {
+            if (opcode == IORING_OP_SENDMSG) {
+                r = sendmsg(sd, &msg, flags);
+            } else {
+                r = recvmsg(sd, &msg, flags);
+            }
+        } else {
+            p_ring = sxs_uring_engine_ring();
+            err = sxs_uring_engine_prep_msgv(p_ring, opcode, sd, p_iov,
+                iovcnt, flags);
+            if (err == SXS_SUCCESS) {
+                err = sxs_uring_engine_wait(p_ring, p_res);
+            }
+            return err;
+        }
+    }
+    if (r == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_res) = r;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_uring_engine_sendv(sxs_socket_t sd,
+    const sxs_iovec_t *p_iov, int iovcnt, int flags, sxs_ssize_t *p_sent) {
+    return sxs_uring_engine_msgv(IORING_OP_SENDMSG, sd, p_iov, iovcnt, flags,
+        p_sent);
+}
+
+sxs_error_t sxs_uring_engine_recvv(sxs_socket_t sd,
+    const sxs_iovec_t *p_iov, int iovcnt, int flags, sxs_ssize_t *p_recvd) {
+    return sxs_uring_engine_msgv(IORING_OP_RECVMSG, sd, p_iov, iovcnt, flags,
+        p_recvd);
+}
+
+#else /* SXS_URING_LINUX */
+
+/* Without io_uring the API exists so that applications link everywhere,
+ * but a ring can never be created and the engine is never enabled. */
+
+sxs_error_t sxs_uring_create(unsigned int entries, sxs_uring_t **pp_ring) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_destroy(sxs_uring_t *p_ring) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_accept(sxs_uring_t *p_ring, sxs_socket_t sd,
+    sxs_sockaddr_t *addr, sxs_socklen_t *addrlen, sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_connect(sxs_uring_t *p_ring, sxs_socket_t sd,
+    const sxs_sockaddr_t *serv_addr, sxs_socklen_t addrlen,
+    sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_send(sxs_uring_t *p_ring, sxs_socket_t sd,
+    const sxs_buf_t buf, sxs_size_t len, int flags, sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_recv(sxs_uring_t *p_ring, sxs_socket_t sd,
+    sxs_buf_t buf, sxs_size_t len, int flags, sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_sendto(sxs_uring_t *p_ring, sxs_socket_t sd,
+    const sxs_buf_t msg, sxs_size_t len, int flags, const sxs_sockaddr_t *to,
+    sxs_socklen_t tolen, sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_recvfrom(sxs_uring_t *p_ring, sxs_socket_t sd,
+    sxs_buf_t buf, sxs_size_t len, int flags, sxs_sockaddr_t *from,
+    sxs_socklen_t *fromlen, sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_register_sockets(sxs_uring_t *p_ring,
+    const sxs_socket_t *p_sds, unsigned int num_sds) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_update_socket(sxs_uring_t *p_ring,
+    unsigned int sock_index, sxs_socket_t sd) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_unregister_sockets(sxs_uring_t *p_ring) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_register_buffers(sxs_uring_t *p_ring,
+    unsigned int num_bufs, sxs_size_t buf_size) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_buf_t sxs_uring_buffer(sxs_uring_t *p_ring, unsigned int buf_index) {
+    return NULL;
+}
+
+sxs_error_t sxs_uring_unregister_buffers(sxs_uring_t *p_ring) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_send_registered(sxs_uring_t *p_ring,
+    unsigned int sock_index, const sxs_buf_t buf, sxs_size_t len, int flags,
+    int buf_index, sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_recv_registered(sxs_uring_t *p_ring,
+    unsigned int sock_index, sxs_buf_t buf, sxs_size_t len, int flags,
+    int buf_index, sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_cancel(sxs_uring_t *p_ring,
+    sxs_uint64_t target_user_data, sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_accept_multishot(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_prep_recv_multishot(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_uring_bufring_t *p_bufring, int flags,
+    sxs_uint64_t user_data) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_bufring_create(sxs_uring_t *p_ring,
+    sxs_uint16_t group_id, unsigned int num_bufs, unsigned int buf_size,
+    sxs_uring_bufring_t **pp_bufring) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_bufring_destroy(sxs_uring_t *p_ring,
+    sxs_uring_bufring_t *p_bufring) {
+    return SXS_EOPNOTSUPP;
+}
+
+void sxs_uring_bufring_recycle(sxs_uring_bufring_t *p_bufring,
+    int buf_id) {
+}
+
+sxs_error_t sxs_uring_submit(sxs_uring_t *p_ring, unsigned int wait_nr,
+    int *p_submitted) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_reap(sxs_uring_t *p_ring, sxs_uring_cqe_t *p_cqes,
+    int max_cqes, int *p_num_reaped) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_engine_init(unsigned int entries) {
+    return SXS_EOPNOTSUPP;
+}
+
+void sxs_uring_engine_uninit(void) {
+}
+
+int sxs_uring_engine_enabled(void) {
+    return 0;
+}
+
+sxs_error_t sxs_uring_engine_send(sxs_socket_t sd, const sxs_buf_t buf,
+    sxs_size_t len, int flags, const sxs_sockaddr_t *to,
+    sxs_socklen_t tolen, sxs_ssize_t *p_sent) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_engine_recv(sxs_socket_t sd, sxs_buf_t buf,
+    sxs_size_t len, int flags, sxs_sockaddr_t *from,
+    sxs_socklen_t *fromlen, sxs_ssize_t *p_recvd) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_engine_sendv(sxs_socket_t sd,
+    const sxs_iovec_t *p_iov, int iovcnt, int flags, sxs_ssize_t *p_sent) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_uring_engine_recvv(sxs_socket_t sd,
+    const sxs_iovec_t *p_iov, int iovcnt, int flags, sxs_ssize_t *p_recvd) {
+    return SXS_EOPNOTSUPP;
+}
+
+#endif /* SXS_URING_LINUX */
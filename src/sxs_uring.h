@@ -0,0 +1,571 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_uring.h
+ * @brief This is a specifications file for the lib_sxs io_uring API.
+ *
+ * The sxs_uring.h file is a specifications file that defines the
+ * functions which compose the completion based (io_uring) API of
+ * lib_sxs. Operations are queued with the sxs_uring_prep_*() functions,
+ * handed to the kernel in batches with sxs_uring_submit() and their
+ * results are collected in batches with sxs_uring_reap(), so that many
+ * operations cost a single system call. The API is only functional on
+ * Linux 5.6 or newer, everywhere else sxs_uring_create() fails with
+ * SXS_EOPNOTSUPP.
+ */
+
+#ifndef SXS_URING_H
+#define SXS_URING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+
+/**
+ * @typedef sxs_uring_t
+ * @brief An opaque io_uring instance.
+ *
+ * The sxs_uring_t type represents a submission queue and a completion
+ * queue shared with the kernel. An sxs_uring_t must only be used by one
+ * thread at a time.
+ */
+typedef struct sxs_uring sxs_uring_t;
+
+/**
+ * @typedef sxs_uring_bufring_t
+ * @brief An opaque provided buffer ring.
+ *
+ * The sxs_uring_bufring_t type represents a group of equally sized
+ * buffers owned by lib_sxs and handed to the kernel, which picks a
+ * buffer from the group for each multishot receive as data arrives.
+ * Buffers are identified by their buffer ID.
+ */
+typedef struct sxs_uring_bufring sxs_uring_bufring_t;
+
+/** The completion carries a buffer from a provided buffer ring. */
+#define SXS_URING_CQE_F_BUFFER 0x1
+/** The operation remains armed and will complete again. */
+#define SXS_URING_CQE_F_MORE 0x2
+
+/**
+ * @typedef sxs_uring_cqe_t
+ * @brief A completed operation.
+ *
+ * The sxs_uring_cqe_t type is a structure describing the result of a
+ * completed operation. The 'user_data' member contains the value given
+ * when the operation was prepared. The 'err' member contains SXS_SUCCESS
+ * or the sxs error code the operation failed with, using the same codes
+ * as the equivalent blocking sxs function. When 'err' is SXS_SUCCESS the
+ * 'res' member contains the number of bytes transferred, or the new
+ * socket descriptor for an accept. The 'flags' member contains OR'd
+ * SXS_URING_CQE_F_* values. When SXS_URING_CQE_F_BUFFER is set the data
+ * was received into the buffer with ID 'buf_id' pointed to by 'p_buf',
+ * which must be handed back with sxs_uring_bufring_recycle() once it
+ * has been consumed. Otherwise 'buf_id' is -1 and 'p_buf' is NULL.
+ */
+typedef struct sxs_uring_cqe {
+    sxs_uint64_t user_data;
+    sxs_error_t err;
+    sxs_ssize_t res;
+    int flags;
+    int buf_id;
+    sxs_buf_t p_buf;
+} sxs_uring_cqe_t;
+
+/**
+ * Create an io_uring instance.
+ *
+ * The sxs_uring_create() function creates a new io_uring instance able
+ * to hold 'entries' queued operations and passes it back via the
+ * 'pp_ring' parameter. The number of operations that may be in flight
+ * at once is twice 'entries'.
+ * @param entries The number of submission queue entries, rounded up to
+ * a power of 2 by the kernel.
+ * @param pp_ring Pointer to ring pointer to store the new ring in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the ring.
+ * @retval SXS_EOPNOTSUPP io_uring, or one of the operations used by
+ * lib_sxs, is not supported by this system.
+ * @retval SXS_EINVAL The 'entries' parameter is invalid.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ * @retval SXS_EMFILE The per-process open file descriptor limit was hit.
+ * @retval SXS_ENFILE The system limit of open file descriptors was hit.
+ * @retval SXS_EPERM io_uring is disabled for this process.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_create(unsigned int entries,
+    sxs_uring_t **pp_ring);
+
+/**
+ * Destroy an io_uring instance.
+ *
+ * The sxs_uring_destroy() function releases all resources associated
+ * with the given ring. Operations still in flight are cancelled by the
+ * kernel, but the buffers they reference must remain valid until the
+ * ring has been destroyed.
+ * @param p_ring Pointer to the ring to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the ring.
+ * @retval SXS_ERRCLOSEFAIL Failed to close the underlying descriptor.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_destroy(sxs_uring_t *p_ring);
+
+/**
+ * Queue an accept operation.
+ *
+ * The sxs_uring_prep_accept() function queues the equivalent of
+ * sxs_accept(). The 'addr' and 'addrlen' parameters must remain valid
+ * until the operation completes. Note that, like all operations queued
+ * on a ring, it waits for a connection even if the socket is in
+ * non-blocking mode.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param sd Listening socket to accept a connection from.
+ * @param addr Pointer to socket address to store peer address, or NULL.
+ * @param addrlen Value-result size of 'addr', or NULL.
+ * @param user_data Value handed back in the completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_accept(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_sockaddr_t *addr, sxs_socklen_t *addrlen,
+    sxs_uint64_t user_data);
+
+/**
+ * Queue a connect operation.
+ *
+ * The sxs_uring_prep_connect() function queues the equivalent of
+ * sxs_connect(). The 'serv_addr' parameter must remain valid until the
+ * operation completes.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param sd Socket descriptor to connect.
+ * @param serv_addr Address representing remote server to conn to.
+ * @param addrlen The len in bytes of the address structure.
+ * @param user_data Value handed back in the completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_connect(sxs_uring_t *p_ring,
+    sxs_socket_t sd, const sxs_sockaddr_t *serv_addr,
+    sxs_socklen_t addrlen, sxs_uint64_t user_data);
+
+/**
+ * Queue a send operation.
+ *
+ * The sxs_uring_prep_send() function queues the equivalent of
+ * sxs_send(). The buffer must remain valid until the operation
+ * completes.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param sd The socket descriptor to send on.
+ * @param buf The pointer to the buffer containing data to send.
+ * @param len The number of bytes to attempt to send.
+ * @param flags One or more OR'd message flags, generally 0.
+ * @param user_data Value handed back in the completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_send(sxs_uring_t *p_ring,
+    sxs_socket_t sd, const sxs_buf_t buf, sxs_size_t len, int flags,
+    sxs_uint64_t user_data);
+
+/**
+ * Queue a receive operation.
+ *
+ * The sxs_uring_prep_recv() function queues the equivalent of
+ * sxs_recv(). The buffer must remain valid until the operation
+ * completes. A result of 0 bytes means the peer closed the connection.
+ * To fail with SXS_EWOULDBLOCK rather than wait for data include
+ * MSG_DONTWAIT in 'flags'.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param sd The socket descriptor to receive on.
+ * @param buf The pointer to the buffer to store received data in.
+ * @param len The maximum number of bytes to receive.
+ * @param flags One or more OR'd message flags, generally 0.
+ * @param user_data Value handed back in the completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_recv(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_buf_t buf, sxs_size_t len, int flags,
+    sxs_uint64_t user_data);
+
+/**
+ * Queue a sendto operation.
+ *
+ * The sxs_uring_prep_sendto() function queues the equivalent of
+ * sxs_sendto(). The message and the 'to' address must remain valid
+ * until the operation completes.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param sd The socket descriptor to send on.
+ * @param msg The pointer to the message to send.
+ * @param len The size of the message to send in bytes.
+ * @param flags One or more OR'd message flags, generally 0.
+ * @param to The address to send the message to, or NULL.
+ * @param tolen The size of the address structure.
+ * @param user_data Value handed back in the completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_sendto(sxs_uring_t *p_ring,
+    sxs_socket_t sd, const sxs_buf_t msg, sxs_size_t len, int flags,
+    const sxs_sockaddr_t *to, sxs_socklen_t tolen, sxs_uint64_t user_data);
+
+/**
+ * Queue a recvfrom operation.
+ *
+ * The sxs_uring_prep_recvfrom() function queues the equivalent of
+ * sxs_recvfrom(). The buffer, 'from' and 'fromlen' must remain valid
+ * until the operation completes, at which point 'fromlen' is updated.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param sd The socket descriptor to receive on.
+ * @param buf The pointer to buffer to store received message in.
+ * @param len The size of the buffer in bytes.
+ * @param flags One or more OR'd message flags, generally 0.
+ * @param from Pointer to address variable to store senders address in,
+ * or NULL.
+ * @param fromlen Value-result size of 'from', or NULL.
+ * @param user_data Value handed back in the completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_recvfrom(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_buf_t buf, sxs_size_t len, int flags,
+    sxs_sockaddr_t *from, sxs_socklen_t *fromlen, sxs_uint64_t user_data);
+
+/**
+ * Register sockets with a ring.
+ *
+ * The sxs_uring_register_sockets() function registers the 'num_sds'
+ * sockets in 'p_sds' with the ring, so that operations prepared with
+ * the *_registered() functions refer to them by index and the kernel
+ * skips the descriptor lookup and reference counting on every
+ * operation. If 'p_sds' is NULL, 'num_sds' empty slots are reserved to
+ * be filled with sxs_uring_update_socket(). A socket remains registered
+ * until it is replaced or the sockets are unregistered, even if it has
+ * been closed.
+ * @param p_ring Pointer to the ring to register the sockets with.
+ * @param p_sds Pointer to the array of sockets to register, or NULL.
+ * @param num_sds The number of sockets or slots to register.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully registered the sockets.
+ * @retval SXS_EBUSY Sockets are already registered with the ring.
+ * @retval SXS_EBADF One of the socket descriptors is invalid.
+ * @retval SXS_EINVAL The 'num_sds' parameter is invalid.
+ * @retval SXS_EMFILE The 'num_sds' parameter exceeds the open file limit.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_register_sockets(sxs_uring_t *p_ring,
+    const sxs_socket_t *p_sds, unsigned int num_sds);
+
+/**
+ * Replace a registered socket.
+ *
+ * The sxs_uring_update_socket() function replaces the socket registered
+ * at 'sock_index' with 'sd'. If 'sd' is SXS_INVALID_SOCKET the slot is
+ * emptied.
+ * @param p_ring Pointer to the ring the sockets are registered with.
+ * @param sock_index The index of the slot to update.
+ * @param sd The socket descriptor to store in the slot.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully updated the slot.
+ * @retval SXS_EINVAL The 'sock_index' is out of range.
+ * @retval SXS_EBADF The socket descriptor is invalid.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_update_socket(sxs_uring_t *p_ring,
+    unsigned int sock_index, sxs_socket_t sd);
+
+/**
+ * Unregister the sockets of a ring.
+ *
+ * The sxs_uring_unregister_sockets() function unregisters all sockets
+ * registered with the ring. The sockets themselves are not closed.
+ * @param p_ring Pointer to the ring the sockets are registered with.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully unregistered the sockets.
+ * @retval SXS_ENOENT No sockets are registered.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_unregister_sockets(sxs_uring_t *p_ring);
+
+/**
+ * Register a pool of I/O buffers with a ring.
+ *
+ * The sxs_uring_register_buffers() function allocates 'num_bufs'
+ * buffers of 'buf_size' bytes each and registers them with the ring, so
+ * the kernel pins their pages once instead of on every operation. The
+ * buffers are obtained with sxs_uring_buffer() and used by passing
+ * their index to the *_registered() functions. They are freed when
+ * unregistered or when the ring is destroyed.
+ * @param p_ring Pointer to the ring to register the buffers with.
+ * @param num_bufs The number of buffers, at most 16384.
+ * @param buf_size The size of each buffer in bytes, at most 1GB.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully registered the buffers.
+ * @retval SXS_EBUSY Buffers are already registered with the ring.
+ * @retval SXS_EINVAL The 'num_bufs' or 'buf_size' parameter is invalid.
+ * @retval SXS_ENOMEM Insufficient memory is available, or the locked
+ * memory limit (RLIMIT_MEMLOCK) was hit.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_register_buffers(sxs_uring_t *p_ring,
+    unsigned int num_bufs, sxs_size_t buf_size);
+
+/**
+ * Get a registered buffer.
+ *
+ * The sxs_uring_buffer() function returns a pointer to the registered
+ * buffer at 'buf_index'.
+ * @param p_ring Pointer to the ring the buffers are registered with.
+ * @param buf_index The index of the buffer.
+ * @return A pointer to the buffer, or NULL if 'buf_index' is out of
+ * range.
+ */
+SXS_EXPORT sxs_buf_t sxs_uring_buffer(sxs_uring_t *p_ring,
+    unsigned int buf_index);
+
+/**
+ * Unregister the I/O buffers of a ring.
+ *
+ * The sxs_uring_unregister_buffers() function unregisters and frees the
+ * buffers registered with sxs_uring_register_buffers(). No operation
+ * using them may be in flight.
+ * @param p_ring Pointer to the ring the buffers are registered with.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully unregistered the buffers.
+ * @retval SXS_ENOENT No buffers are registered.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_unregister_buffers(sxs_uring_t *p_ring);
+
+/**
+ * Queue a send operation on a registered socket.
+ *
+ * The sxs_uring_prep_send_registered() function queues the equivalent
+ * of sxs_send() on the socket registered at 'sock_index'. If 'buf_index'
+ * is not negative, 'buf' and 'len' must lie within the registered buffer
+ * at that index, and 'flags' must be 0.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param sock_index The index of the registered socket to send on.
+ * @param buf The pointer to the buffer containing data to send.
+ * @param len The number of bytes to attempt to send.
+ * @param flags One or more OR'd message flags, generally 0.
+ * @param buf_index The index of the registered buffer 'buf' lies in, or
+ * -1 if it is not a registered buffer.
+ * @param user_data Value handed back in the completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_EINVAL An index is out of range, or 'buf' does not lie in
+ * the registered buffer.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_send_registered(sxs_uring_t *p_ring,
+    unsigned int sock_index, const sxs_buf_t buf, sxs_size_t len, int flags,
+    int buf_index, sxs_uint64_t user_data);
+
+/**
+ * Queue a receive operation on a registered socket.
+ *
+ * The sxs_uring_prep_recv_registered() function queues the equivalent
+ * of sxs_recv() on the socket registered at 'sock_index'. If 'buf_index'
+ * is not negative, 'buf' and 'len' must lie within the registered buffer
+ * at that index, and 'flags' must be 0.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param sock_index The index of the registered socket to receive on.
+ * @param buf The pointer to the buffer to store received data in.
+ * @param len The maximum number of bytes to receive.
+ * @param flags One or more OR'd message flags, generally 0.
+ * @param buf_index The index of the registered buffer 'buf' lies in, or
+ * -1 if it is not a registered buffer.
+ * @param user_data Value handed back in the completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_EINVAL An index is out of range, or 'buf' does not lie in
+ * the registered buffer.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_recv_registered(sxs_uring_t *p_ring,
+    unsigned int sock_index, sxs_buf_t buf, sxs_size_t len, int flags,
+    int buf_index, sxs_uint64_t user_data);
+
+/**
+ * Queue a cancellation.
+ *
+ * The sxs_uring_prep_cancel() function queues the cancellation of the
+ * operation in flight which was prepared with 'target_user_data'. It is
+ * mostly used to disarm multishot operations. The cancelled operation
+ * completes with SXS_ECANCELED, and the cancellation itself completes
+ * with 'user_data'.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param target_user_data The user data of the operation to cancel.
+ * @param user_data Value handed back in the completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_ENOENT No operation with 'target_user_data' is in flight.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_cancel(sxs_uring_t *p_ring,
+    sxs_uint64_t target_user_data, sxs_uint64_t user_data);
+
+/**
+ * Queue a multishot accept operation.
+ *
+ * The sxs_uring_prep_accept_multishot() function queues an accept which
+ * stays armed and completes once for every accepted connection, each
+ * completion carrying the new socket descriptor in 'res' and the
+ * SXS_URING_CQE_F_MORE flag. A completion without SXS_URING_CQE_F_MORE
+ * means the operation has terminated, for example because the
+ * completion queue overflowed, and it must be prepared again to keep
+ * accepting. Requires Linux 5.19 or newer.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param sd Listening socket to accept connections from.
+ * @param user_data Value handed back in every completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ * @retval SXS_EOPNOTSUPP Multishot operations are not supported.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_accept_multishot(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_uint64_t user_data);
+
+/**
+ * Queue a multishot receive operation.
+ *
+ * The sxs_uring_prep_recv_multishot() function queues a receive which
+ * stays armed and completes every time data arrives on the socket. No
+ * memory is committed to the socket while it is idle, the kernel picks
+ * a buffer from 'p_bufring' as data arrives and reports its ID in the
+ * completion. A completion without SXS_URING_CQE_F_MORE means the
+ * operation has terminated. This happens on end of file (a 'res' of 0),
+ * on errors and with SXS_ENOBUFS when the buffer ring ran dry, in which
+ * case buffers must be recycled and the operation prepared again.
+ * Requires Linux 6.0 or newer.
+ * @param p_ring Pointer to the ring to queue the operation on.
+ * @param sd The socket descriptor to receive on.
+ * @param p_bufring The buffer ring to take receive buffers from.
+ * @param flags One or more OR'd message flags, generally 0.
+ * @param user_data Value handed back in every completion.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully queued the operation.
+ * @retval SXS_EBUSY Too many operations are in flight.
+ * @retval SXS_EOPNOTSUPP Multishot operations are not supported.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_prep_recv_multishot(sxs_uring_t *p_ring,
+    sxs_socket_t sd, sxs_uring_bufring_t *p_bufring, int flags,
+    sxs_uint64_t user_data);
+
+/**
+ * Create a provided buffer ring.
+ *
+ * The sxs_uring_bufring_create() function allocates 'num_bufs' buffers
+ * of 'buf_size' bytes each, registers them with the ring as buffer group
+ * 'group_id' and passes the buffer ring back via 'pp_bufring'. All
+ * buffers start out owned by the kernel. Buffer IDs range from 0 to
+ * 'num_bufs' - 1.
+ * @param p_ring Pointer to the ring to register the buffers with.
+ * @param group_id The buffer group ID, unique within the ring.
+ * @param num_bufs The number of buffers, a power of 2 up to 32768.
+ * @param buf_size The size of each buffer in bytes.
+ * @param pp_bufring Pointer to buffer ring pointer to store the new
+ * buffer ring in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the buffer ring.
+ * @retval SXS_EINVAL The 'num_bufs' or 'buf_size' parameter is invalid.
+ * @retval SXS_EEXIST The 'group_id' is already in use on the ring.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ * @retval SXS_EOPNOTSUPP Provided buffer rings are not supported.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_bufring_create(sxs_uring_t *p_ring,
+    sxs_uint16_t group_id, unsigned int num_bufs, unsigned int buf_size,
+    sxs_uring_bufring_t **pp_bufring);
+
+/**
+ * Destroy a provided buffer ring.
+ *
+ * The sxs_uring_bufring_destroy() function unregisters the buffer ring
+ * from the ring and frees its buffers. No operation using the buffer
+ * ring may be in flight.
+ * @param p_ring Pointer to the ring the buffers are registered with.
+ * @param p_bufring Pointer to the buffer ring to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the buffer ring.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_bufring_destroy(sxs_uring_t *p_ring,
+    sxs_uring_bufring_t *p_bufring);
+
+/**
+ * Hand a buffer back to the kernel.
+ *
+ * The sxs_uring_bufring_recycle() function returns the buffer with the
+ * given ID to the buffer ring once the application has consumed the
+ * data received into it, making it available to later receives.
+ * @param p_bufring Pointer to the buffer ring the buffer belongs to.
+ * @param buf_id The ID of the buffer, as reported in the completion.
+ */
+SXS_EXPORT void sxs_uring_bufring_recycle(sxs_uring_bufring_t *p_bufring,
+    int buf_id);
+
+/**
+ * Submit queued operations and optionally wait for completions.
+ *
+ * The sxs_uring_submit() function hands all queued operations to the
+ * kernel and waits until at least 'wait_nr' operations have completed,
+ * all with a single system call. If 'wait_nr' is 0 it does not wait.
+ * @param p_ring Pointer to the ring to submit.
+ * @param wait_nr The number of completions to wait for.
+ * @param p_submitted Pointer to var to store the number of submitted
+ * operations in, may be NULL.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully submitted the operations.
+ * @retval SXS_EINTR A signal was caught while waiting, the operations
+ * were submitted.
+ * @retval SXS_EBUSY The completion queue is full, completions must be
+ * reaped before more operations can be submitted.
+ * @retval SXS_EWOULDBLOCK The kernel is temporarily out of resources.
+ * @retval SXS_UNKNOWN_ERROR An unkwon error has occured.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_submit(sxs_uring_t *p_ring,
+    unsigned int wait_nr, int *p_submitted);
+
+/**
+ * Collect completed operations.
+ *
+ * The sxs_uring_reap() function copies up to 'max_cqes' completed
+ * operations into the 'p_cqes' array without making a system call and
+ * passes back the number copied via 'p_num_reaped'.
+ * @param p_ring Pointer to the ring to collect completions from.
+ * @param p_cqes Pointer to the array to store the completions in.
+ * @param max_cqes The number of elements in the 'p_cqes' array.
+ * @param p_num_reaped Pointer to var to store number of completions in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully collected the completions.
+ */
+SXS_EXPORT sxs_error_t sxs_uring_reap(sxs_uring_t *p_ring,
+    sxs_uring_cqe_t *p_cqes, int max_cqes, int *p_num_reaped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_URING_H */
@@ -0,0 +1,305 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_uring_bench.c
+ * @brief This is a benchmark of the lib_sxs io_uring send path.
+ *
+ * The sxs_uring_bench.c file is a small program, not installed, which
+ * times sending messages over a socket pair with sxs_send(), with
+ * batches of sxs_uring sends, and with batches of sxs_uring sends on a
+ * registered socket from registered buffers. A thread drains the other
+ * end of the pair with sxs_recv(). It is run as:
+ *
+ *   sxs_uring_bench [messages [message size [batch size]]]
+ */
+
+#include "sxs.h"
+#include "sxs_uring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WIN32
+    #include <sys/socket.h>
+    #include <sys/time.h>
+    #include <pthread.h>
+#endif
+
+#define SXS_BENCH_MESSAGES 1000000
+#define SXS_BENCH_MSG_SIZE 64
+#define SXS_BENCH_BATCH 32
+
+#ifndef WIN32
+
+typedef struct sxs_bench {
+    unsigned long messages;
+    sxs_size_t msg_size;
+    unsigned int batch;
+    char *p_msg;
+} sxs_bench_t;
+
+static sxs_uint64_t sxs_bench_now_ms(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return ((sxs_uint64_t)tv.tv_sec * 1000) +
+        ((sxs_uint64_t)tv.tv_usec / 1000);
+}
+
+/* Drain a socket until the peer shuts its end down. */
+static void *sxs_bench_drain(void *p_arg) {
+    sxs_socket_t sd;
+    char buf[65536];
+    sxs_ssize_t bytes_recvd;
+
+    sd = *(sxs_socket_t *)p_arg;
+    while (1) {
+        if ((sxs_recv(sd, buf, sizeof(buf), 0, &bytes_recvd) !=
+            SXS_SUCCESS) || (bytes_recvd == 0)) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static sxs_error_t sxs_bench_send(const sxs_bench_t *p_bench,
+    sxs_socket_t sd, sxs_uring_t *p_ring) {
+
+    unsigned long i;
+    sxs_error_t err;
+
+    for (i = 0; i < p_bench->messages; i++) {
+        err = sxs_send_nbytes(sd, p_bench->p_msg, p_bench->msg_size);
+        if (err != SXS_SUCCESS) {
+            return err;
+        }
+    }
+
+    return SXS_SUCCESS;
+}
+
+/* Send the messages in batches, each batch costing one system call. A
+ * short send is not resent, the peer only counts bytes. With
+ * 'registered' set the socket and the buffer are the ones registered
+ * with the ring at index 0. */
+static sxs_error_t sxs_bench_uring(const sxs_bench_t *p_bench,
+    sxs_socket_t sd, sxs_uring_t *p_ring, int registered) {
+
+    sxs_uring_cqe_t cqes[SXS_BENCH_BATCH];
+    unsigned long sent;
+    unsigned int n, i;
+    int num_reaped;
+    int got;
+    sxs_buf_t buf;
+    sxs_error_t err;
+
+    buf = registered ? sxs_uring_buffer(p_ring, 0) : p_bench->p_msg;
+
+    for (sent = 0; sent < p_bench->messages; sent += n) {
+        n = p_bench->batch;
+        if ((p_bench->messages - sent) < n) {
+            n = (unsigned int)(p_bench->messages - sent);
+        }
+
+        for (i = 0; i < n; i++) {
+            if (registered) {
+                err = sxs_uring_prep_send_registered(p_ring, 0, buf,
+                    p_bench->msg_size, 0, 0, i);
+            } else {
+                err = sxs_uring_prep_send(p_ring, sd, buf,
+                    p_bench->msg_size, 0, i);
+            }
+            if (err != SXS_SUCCESS) {
+                return err;
+            }
+        }
+
+        err = sxs_uring_submit(p_ring, n, NULL);
+        if (err != SXS_SUCCESS) {
+            return err;
+        }
+        for (got = 0; got < (int)n; got += num_reaped) {
+            sxs_uring_reap(p_ring, cqes, (n - got), &num_reaped);
+            if (num_reaped == 0) {
+                err = sxs_uring_submit(p_ring, (n - got), NULL);
+                if ((err != SXS_SUCCESS) && (err != SXS_EINTR)) {
+                    return err;
+                }
+                continue;
+            }
+            for (i = 0; i < (unsigned int)num_reaped; i++) {
+                if (cqes[i].err != SXS_SUCCESS) {
+                    return cqes[i].err;
+                }
+            }
+        }
+    }
+
+    return SXS_SUCCESS;
+}
+
+static sxs_error_t sxs_bench_uring_plain(const sxs_bench_t *p_bench,
+    sxs_socket_t sd, sxs_uring_t *p_ring) {
+    return sxs_bench_uring(p_bench, sd, p_ring, 0);
+}
+
+static sxs_error_t sxs_bench_uring_registered(const sxs_bench_t *p_bench,
+    sxs_socket_t sd, sxs_uring_t *p_ring) {
+
+    sxs_error_t err;
+
+    err = sxs_uring_register_sockets(p_ring, &sd, 1);
+    if (err != SXS_SUCCESS) {
+        return err;
+    }
+    err = sxs_uring_register_buffers(p_ring, 1, p_bench->msg_size);
+    if (err != SXS_SUCCESS) {
+        sxs_uring_unregister_sockets(p_ring);
+        return err;
+    }
+    memcpy(sxs_uring_buffer(p_ring, 0), p_bench->p_msg, p_bench->msg_size);
+
+    err = sxs_bench_uring(p_bench, sd, p_ring, 1);
+
+    sxs_uring_unregister_buffers(p_ring);
+    sxs_uring_unregister_sockets(p_ring);
+
+    return err;
+}
+
+/* Time one way of sending over a fresh socket pair, including the time
+ * the peer takes to drain it. */
+static void sxs_bench_run(const sxs_bench_t *p_bench, const char *p_name,
+    sxs_error_t (*p_send)(const sxs_bench_t *, sxs_socket_t, sxs_uring_t *),
+    int use_ring) {
+
+    sxs_socket_t sds[2];
+    sxs_uring_t *p_ring;
+    pthread_t drainer;
+    sxs_uint64_t start, elapsed;
+    sxs_error_t err;
+
+    p_ring = NULL;
+    if (use_ring) {
+        err = sxs_uring_create((p_bench->batch * 2), &p_ring);
+        if (err != SXS_SUCCESS) {
+            sxs_perror(p_name, err);
+            return;
+        }
+    }
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sds) == -1) {
+        perror("socketpair");
+        if (p_ring != NULL) {
+            sxs_uring_destroy(p_ring);
+        }
+        return;
+    }
+    if (pthread_create(&drainer, NULL, sxs_bench_drain, &sds[1]) != 0) {
+        fprintf(stderr, "%s: failed to start the receiving thread\n",
+            p_name);
+        sxs_close(sds[0]);
+        sxs_close(sds[1]);
+        if (p_ring != NULL) {
+            sxs_uring_destroy(p_ring);
+        }
+        return;
+    }
+
+    start = sxs_bench_now_ms();
+    err = p_send(p_bench, sds[0], p_ring);
+    sxs_shutdown(sds[0], SXS_SHUT_WR);
+    pthread_join(drainer, NULL);
+    elapsed = sxs_bench_now_ms() - start;
+
+    if (err != SXS_SUCCESS) {
+        sxs_perror(p_name, err);
+    } else {
+        if (elapsed == 0) {
+            elapsed = 1;
+        }
+        printf("%-24s %10lu ms %10.1f ns/msg %12.0f msg/s\n", p_name,
+            (unsigned long)elapsed,
+            ((double)elapsed * 1000000.0) / p_bench->messages,
+            ((double)p_bench->messages * 1000.0) / elapsed);
+    }
+
+    sxs_close(sds[0]);
+    sxs_close(sds[1]);
+    if (p_ring != NULL) {
+        sxs_uring_destroy(p_ring);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    sxs_bench_t bench;
+
+    bench.messages = SXS_BENCH_MESSAGES;
+    bench.msg_size = SXS_BENCH_MSG_SIZE;
+    bench.batch = SXS_BENCH_BATCH;
+    if (argc > 1) {
+        bench.messages = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        bench.msg_size = strtoul(argv[2], NULL, 10);
+    }
+    if (argc > 3) {
+        bench.batch = (unsigned int)strtoul(argv[3], NULL, 10);
+    }
+    if ((bench.messages == 0) || (bench.msg_size == 0) ||
+        (bench.batch == 0) || (bench.batch > SXS_BENCH_BATCH)) {
+        fprintf(stderr, "usage: %s [messages [message size [batch size, "
+            "at most %d]]]\n", argv[0], SXS_BENCH_BATCH);
+        return 1;
+    }
+
+    bench.p_msg = (char *)malloc(bench.msg_size);
+    if (bench.p_msg == NULL) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        return 1;
+    }
+    memset(bench.p_msg, 'x', bench.msg_size);
+
+    if (sxs_init() != SXS_SUCCESS) {
+        fprintf(stderr, "%s: failed to initialize lib_sxs\n", argv[0]);
+        free(bench.p_msg);
+        return 1;
+    }
+
+    printf("%lu messages of %lu bytes, io_uring batches of %u\n",
+        bench.messages, (unsigned long)bench.msg_size, bench.batch);
+    sxs_bench_run(&bench, "sxs_send", sxs_bench_send, 0);
+    sxs_bench_run(&bench, "sxs_uring", sxs_bench_uring_plain, 1);
+    sxs_bench_run(&bench, "sxs_uring registered", sxs_bench_uring_registered,
+        1);
+
+    sxs_uninit();
+    free(bench.p_msg);
+
+    return 0;
+}
+
+#else /* WIN32 */
+
+int main(int argc, char *argv[]) {
+    fprintf(stderr, "%s: io_uring is not available on this system\n",
+        argv[0]);
+
+    return 1;
+}
+
+#endif /* WIN32 */
@@ -0,0 +1,293 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_wbuf.c
+ * @brief This is an implementation file for the lib_sxs write buffer
+ * API.
+ *
+ * The sxs_wbuf.c file is an implementation file which contains all the
+ * definitions for the functions which compose the write buffer API of
+ * lib_sxs.
+ */
+
+#include "sxs_wbuf.h"
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+#ifdef MSG_DONTWAIT
+    #define SXS_WBUF_DONTWAIT MSG_DONTWAIT
+#else
+    #define SXS_WBUF_DONTWAIT 0
+#endif
+
+struct sxs_wbuf {
+    sxs_socket_t sd;
+    sxs_mem_t mem;
+    char *p_data;
+    sxs_size_t size;
+    sxs_size_t start;   /* offset of the first unsent byte */
+    sxs_size_t end;     /* offset just past the last written byte */
+    sxs_loop_t *p_loop;
+    sxs_loop_defer_t defer;
+    sxs_wbuf_cb_t cb;
+    void *p_cb_data;
+};
+
+/* Move the unsent data to the front of the buffer. */
+static void sxs_wbuf_compact(sxs_wbuf_t *p_wbuf) {
+    if (p_wbuf->start > 0) {
+        memmove(p_wbuf->p_data, (p_wbuf->p_data + p_wbuf->start),
+            (p_wbuf->end - p_wbuf->start));
+        p_wbuf->end = p_wbuf->end - p_wbuf->start;
+        p_wbuf->start = 0;
+    }
+}
+
+/* Copy data into the free space of the buffer if it fits, compacting
+ * the buffer first if that makes it fit. */
+static int sxs_wbuf_append(sxs_wbuf_t *p_wbuf, const char *p_src,
+    sxs_size_t len) {
+
+    if (len > (p_wbuf->size - p_wbuf->end)) {
+        if (len > (p_wbuf->size - (p_wbuf->end - p_wbuf->start))) {
+            return 0;
+        }
+        sxs_wbuf_compact(p_wbuf);
+    }
+
+    memcpy((p_wbuf->p_data + p_wbuf->end), p_src, len);
+    p_wbuf->end = p_wbuf->end + len;
+
+    return 1;
+}
+
+/* Have the loop the buffer is attached to flush it at the end of the
+ * current iteration. */
+static void sxs_wbuf_schedule(sxs_wbuf_t *p_wbuf) {
+    if ((p_wbuf->p_loop != NULL) && (p_wbuf->end > p_wbuf->start)) {
+        sxs_loop_defer(p_wbuf->p_loop, &p_wbuf->defer);
+    }
+}
+
+static void sxs_wbuf_deferred_flush(sxs_loop_t *p_loop, void *p_data) {
+    sxs_wbuf_t *p_wbuf;
+    sxs_error_t reterr;
+
+    p_wbuf = (sxs_wbuf_t *)p_data;
+
+    reterr = sxs_wbuf_flush_nb(p_wbuf);
+    if ((reterr != SXS_SUCCESS) && (p_wbuf->cb != NULL)) {
+        p_wbuf->cb(p_wbuf, reterr, p_wbuf->p_cb_data);
+    }
+}
+
+sxs_error_t sxs_wbuf_create(sxs_socket_t sd, sxs_size_t size,
+    sxs_wbuf_t **pp_wbuf) {
+
+    sxs_wbuf_t *p_wbuf;
+
+    if (size == 0) {
+        size = SXS_WBUF_DEFAULT_SIZE;
+    }
+
+    p_wbuf = (sxs_wbuf_t *)malloc(sizeof(sxs_wbuf_t));
+    if (p_wbuf == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    if (sxs_mem_alloc(size, &p_wbuf->mem) != SXS_SUCCESS) {
+        free(p_wbuf);
+        return SXS_ENOMEM;
+    }
+
+    p_wbuf->sd = sd;
+    p_wbuf->p_data = p_wbuf->mem.p_data;
+    p_wbuf->size = size;
+    p_wbuf->start = 0;
+    p_wbuf->end = 0;
+    p_wbuf->p_loop = NULL;
+    p_wbuf->cb = NULL;
+    p_wbuf->p_cb_data = NULL;
+    sxs_loop_defer_init(&p_wbuf->defer, sxs_wbuf_deferred_flush, p_wbuf);
+
+    (*pp_wbuf) = p_wbuf;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_wbuf_destroy(sxs_wbuf_t *p_wbuf) {
+    sxs_loop_defer_cancel(&p_wbuf->defer);
+    sxs_mem_free(&p_wbuf->mem);
+    free(p_wbuf);
+
+    return SXS_SUCCESS;
+}
+
+void sxs_wbuf_attach(sxs_wbuf_t *p_wbuf, sxs_loop_t *p_loop,
+    sxs_wbuf_cb_t cb, void *p_data) {
+
+    sxs_loop_defer_cancel(&p_wbuf->defer);
+
+    p_wbuf->p_loop = p_loop;
+    p_wbuf->cb = cb;
+    p_wbuf->p_cb_data = p_data;
+
+    sxs_wbuf_schedule(p_wbuf);
+}
+
+sxs_size_t sxs_wbuf_pending(const sxs_wbuf_t *p_wbuf) {
+    return (p_wbuf->end - p_wbuf->start);
+}
+
+sxs_error_t sxs_wbuf_write(sxs_wbuf_t *p_wbuf, const sxs_buf_t buf,
+    sxs_size_t len) {
+
+    sxs_iovec_t iov[2];
+    sxs_error_t reterr;
+    int iovcnt;
+
+    if (sxs_wbuf_append(p_wbuf, (const char *)buf, len)) {
+        sxs_wbuf_schedule(p_wbuf);
+        return SXS_SUCCESS;
+    }
+
+    iovcnt = 0;
+    if (p_wbuf->end > p_wbuf->start) {
+        SXS_IOV_BASE(iov[iovcnt]) = p_wbuf->p_data + p_wbuf->start;
+        SXS_IOV_LEN(iov[iovcnt]) = p_wbuf->end - p_wbuf->start;
+        iovcnt++;
+    }
+    SXS_IOV_BASE(iov[iovcnt]) = (char *)buf;
+    SXS_IOV_LEN(iov[iovcnt]) = len;
+    iovcnt++;
+
+    reterr = sxs_sendv_nbytes(p_wbuf->sd, iov, iovcnt);
+    if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    p_wbuf->start = 0;
+    p_wbuf->end = 0;
+    sxs_loop_defer_cancel(&p_wbuf->defer);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_wbuf_write_nb(sxs_wbuf_t *p_wbuf, const sxs_buf_t buf,
+    sxs_size_t len, sxs_size_t *p_written) {
+
+    sxs_iovec_t iov[2];
+    sxs_error_t reterr;
+    sxs_ssize_t sent;
+    sxs_size_t pending;
+    sxs_size_t taken;
+    sxs_size_t room;
+    int iovcnt;
+
+    if (sxs_wbuf_append(p_wbuf, (const char *)buf, len)) {
+        sxs_wbuf_schedule(p_wbuf);
+        (*p_written) = len;
+        return SXS_SUCCESS;
+    }
+
+    /* Send the buffered data and the new data together, then buffer
+     * what the socket did not take, as far as it fits. */
+    pending = p_wbuf->end - p_wbuf->start;
+    iovcnt = 0;
+    if (pending > 0) {
+        SXS_IOV_BASE(iov[iovcnt]) = p_wbuf->p_data + p_wbuf->start;
+        SXS_IOV_LEN(iov[iovcnt]) = pending;
+        iovcnt++;
+    }
+    SXS_IOV_BASE(iov[iovcnt]) = (char *)buf;
+    SXS_IOV_LEN(iov[iovcnt]) = len;
+    iovcnt++;
+
+    reterr = sxs_sendv(p_wbuf->sd, iov, iovcnt, SXS_WBUF_DONTWAIT, &sent);
+    if (reterr == SXS_EWOULDBLOCK) {
+        sent = 0;
+    } else if (reterr != SXS_SUCCESS) {
+        return reterr;
+    }
+
+    if ((sxs_size_t)sent >= pending) {
+        taken = sent - pending;
+        p_wbuf->start = 0;
+        p_wbuf->end = 0;
+    } else {
+        taken = 0;
+        p_wbuf->start = p_wbuf->start + sent;
+        sxs_wbuf_compact(p_wbuf);
+    }
+
+    room = p_wbuf->size - p_wbuf->end;
+    if (room > (len - taken)) {
+        room = len - taken;
+    }
+    memcpy((p_wbuf->p_data + p_wbuf->end), ((const char *)buf + taken),
+        room);
+    p_wbuf->end = p_wbuf->end + room;
+    taken = taken + room;
+
+    if (p_wbuf->end > p_wbuf->start) {
+        sxs_wbuf_schedule(p_wbuf);
+    } else {
+        sxs_loop_defer_cancel(&p_wbuf->defer);
+    }
+
+    (*p_written) = taken;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_wbuf_flush(sxs_wbuf_t *p_wbuf) {
+    sxs_error_t reterr;
+
+    if (p_wbuf->end > p_wbuf->start) {
+        reterr = sxs_send_nbytes(p_wbuf->sd,
+            (sxs_buf_t)(p_wbuf->p_data + p_wbuf->start),
+            (p_wbuf->end - p_wbuf->start));
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        }
+    }
+
+    p_wbuf->start = 0;
+    p_wbuf->end = 0;
+    sxs_loop_defer_cancel(&p_wbuf->defer);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_wbuf_flush_nb(sxs_wbuf_t *p_wbuf) {
+    sxs_error_t reterr;
+    sxs_ssize_t sent;
+
+    while (p_wbuf->end > p_wbuf->start) {
+        reterr = sxs_send(p_wbuf->sd,
+            (sxs_buf_t)(p_wbuf->p_data + p_wbuf->start),
+            (p_wbuf->end - p_wbuf->start), SXS_WBUF_DONTWAIT, &sent);
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        }
+        p_wbuf->start = p_wbuf->start + sent;
+    }
+
+    p_wbuf->start = 0;
+    p_wbuf->end = 0;
+    sxs_loop_defer_cancel(&p_wbuf->defer);
+
+    return SXS_SUCCESS;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_wbuf.h
+ * @brief This is a specifications file for the lib_sxs write buffer API.
+ *
+ * The sxs_wbuf.h file is a specifications file that defines the
+ * functions which compose the write buffer API of lib_sxs. A write
+ * buffer gathers the small writes of an application and sends them
+ * together, so that a response assembled from many pieces costs one
+ * system call and leaves in as few TCP segments as possible. The
+ * buffered data is sent when the buffer overflows, when the buffer is
+ * flushed explicitly, or, once the buffer is attached to an event loop,
+ * at the end of the loop iteration it was written in.
+ *
+ * The blocking functions behave like sxs_send_nbytes(). The functions
+ * suffixed with _nb never wait; they send what the socket accepts and
+ * keep the rest buffered, so they are meant for sockets driven by an
+ * event loop. They pass MSG_DONTWAIT where it is available; elsewhere,
+ * e.g. on Windows, the socket must be in non-blocking I/O mode.
+ */
+
+#ifndef SXS_WBUF_H
+#define SXS_WBUF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+#include "sxs_loop.h"
+
+/**
+ * @def SXS_WBUF_DEFAULT_SIZE
+ * @brief The size of a write buffer created with a size of 0.
+ */
+#define SXS_WBUF_DEFAULT_SIZE 16384
+
+/**
+ * @typedef sxs_wbuf_t
+ * @brief An opaque write buffer of a socket.
+ *
+ * The sxs_wbuf_t type represents a buffer of data written by the
+ * application but not yet sent on a socket.
+ */
+typedef struct sxs_wbuf sxs_wbuf_t;
+
+/**
+ * @typedef sxs_wbuf_cb_t
+ * @brief A write buffer flush callback.
+ *
+ * The sxs_wbuf_cb_t type is the type of the callback called when the
+ * flush of an attached write buffer at the end of a loop iteration did
+ * not send everything. The callback is passed the write buffer, the
+ * error of sxs_wbuf_flush_nb(), which is SXS_EWOULDBLOCK when the socket
+ * could not take all the data, and the user data pointer given to
+ * sxs_wbuf_attach(). It would typically wait for SXS_POLLOUT on the
+ * socket and call sxs_wbuf_flush_nb() once it is writable, or close the
+ * connection on an error.
+ */
+typedef void (*sxs_wbuf_cb_t)(sxs_wbuf_t *p_wbuf, sxs_error_t err,
+    void *p_data);
+
+/**
+ * Create a write buffer.
+ *
+ * The sxs_wbuf_create() function creates a write buffer of 'size' bytes
+ * for the connected stream socket 'sd' and passes it back via
+ * 'pp_wbuf'. If 'size' is 0, SXS_WBUF_DEFAULT_SIZE is used. The write
+ * buffer does not take ownership of the socket.
+ * @param sd The socket descriptor of the socket to send on.
+ * @param size The size of the buffer in bytes, or 0 for the default.
+ * @param pp_wbuf Pointer to write buffer pointer to store the new write
+ * buffer in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the write buffer.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_wbuf_create(sxs_socket_t sd, sxs_size_t size,
+    sxs_wbuf_t **pp_wbuf);
+
+/**
+ * Destroy a write buffer.
+ *
+ * The sxs_wbuf_destroy() function releases all resources associated
+ * with the write buffer, detaching it from its loop. Buffered data is
+ * discarded, so the buffer should be flushed first. The socket is not
+ * closed.
+ * @param p_wbuf Pointer to the write buffer to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the write buffer.
+ */
+SXS_EXPORT sxs_error_t sxs_wbuf_destroy(sxs_wbuf_t *p_wbuf);
+
+/**
+ * Flush a write buffer at the end of each loop iteration.
+ *
+ * The sxs_wbuf_attach() function makes every write which leaves data in
+ * the buffer schedule a call to sxs_wbuf_flush_nb() at the end of the
+ * current iteration of 'p_loop', so the pieces written by the callbacks
+ * of one iteration are sent together. If that flush does not send
+ * everything, 'cb' is called when not NULL. Passing a NULL 'p_loop'
+ * detaches the buffer. The loop must outlive the attachment.
+ * @param p_wbuf Pointer to the write buffer.
+ * @param p_loop Pointer to the loop to flush in, or NULL to detach.
+ * @param cb The callback to call when a flush is left incomplete.
+ * @param p_data User data pointer passed to the callback.
+ */
+SXS_EXPORT void sxs_wbuf_attach(sxs_wbuf_t *p_wbuf, sxs_loop_t *p_loop,
+    sxs_wbuf_cb_t cb, void *p_data);
+
+/**
+ * Get the number of bytes waiting in a write buffer.
+ *
+ * The sxs_wbuf_pending() function returns the number of bytes written
+ * to the buffer which have not been sent yet.
+ * @param p_wbuf Pointer to the write buffer.
+ * @return The number of buffered bytes.
+ */
+SXS_EXPORT sxs_size_t sxs_wbuf_pending(const sxs_wbuf_t *p_wbuf);
+
+/**
+ * Write data through a write buffer.
+ *
+ * The sxs_wbuf_write() function copies 'len' bytes from 'buf' into the
+ * buffer. When they do not fit, the buffered data and 'buf' are sent
+ * together with a single vectored send, blocking until all of it was
+ * sent, so large writes are not copied.
+ * @param p_wbuf Pointer to the write buffer.
+ * @param buf The pointer to the data to write.
+ * @param len The number of bytes to write.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_sendv_nbytes().
+ * @retval SXS_SUCCESS Successfully buffered or sent the data.
+ */
+SXS_EXPORT sxs_error_t sxs_wbuf_write(sxs_wbuf_t *p_wbuf,
+    const sxs_buf_t buf, sxs_size_t len);
+
+/**
+ * Write data through a write buffer without blocking.
+ *
+ * The sxs_wbuf_write_nb() function behaves like sxs_wbuf_write() except
+ * that when the data does not fit, only as much as the socket accepts
+ * without blocking is sent and as much of the rest as fits is buffered.
+ * The number of bytes of 'buf' which were sent or buffered is passed
+ * back via 'p_written', and is less than 'len' only when the socket and
+ * the buffer are both full. The remainder should then be written again
+ * once the socket is writable.
+ * @param p_wbuf Pointer to the write buffer.
+ * @param buf The pointer to the data to write.
+ * @param len The number of bytes to write.
+ * @param p_written Pointer to var to store the number of bytes taken
+ * from 'buf' in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_sendv().
+ * @retval SXS_SUCCESS Successfully took some or all of the data.
+ */
+SXS_EXPORT sxs_error_t sxs_wbuf_write_nb(sxs_wbuf_t *p_wbuf,
+    const sxs_buf_t buf, sxs_size_t len, sxs_size_t *p_written);
+
+/**
+ * Send everything held by a write buffer.
+ *
+ * The sxs_wbuf_flush() function sends the buffered data, blocking until
+ * all of it was sent.
+ * @param p_wbuf Pointer to the write buffer to flush.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_send_nbytes().
+ * @retval SXS_SUCCESS Successfully sent all the buffered data.
+ */
+SXS_EXPORT sxs_error_t sxs_wbuf_flush(sxs_wbuf_t *p_wbuf);
+
+/**
+ * Send as much of a write buffer as possible without blocking.
+ *
+ * The sxs_wbuf_flush_nb() function sends the buffered data until the
+ * socket would block. Data which was not sent stays buffered, and a
+ * later flush resumes exactly where this one stopped.
+ * @param p_wbuf Pointer to the write buffer to flush.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_send().
+ * @retval SXS_SUCCESS Successfully sent all the buffered data.
+ * @retval SXS_EWOULDBLOCK The socket could not take all the data.
+ */
+SXS_EXPORT sxs_error_t sxs_wbuf_flush_nb(sxs_wbuf_t *p_wbuf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_WBUF_H */
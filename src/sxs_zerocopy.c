@@ -0,0 +1,248 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_zerocopy.c
+ * @brief This is an implementation file for the lib_sxs zero-copy API.
+ *
+ * The sxs_zerocopy.c file is an implementation file which contains all
+ * the definitions for the functions which compose the zero-copy
+ * transmit API of lib_sxs.
+ */
+
+#include "sxs_zerocopy.h"
+#include "sxs_poll.h"
+#include "sxs_internal.h"
+#include "sxs_config.h"
+
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+    #include <netinet/in.h>
+    #include <linux/errqueue.h>
+    #define SXS_ZEROCOPY 1
+#endif
+
+struct sxs_zc {
+    sxs_socket_t sd;
+    sxs_uint32_t next_id;   /* id of the next zero-copy send */
+    sxs_uint32_t num_done;  /* sends completed, wrapping like the ids */
+};
+
+#ifdef SXS_ZEROCOPY
+
+sxs_error_t sxs_zc_create(sxs_socket_t sd, sxs_zc_t **pp_zc) {
+    sxs_zc_t *p_zc;
+    int on;
+
+    on = 1;
+    if (setsockopt(sd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(int)) == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    p_zc = (sxs_zc_t *)malloc(sizeof(sxs_zc_t));
+    if (p_zc == NULL) {
+        return SXS_ENOMEM;
+    }
+
+    p_zc->sd = sd;
+    p_zc->next_id = 0;
+    p_zc->num_done = 0;
+
+    (*pp_zc) = p_zc;
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_zc_send(sxs_zc_t *p_zc, const sxs_buf_t buf,
+    sxs_size_t len, int flags, sxs_ssize_t *p_sent, sxs_uint32_t *p_id) {
+
+    sxs_ssize_t r;
+
+    /* The kernel does not number sends of nothing, so there would be no
+     * id to pass back. */
+    if (len == 0) {
+        return SXS_EINVAL;
+    }
+
+    r = send(p_zc->sd, buf, len, (flags | MSG_ZEROCOPY));
+    if (r == SXS_SOCKET_ERROR) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_id) = p_zc->next_id;
+    p_zc->next_id++;
+    (*p_sent) = r;
+
+    return SXS_SUCCESS;
+}
+
+/* Read one notice from the error queue, passing back whether it was a
+ * zero-copy completion. SXS_EWOULDBLOCK means the queue is empty. */
+static sxs_error_t sxs_zc_read_notice(sxs_zc_t *p_zc,
+    sxs_zc_range_t *p_range, int *p_is_zc) {
+
+    union {
+        char buf[CMSG_SPACE(sizeof(struct sock_extended_err) +
+            sizeof(struct sockaddr_in6))];
+        struct cmsghdr align;
+    } control;
+    struct sock_extended_err *p_serr;
+    struct cmsghdr *p_cmsg;
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    if (recvmsg(p_zc->sd, &msg, MSG_ERRQUEUE) == -1) {
+        return sxs_map_errno(errno);
+    }
+
+    (*p_is_zc) = 0;
+    for (p_cmsg = CMSG_FIRSTHDR(&msg); p_cmsg != NULL;
+        p_cmsg = CMSG_NXTHDR(&msg, p_cmsg)) {
+        if (!((p_cmsg->cmsg_level == SOL_IP) &&
+            (p_cmsg->cmsg_type == IP_RECVERR)) &&
+            !((p_cmsg->cmsg_level == SOL_IPV6) &&
+            (p_cmsg->cmsg_type == IPV6_RECVERR))) {
+            continue;
+        }
+
+        p_serr = (struct sock_extended_err *)CMSG_DATA(p_cmsg);
+        if ((p_serr->ee_errno != 0) ||
+            (p_serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)) {
+            continue;
+        }
+
+        p_range->lo = p_serr->ee_info;
+        p_range->hi = p_serr->ee_data;
+        p_range->copied = (p_serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED);
+        (*p_is_zc) = 1;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_zc_reap(sxs_zc_t *p_zc, const struct timeval *p_timeout,
+    sxs_zc_range_t *p_ranges, int max_ranges, int *p_num_ranges) {
+
+    sxs_error_t reterr;
+    int num_ranges;
+    int waited;
+    int revents;
+    int is_zc = 0;
+
+    num_ranges = 0;
+    waited = 0;
+
+    while (num_ranges < max_ranges) {
+        reterr = sxs_zc_read_notice(p_zc, &p_ranges[num_ranges], &is_zc);
+        if (reterr == SXS_SUCCESS) {
+            if (is_zc) {
+                p_zc->num_done += p_ranges[num_ranges].hi -
+                    p_ranges[num_ranges].lo + 1;
+                num_ranges++;
+            }
+            continue;
+        } else if (reterr != SXS_EWOULDBLOCK) {
+            if (num_ranges > 0) {
+                break;
+            }
+            return reterr;
+        }
+
+        /* The queue is empty, only wait if nothing was collected. */
+        if ((num_ranges > 0) || waited || ((p_timeout != NULL) &&
+            (p_timeout->tv_sec == 0) && (p_timeout->tv_usec == 0))) {
+            break;
+        }
+
+        /* A non-empty error queue is reported as an error condition. */
+        reterr = sxs_poll_one(p_zc->sd, SXS_POLLERR, p_timeout, &revents);
+        if (reterr != SXS_SUCCESS) {
+            sxs_perror("sxs_zc_reap: sxs_poll_one:", reterr);
+            return SXS_ERRSELECTFAIL;
+        }
+        if (revents == 0) {   /* reached the timeout */
+            break;
+        }
+        waited = 1;
+    }
+
+    (*p_num_ranges) = num_ranges;
+
+    return SXS_SUCCESS;
+}
+
+#else /* SXS_ZEROCOPY */
+
+/* Without zero-copy support the API exists so that applications link
+ * everywhere, but a handle can never be created. */
+
+sxs_error_t sxs_zc_create(sxs_socket_t sd, sxs_zc_t **pp_zc) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_zc_send(sxs_zc_t *p_zc, const sxs_buf_t buf,
+    sxs_size_t len, int flags, sxs_ssize_t *p_sent, sxs_uint32_t *p_id) {
+    return SXS_EOPNOTSUPP;
+}
+
+sxs_error_t sxs_zc_reap(sxs_zc_t *p_zc, const struct timeval *p_timeout,
+    sxs_zc_range_t *p_ranges, int max_ranges, int *p_num_ranges) {
+    return SXS_EOPNOTSUPP;
+}
+
+#endif /* SXS_ZEROCOPY */
+
+sxs_error_t sxs_zc_destroy(sxs_zc_t *p_zc) {
+    free(p_zc);
+
+    return SXS_SUCCESS;
+}
+
+sxs_error_t sxs_zc_send_nbytes(sxs_zc_t *p_zc, const sxs_buf_t buf,
+    sxs_size_t len, sxs_size_t *p_sent, sxs_uint32_t *p_first_id,
+    sxs_uint32_t *p_last_id) {
+
+    sxs_ssize_t tot_bytes_sent;
+    sxs_ssize_t bytes_sent = 0;
+    sxs_uint32_t id = 0;
+    sxs_error_t reterr;
+
+    tot_bytes_sent = 0;
+
+    /* Start from an empty range of ids so that what was issued is known
+     * however the loop ends. */
+    (*p_sent) = 0;
+    (*p_first_id) = p_zc->next_id;
+    (*p_last_id) = p_zc->next_id - 1;
+
+    while (tot_bytes_sent < len) {
+        reterr = sxs_zc_send(p_zc, ((char *)buf + tot_bytes_sent),
+            (len - tot_bytes_sent), 0, &bytes_sent, &id);
+        if (reterr != SXS_SUCCESS) {
+            return reterr;
+        }
+
+        tot_bytes_sent = tot_bytes_sent + bytes_sent;
+        (*p_sent) = tot_bytes_sent;
+        (*p_last_id) = id;
+    }
+
+    return SXS_SUCCESS;
+}
+
+sxs_uint32_t sxs_zc_pending(const sxs_zc_t *p_zc) {
+    return p_zc->next_id - p_zc->num_done;
+}
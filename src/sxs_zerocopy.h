@@ -0,0 +1,205 @@
+/*
+ * Copyright 2007 Andrew De Ponte
+ *
+ * This file is part of lib_sxs.
+ *
+ * lib_sxs is the intellectual property of Andrew De Ponte; any
+ * distribution and/or modifications and/or reproductions of any portion
+ * of lib_sxs MUST be approved by Andrew De Ponte.
+ *
+ * lib_sxs is dirstributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ */
+
+/**
+ * @file sxs_zerocopy.h
+ * @brief This is a specifications file for the lib_sxs zero-copy API.
+ *
+ * The sxs_zerocopy.h file is a specifications file that defines the
+ * functions which compose the zero-copy transmit API of lib_sxs. A
+ * zero-copy send lets the kernel transmit straight from the caller's
+ * buffer instead of copying it into the socket's send buffer, which
+ * pays off for sends of hundreds of kilobytes or more. In exchange the
+ * buffer stays in use by the kernel after the send returns, until the
+ * kernel posts a completion for the send on the socket's error queue.
+ *
+ * The buffer lifetime rules are:
+ * - Every successful sxs_zc_send() is given an id, consecutive per
+ *   handle starting at 0 and wrapping around after 2^32 sends.
+ * - The bytes passed to a send must neither be modified nor freed
+ *   until a range returned by sxs_zc_reap() includes its id. Modifying
+ *   them earlier may change the data sent on the wire.
+ * - Completions may be reported out of order and for several sends at
+ *   once, so a buffer spread over several sends is free once all of
+ *   their ids have been reaped, or once sxs_zc_pending() is 0.
+ * - Closing the socket does not free the buffers any earlier, the
+ *   kernel keeps them until the data is acknowledged or dropped.
+ *
+ * Zero-copy transmit is only available on Linux 4.14 or newer, for TCP,
+ * and for UDP from Linux 5.0.
+ */
+
+#ifndef SXS_ZEROCOPY_H
+#define SXS_ZEROCOPY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sxs.h"
+
+/**
+ * @typedef sxs_zc_t
+ * @brief An opaque zero-copy send handle.
+ *
+ * The sxs_zc_t type represents a socket in zero-copy send mode together
+ * with the count of sends made and completed through it.
+ */
+typedef struct sxs_zc sxs_zc_t;
+
+/**
+ * @typedef sxs_zc_range_t
+ * @brief A range of completed zero-copy sends.
+ *
+ * The sxs_zc_range_t type is a structure describing the sends with ids
+ * 'lo' to 'hi' inclusive, whose buffers the kernel no longer uses. If
+ * 'copied' is non-zero the kernel copied the data after all, as it does
+ * e.g. on the loopback interface, in which case zero-copy only added
+ * overhead and may be worth turning off for the socket.
+ */
+typedef struct sxs_zc_range {
+    sxs_uint32_t lo;
+    sxs_uint32_t hi;
+    int copied;
+} sxs_zc_range_t;
+
+/**
+ * Put a socket in zero-copy send mode.
+ *
+ * The sxs_zc_create() function enables zero-copy sends on the socket
+ * 'sd' and passes back via 'pp_zc' a handle through which they are made
+ * and their completions collected. The socket should be connected or
+ * bound, and plain sends may still be made on it.
+ * @param sd The socket descriptor of the socket.
+ * @param pp_zc Pointer to handle pointer to store the new handle in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully created the handle.
+ * @retval SXS_EOPNOTSUPP Zero-copy sends are not supported on this
+ * system or by this kind of socket.
+ * @retval SXS_ENOPROTOOPT Zero-copy sends are not supported by the
+ * kernel.
+ * @retval SXS_EBADF The argument 'sd' is not a valid descriptor.
+ * @retval SXS_ENOMEM Insufficient memory is available.
+ */
+SXS_EXPORT sxs_error_t sxs_zc_create(sxs_socket_t sd, sxs_zc_t **pp_zc);
+
+/**
+ * Destroy a zero-copy send handle.
+ *
+ * The sxs_zc_destroy() function releases the handle without closing its
+ * socket. Completions not reaped yet are lost, so the buffers of
+ * pending sends should only be freed once the socket has been closed
+ * and the peer acknowledged the data, or not at all.
+ * @param p_zc Pointer to the handle to destroy.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully destroyed the handle.
+ */
+SXS_EXPORT sxs_error_t sxs_zc_destroy(sxs_zc_t *p_zc);
+
+/**
+ * Send data without copying it.
+ *
+ * The sxs_zc_send() function behaves like sxs_send() except that the
+ * kernel transmits from 'buf' directly, and passes back via 'p_id' the
+ * id the send's completion will be reported under. 'buf' must be left
+ * untouched until then, see the buffer lifetime rules above. When too
+ * many sends are pending the send fails with SXS_ENOBUFS, and
+ * completions should be reaped before retrying. A send of 0 bytes
+ * would be given no id and is refused. All zero-copy sends on the
+ * socket must be made through the handle, as the kernel numbers them
+ * per socket.
+ * @param p_zc Pointer to the handle to send on.
+ * @param buf The pointer to the buffer containing data to send.
+ * @param len The number of bytes to attempt to send.
+ * @param flags One or more OR'd message flags controlling behavior,
+ * generally 0.
+ * @param p_sent Pointer to var to store resulting num of bytes sent.
+ * @param p_id Pointer to var to store the id of the send in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_send().
+ * @retval SXS_SUCCESS Successfully sent the data on the socket.
+ * @retval SXS_EINVAL 'len' is 0.
+ * @retval SXS_ENOBUFS Too many zero-copy sends are pending.
+ */
+SXS_EXPORT sxs_error_t sxs_zc_send(sxs_zc_t *p_zc, const sxs_buf_t buf,
+    sxs_size_t len, int flags, sxs_ssize_t *p_sent, sxs_uint32_t *p_id);
+
+/**
+ * Send a specified number of bytes without copying them.
+ *
+ * The sxs_zc_send_nbytes() function is the zero-copy counterpart of
+ * sxs_send_nbytes(). It calls sxs_zc_send() until all 'len' bytes of
+ * 'buf' have been sent and passes back the number of bytes sent and
+ * the ids of the first and last of these sends. These are passed back
+ * on failure as well, covering the sends made before it, as 'buf' may
+ * only be reused once every id from 'p_first_id' to 'p_last_id' has
+ * been reaped. When no send was made, e.g. if 'len' is 0, 'p_last_id'
+ * is one less than 'p_first_id', both wrapping like the ids.
+ * @param p_zc Pointer to the handle to send on.
+ * @param buf The pointer to the buffer containing the data to send.
+ * @param len The number of bytes to send.
+ * @param p_sent Pointer to var to store the num of bytes sent.
+ * @param p_first_id Pointer to var to store the id of the first send in.
+ * @param p_last_id Pointer to var to store the id of the last send in.
+ * @return A value representing an error or success. The possible
+ * errors are those of sxs_zc_send().
+ * @retval SXS_SUCCESS Successfully sent all the data on the socket.
+ */
+SXS_EXPORT sxs_error_t sxs_zc_send_nbytes(sxs_zc_t *p_zc,
+    const sxs_buf_t buf, sxs_size_t len, sxs_size_t *p_sent,
+    sxs_uint32_t *p_first_id, sxs_uint32_t *p_last_id);
+
+/**
+ * Collect the completions of zero-copy sends.
+ *
+ * The sxs_zc_reap() function reads up to 'max_ranges' completion notices
+ * from the error queue of the socket into the array 'p_ranges' and
+ * passes back their number via 'p_num_ranges'. If none is queued it
+ * waits for one for up to 'p_timeout', and passes back 0 ranges if the
+ * timeout is reached. A zero timeout makes it return at once, and a
+ * NULL timeout makes it block until a completion arrives, which never
+ * happens if no send is pending.
+ * @param p_zc Pointer to the handle to collect completions for.
+ * @param p_timeout Pointer to timeval struct containing the upper bound
+ * to use for waiting for a completion.
+ * @param p_ranges Pointer to the array to store the completions in.
+ * @param max_ranges The number of elements of the array.
+ * @param p_num_ranges Pointer to var to store the number of completions
+ * in.
+ * @return A value representing an error or success.
+ * @retval SXS_SUCCESS Successfully collected the queued completions.
+ * @retval SXS_ERRSELECTFAIL Failed to wait for a completion.
+ * @retval SXS_EBADF The socket descriptor is no longer valid.
+ * @retval SXS_EINTR A signal was caught.
+ */
+SXS_EXPORT sxs_error_t sxs_zc_reap(sxs_zc_t *p_zc,
+    const struct timeval *p_timeout, sxs_zc_range_t *p_ranges,
+    int max_ranges, int *p_num_ranges);
+
+/**
+ * Get the number of pending zero-copy sends.
+ *
+ * The sxs_zc_pending() function returns the number of sends made
+ * through the handle whose completions have not been reaped yet. Once
+ * it is 0 every buffer passed to the handle may be reused.
+ * @param p_zc Pointer to the handle.
+ * @return The number of pending sends.
+ */
+SXS_EXPORT sxs_uint32_t sxs_zc_pending(const sxs_zc_t *p_zc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SXS_ZEROCOPY_H */